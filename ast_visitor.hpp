@@ -0,0 +1,253 @@
+#ifndef AST_VISITOR_H
+#define AST_VISITOR_H
+
+#include "python_ast_node.hpp"
+#include <vector>
+
+// Calls f on every non-null child of a node, in source order
+template <class F>
+void forEachChild(const AstNode* node, F&& f) {
+    auto one = [&](const AstNode* child) {
+        if (child) {
+            f(child);
+        }
+    };
+    auto each = [&](const std::vector<AstNode*>& children) {
+        for (const AstNode* child : children) {
+            one(child);
+        }
+    };
+    switch (node->kind) {
+        case NodeKind::Function: {
+            const FunctionNode* n = static_cast<const FunctionNode*>(node);
+            one(n->getArgs());
+            one(n->getBody());
+            break;
+        }
+        case NodeKind::Arg:
+            each(static_cast<const Arg*>(node)->getNames());
+            break;
+        case NodeKind::Args:
+            each(static_cast<const Args*>(node)->getArgs());
+            break;
+        case NodeKind::FunctionCall:
+            each(static_cast<const FunctionCallNode*>(node)->getArguments());
+            break;
+        case NodeKind::While: {
+            const WhileStatementNode* n = static_cast<const WhileStatementNode*>(node);
+            one(n->getCondition());
+            one(n->getBody());
+            break;
+        }
+        case NodeKind::Comparison: {
+            const ComparisonNode* n = static_cast<const ComparisonNode*>(node);
+            one(n->getLeft());
+            one(n->getRight());
+            break;
+        }
+        case NodeKind::NegatedExpression:
+            one(static_cast<const NegatedExpressionNode*>(node)->getOperand());
+            break;
+        case NodeKind::Expression: {
+            const ExpressionNode* n = static_cast<const ExpressionNode*>(node);
+            one(n->getLeft());
+            one(n->getRight());
+            break;
+        }
+        case NodeKind::For: {
+            const ForStatementNode* n = static_cast<const ForStatementNode*>(node);
+            one(n->getHeader());
+            one(n->getChanges());
+            one(n->getBlock());
+            break;
+        }
+        case NodeKind::Changes:
+            one(static_cast<const ChangesNode*>(node)->getRange());
+            break;
+        case NodeKind::Try: {
+            const TryStatementNode* n = static_cast<const TryStatementNode*>(node);
+            one(n->getBlock());
+            one(n->getTryStmts());
+            break;
+        }
+        case NodeKind::TryStmts:
+            each(static_cast<const TryStmtsNode*>(node)->getTryStmts());
+            break;
+        case NodeKind::ExceptBlock:
+            one(static_cast<const ExceptBlockNode*>(node)->getBlock());
+            break;
+        case NodeKind::FinallyBlock:
+            one(static_cast<const FinallyBlockNode*>(node)->getBlock());
+            break;
+        case NodeKind::Decorators: {
+            const DecoratorsNode* n = static_cast<const DecoratorsNode*>(node);
+            one(n->getNamedExpression());
+            each(n->getDecorators());
+            break;
+        }
+        case NodeKind::ClassDef: {
+            const ClassDefNode* n = static_cast<const ClassDefNode*>(node);
+            one(n->getDecorators());
+            one(n->getClassDefRaw());
+            break;
+        }
+        case NodeKind::ClassDefRaw:
+            one(static_cast<const ClassDefRawNode*>(node)->getBlock());
+            break;
+        case NodeKind::NamedExpression:
+            one(static_cast<const NamedExpressionNode*>(node)->getExpression());
+            break;
+        case NodeKind::With: {
+            const WithStmtNode* n = static_cast<const WithStmtNode*>(node);
+            each(n->getWithItems());
+            one(n->getBlock());
+            break;
+        }
+        case NodeKind::WithItems:
+            each(static_cast<const WithItemsNode*>(node)->getWithItemLists());
+            break;
+        case NodeKind::WithItemList:
+            each(static_cast<const WithItemList*>(node)->getWithItems());
+            break;
+        case NodeKind::Arguments:
+            each(static_cast<const ArgumentsNode*>(node)->getArguments());
+            break;
+        case NodeKind::Argument:
+            one(static_cast<const ArgumentNode*>(node)->getExpression());
+            break;
+        case NodeKind::Yield:
+            one(static_cast<const YieldStmtNode*>(node)->getExpression());
+            break;
+        case NodeKind::YieldExpr:
+            one(static_cast<const YieldExprNode*>(node)->getExpression());
+            break;
+        case NodeKind::If: {
+            const IfStatementNode* n = static_cast<const IfStatementNode*>(node);
+            one(n->getHeader());
+            one(n->getBlock());
+            one(n->getElifElse());
+            break;
+        }
+        case NodeKind::IfHeader:
+            one(static_cast<const IfHeaderNode*>(node)->getExpression());
+            break;
+        case NodeKind::ElifElse: {
+            const ElifElseNode* n = static_cast<const ElifElseNode*>(node);
+            each(n->getElifStmts());
+            one(n->getElseStmt());
+            break;
+        }
+        case NodeKind::ElifStmts:
+            each(static_cast<const ElifStmtsNode*>(node)->getElifStmts());
+            break;
+        case NodeKind::Elif: {
+            const ElifStmtNode* n = static_cast<const ElifStmtNode*>(node);
+            one(n->getHeader());
+            one(n->getBlock());
+            break;
+        }
+        case NodeKind::ElifHeader:
+            one(static_cast<const ElifHeaderNode*>(node)->getExpression());
+            break;
+        case NodeKind::Else:
+            one(static_cast<const ElseStmtNode*>(node)->getBlock());
+            break;
+        case NodeKind::Match: {
+            const MatchStmtNode* n = static_cast<const MatchStmtNode*>(node);
+            one(n->getExpression());
+            one(n->getMatchCases());
+            break;
+        }
+        case NodeKind::MatchCases:
+            each(static_cast<const MatchCasesNode*>(node)->getMatchCases());
+            break;
+        case NodeKind::MatchCase: {
+            const MatchCaseNode* n = static_cast<const MatchCaseNode*>(node);
+            one(n->getPatternList());
+            one(n->getSimpleStmt());
+            break;
+        }
+        case NodeKind::PatternList:
+            each(static_cast<const PatternListNode*>(node)->getPatterns());
+            break;
+        case NodeKind::Pattern:
+            one(static_cast<const PatternNode*>(node)->getExpression());
+            break;
+        case NodeKind::ListPattern:
+            one(static_cast<const ListPatternNode*>(node)->getPatternList());
+            break;
+        case NodeKind::DictPattern:
+            one(static_cast<const DictPatternNode*>(node)->getEntries());
+            break;
+        case NodeKind::DictPatternEntries:
+            each(static_cast<const DictPatternEntriesNode*>(node)->getEntries());
+            break;
+        case NodeKind::DictPatternEntry: {
+            const DictPatternEntryNode* n = static_cast<const DictPatternEntryNode*>(node);
+            one(n->getKey());
+            one(n->getValue());
+            break;
+        }
+        case NodeKind::Block:
+            each(static_cast<const BlockNode*>(node)->getStatements());
+            break;
+        case NodeKind::Statements:
+            each(static_cast<const StatementsNode*>(node)->getStatements());
+            break;
+        case NodeKind::Assignment: {
+            const assignmentStatement* n = static_cast<const assignmentStatement*>(node);
+            one(n->getTarget());
+            one(n->getValue());
+            break;
+        }
+        case NodeKind::BinaryExpression: {
+            const BinaryExpressionNode* n = static_cast<const BinaryExpressionNode*>(node);
+            one(n->getLeft());
+            one(n->getRight());
+            break;
+        }
+        case NodeKind::Return:
+            one(static_cast<const ReturnStatementNode*>(node)->getReturnValue());
+            break;
+        default:
+            break;      // leaves
+    }
+}
+
+// Statically dispatched traversal. A pass derives from AstVisitor<Pass>
+// (CRTP) and defines visitX(const XNode*) for the kinds it handles, X being
+// the NodeKind name: visitWhile(const WhileStatementNode*),
+// visitFunctionCall(const FunctionCallNode*) and so on. dispatch() switches
+// on AstNode::kind and calls the pass's function directly, where the
+// compiler can inline it, instead of through a virtual call or a chain of
+// dynamic_casts. Kinds the pass leaves out go to visitNode(), which by
+// default dispatches each child in turn and drops their results.
+template <class Derived, class Result = void>
+class AstVisitor {
+public:
+    Result dispatch(const AstNode* node) {
+        switch (node->kind) {
+#define X(kind, type)                                                      \
+            case NodeKind::kind:                                           \
+                return derived().visit##kind(static_cast<const type*>(node));
+            PYTHON_AST_NODES(X)
+#undef X
+        }
+        return derived().visitNode(node);
+    }
+
+#define X(kind, type) \
+    Result visit##kind(const type* node) { return derived().visitNode(node); }
+    PYTHON_AST_NODES(X)
+#undef X
+
+    Result visitNode(const AstNode* node) {
+        forEachChild(node, [this](const AstNode* child) { dispatch(child); });
+        return Result();
+    }
+
+private:
+    Derived& derived() { return static_cast<Derived&>(*this); }
+};
+
+#endif
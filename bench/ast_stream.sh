@@ -0,0 +1,85 @@
+#!/bin/bash
+# Reads back the tree of each bench/*.py as `--ast-format json` and
+# `--ast-format binary` write it to stdout (tree_writer.hpp), and checks
+# that a reader can parse the whole stream: every JSON line is a record,
+# the binary stream starts with its magic, both hold the same nodes in the
+# same order, children come before their parent, inside its byte span, and
+# the root is last. Run from the repository root after ./build.sh.
+status=0
+
+for script in bench/*.py; do
+    if ! ./compiler --ast-format json "$script" > bench/ast_stream.ndjson 2> /dev/null \
+        || ! ./compiler --ast-format binary "$script" > bench/ast_stream.bin 2> /dev/null; then
+        echo "$(basename "$script" .py): does not compile"
+        status=1
+        continue
+    fi
+    python3 - "$(basename "$script" .py)" bench/ast_stream.ndjson bench/ast_stream.bin <<'PY' || status=1
+import json, sys
+
+name, json_path, binary_path = sys.argv[1:]
+
+def fail(message):
+    print(f"{name}: {message}")
+    sys.exit(1)
+
+records = []
+with open(json_path) as f:
+    for number, line in enumerate(f, 1):
+        try:
+            records.append(json.loads(line))
+        except ValueError:
+            fail(f"JSON line {number} is not a record: {line[:60]!r}")
+
+data = open(binary_path, "rb").read()
+if not data.startswith(b"PYAST\x02"):
+    fail(f"binary stream starts with {data[:6]!r}, not the PYAST magic")
+pos = 6
+
+def varint():
+    global pos
+    value = shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7f) << shift
+        shift += 7
+        if byte < 0x80:
+            return value
+
+kinds = []
+for _ in range(varint()):
+    length = varint()
+    kinds.append(data[pos:pos + length].decode())
+    pos += length
+nodes = []
+while pos < len(data):
+    length = varint()
+    end = pos + length
+    kind = kinds[data[pos]]
+    pos += 1
+    start = varint()
+    span = [start, start + varint()]
+    first = varint()
+    lines = [first, first + varint()]
+    children = [len(nodes) - varint() for _ in range(varint())]
+    nodes.append((kind, span, lines, children))
+    pos = end
+
+if len(nodes) != len(records):
+    fail(f"{len(records)} JSON records but {len(nodes)} binary ones")
+for i, (record, node) in enumerate(zip(records, nodes)):
+    if record["id"] != i or (record["kind"], record["span"], record["lines"], record["children"]) != node:
+        fail(f"record {i} differs: {record} against {node}")
+    if any(child >= i for child in record["children"]):
+        fail(f"record {i} names a child written after it")
+    start, end = record["span"]
+    if any(records[c]["span"][0] < start or records[c]["span"][1] > end for c in record["children"]):
+        fail(f"record {i}'s span does not cover its children's")
+if records and any(len(records) - 1 in r["children"] for r in records):
+    fail("the last record is not the root")
+print(f"{name}: {len(records)} records, JSON and binary read back")
+PY
+done
+rm -f bench/ast_stream.ndjson bench/ast_stream.bin
+exit $status
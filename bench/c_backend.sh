@@ -0,0 +1,17 @@
+#!/bin/bash
+# Times each bench/*.py under the Python interpreter and as a native binary
+# built from `compiler --emit-c`. Run from the repository root after ./build.sh.
+PYTHON=${PYTHON:-python3}
+CFLAGS=${CFLAGS:--O2}
+TIMEFORMAT=%R
+
+for script in bench/fib.py bench/sum_squares.py bench/harmonic.py; do
+    name=$(basename "$script" .py)
+    ./compiler --emit-c "bench/$name.c" "$script" > /dev/null || exit 1
+    gcc $CFLAGS -I. -o "bench/$name" "bench/$name.c" pyrt.c || exit 1
+
+    interp=$( { time "$PYTHON" "$script" > /dev/null; } 2>&1 )
+    native=$( { time "./bench/$name" > /dev/null; } 2>&1 )
+    speedup=$(awk -v a="$interp" -v b="$native" 'BEGIN { printf "%.1f", (b > 0) ? a / b : 0 }')
+    printf "%-12s interpreter %6ss   native %6ss   speedup %sx\n" "$name" "$interp" "$native" "$speedup"
+done
@@ -0,0 +1,13 @@
+#!/bin/bash
+# Runs the allocation-heavy bench/gc_alloc.py and bench/gc_generators.py,
+# which allocates only generators, under `compiler --run` and prints the
+# collector's throughput and pause report. Run from the repository root
+# after ./build.sh.
+TIMEFORMAT=%R
+
+for script in gc_alloc gc_generators; do
+    elapsed=$( { time ./compiler --run --gc-stats --jit-threshold 0 bench/$script.py 2> bench/gc.log > /dev/null; } 2>&1 )
+    printf "%-14s %ss\n" "$script" "$elapsed"
+    grep '^gc:' bench/gc.log
+done
+rm -f bench/gc.log
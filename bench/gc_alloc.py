@@ -0,0 +1,13 @@
+base = 100000 * 100000 * 100000
+
+def churn(n):
+    x = base + n
+    y = x * 2
+    return y - base - base
+
+total = 0
+keep = 0
+for i in range(3000000):
+    total = total + churn(i)
+    keep = base + i
+print(total, keep - base)
@@ -0,0 +1,13 @@
+# A million short-lived generators over small ints. Generators are
+# allocated straight into the old generation and nothing goes through the
+# nursery, so only those allocations can start a major collection;
+# bench/gc.sh reports how large the old generation is at the end.
+def one(n):
+    yield n
+
+total = 0
+for i in range(1000000):
+    g = one(i)
+    for v in g:
+        total = total + v
+print(total)
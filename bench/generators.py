@@ -0,0 +1,21 @@
+# A pipeline of 10 generators: a source and nine stages that each add one,
+# passing a million items to the loop at the end. bench/generators.sh times
+# it under `compiler --run` and python3.
+def source(n):
+    i = 0
+    while i < n:
+        yield i
+        i = i + 1
+
+def stage(src):
+    for x in src:
+        yield x + 1
+
+g = source(1000000)
+for k in range(9):
+    g = stage(g)
+
+total = 0
+for v in g:
+    total = total + v
+print(total)
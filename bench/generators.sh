@@ -0,0 +1,8 @@
+#!/bin/bash
+# Times the 10-generator pipeline in bench/generators.py under `compiler
+# --run` and under python3. Run from the repository root after ./build.sh.
+TIMEFORMAT=%R
+
+run=$( { time ./compiler --run bench/generators.py > /dev/null; } 2>&1 )
+python=$( { time python3 bench/generators.py > /dev/null; } 2>&1 )
+printf "generators   compiler --run %6ss   python3 %6ss\n" "$run" "$python"
@@ -0,0 +1,4 @@
+x = 0
+for i in range(1, 10000000):
+    x = x + 1 / i
+print(x)
@@ -0,0 +1,28 @@
+#!/bin/bash
+# Expression sharing under `compiler --hash-cons` (hash_cons.hpp): on each
+# bench/*.py and on a generated module of DEFS defs that repeat the same
+# names, constants and comparisons, as generated code does, prints the
+# dedup ratio and bytes saved, then the peak resident memory of printing
+# the generated module's tree without and with sharing.
+# Run from the repository root after ./build.sh.
+DEFS=${DEFS:-20000}
+
+python3 - "$DEFS" > bench/consed_module.py <<'PY'
+import sys
+for i in range(int(sys.argv[1])):
+    print(f"def handler{i}(state, event):")
+    print(f"    if state == {i % 8}:")
+    print(f"        return state + event * 2 - 1")
+    print(f"    while event < 100:")
+    print(f"        event = event + state * 2")
+    print(f"    return event - state * 2")
+PY
+
+for script in bench/*.py; do
+    ./compiler --hash-cons --ast-out /dev/null "$script" 2>&1 > /dev/null | grep '^hash-cons:'
+done
+for flag in "" --hash-cons; do
+    /usr/bin/time -f "${flag:-unshared}: peak RSS %M KiB, %e s" \
+        ./compiler $flag --ast-out /dev/null bench/consed_module.py 2>&1 > /dev/null | grep 'peak RSS'
+done
+rm -f bench/consed_module.py
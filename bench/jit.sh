@@ -0,0 +1,14 @@
+#!/bin/bash
+# Times each bench/*.py under `compiler --run` with the JIT off and on, then
+# prints the per-function JIT report. Run from the repository root after ./build.sh.
+THRESHOLD=${THRESHOLD:-1000}
+TIMEFORMAT=%R
+
+for script in bench/fib.py bench/sum_squares.py bench/harmonic.py; do
+    name=$(basename "$script" .py)
+    interp=$( { time ./compiler --run --jit-threshold 0 "$script" > /dev/null; } 2>&1 )
+    jit=$( { time ./compiler --run --jit-threshold "$THRESHOLD" "$script" > /dev/null; } 2>&1 )
+    speedup=$(awk -v a="$interp" -v b="$jit" 'BEGIN { printf "%.1f", (b > 0) ? a / b : 0 }')
+    printf "%-12s interpreted %6ss   jit %6ss   speedup %sx\n" "$name" "$interp" "$jit" "$speedup"
+    ./compiler --run --jit-stats --jit-threshold "$THRESHOLD" "$script" 2>&1 > /dev/null | grep '^jit:'
+done
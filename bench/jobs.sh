@@ -0,0 +1,27 @@
+#!/bin/bash
+# Times `compiler --emit-c` on a generated module of DEFS functions with
+# --jobs 1 and with one worker per core, and checks both write the same C.
+# Run from the repository root after ./build.sh.
+DEFS=${DEFS:-4000}
+JOBS=${JOBS:-$(nproc)}
+TIMEFORMAT=%R
+
+python3 - "$DEFS" > bench/many_defs.py <<'PY'
+import sys
+for i in range(int(sys.argv[1])):
+    print(f"def f{i}(a):")
+    print("    t = 0")
+    for k in range(1 + i * 7 % 5):
+        print(f"    for i in range({10 * (k + 1)}):")
+        print("        t = t + a * i")
+        print("    while t > a * 100:")
+        print("        t = t - a")
+    print("    return t")
+print(f"print(f{int(sys.argv[1]) - 1}(3))")
+PY
+
+serial=$( { time ./compiler --jobs 1 --emit-c bench/many_defs_1.c bench/many_defs.py > /dev/null; } 2>&1 )
+parallel=$( { time ./compiler --jobs "$JOBS" --emit-c bench/many_defs_n.c bench/many_defs.py > /dev/null; } 2>&1 )
+speedup=$(awk -v a="$serial" -v b="$parallel" 'BEGIN { printf "%.1f", (b > 0) ? a / b : 0 }')
+printf "%-12s --jobs 1 %6ss   --jobs %s %6ss   speedup %sx\n" "$DEFS defs" "$serial" "$JOBS" "$parallel" "$speedup"
+cmp -s bench/many_defs_1.c bench/many_defs_n.c || echo "output differs between --jobs 1 and --jobs $JOBS"
@@ -0,0 +1,39 @@
+#!/bin/bash
+# Compiles a generated module of SIZE bytes (default 4 GiB + 1 MiB), past
+# what the in-memory scanner takes, and one of SIZE / 16 under
+# --large-input (source_map.hpp). Both are comment lines with a def every
+# 16 MiB, so the tree stays small, and end in a syntax error: the
+# diagnostic must give the line and column the script expects, and the
+# peak resident memory of the two runs should be about the same. Needs SIZE
+# bytes free in bench/. Run from the repository root after ./build.sh.
+SIZE=${SIZE:-$(( (4 << 30) + (1 << 20) ))}
+
+generate() {
+    python3 - "$1" > bench/large_module.py <<'PY'
+import sys
+size = int(sys.argv[1])
+comment = "# " + "x" * 61 + "\n"
+block = comment * (16 * 1024 * 1024 // len(comment))
+out = sys.stdout
+written = lines = 0
+i = 0
+while written + len(block) < size:
+    out.write(block)
+    written += len(block)
+    lines += block.count("\n")
+    code = f"def f{i}(a):\n    return a + {i}\n"
+    out.write(code)
+    written += len(code)
+    lines += 2
+    i += 1
+out.write("x = = 1\n")
+print(f"expected: bench/large_module.py:{lines + 1}:5 (byte {written + 4})", file=sys.stderr)
+PY
+}
+
+for size in $(( SIZE / 16 )) "$SIZE"; do
+    generate "$size"
+    echo "$(stat -c %s bench/large_module.py) bytes"
+    /usr/bin/time -f "peak RSS %M KiB, %e s" ./compiler --large-input bench/large_module.py 2>&1 > /dev/null
+done
+rm -f bench/large_module.py
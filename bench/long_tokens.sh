@@ -0,0 +1,38 @@
+#!/bin/bash
+# Scans a generated module whose string literal, comment and column-0
+# identifier are each SIZE bytes (default 2 MiB), past flex's 1 MiB buffer,
+# from memory and streamed with --large-input. The identifier closes an
+# indented block, the case the column-0 rule handles. Each run must
+# compile, and the listing must give the string and identifier whole.
+# Run from the repository root after ./build.sh.
+SIZE=${SIZE:-$(( 2 << 20 ))}
+status=0
+
+python3 - "$SIZE" > bench/long_tokens.py <<'PY'
+import sys
+size = int(sys.argv[1])
+print("def f(a):")
+print("    return a")
+print("x" * size + " = 1")
+print('with open("' + "s" * size + '") as f:')
+print("    pass")
+print("# " + "c" * size)
+print("y = 2")
+PY
+
+lengths=$(./compiler --tokens bench/long_tokens.py | awk -F '\t' '$2 == "STRING" || length($3) > 1000 { print $2, length($3) }')
+echo "$lengths"
+if ! echo "$lengths" | grep -qx "STRING $SIZE" || ! echo "$lengths" | grep -qx "IDENTIFIER $SIZE"; then
+    echo "long_tokens: expected a STRING and an IDENTIFIER of $SIZE bytes"
+    status=1
+fi
+for mode in "" --large-input; do
+    if ./compiler $mode --ast-format json bench/long_tokens.py > /dev/null 2> bench/long_tokens.log; then
+        echo "${mode:-in memory}: compiled"
+    else
+        echo "${mode:-in memory}: failed: $(head -c 200 bench/long_tokens.log)"
+        status=1
+    fi
+done
+rm -f bench/long_tokens.py bench/long_tokens.log
+exit $status
@@ -0,0 +1,411 @@
+# 200-case match over int literals, dispatched 1M times. bench/match.sh
+# times it with the decision tree and with --match-linear.
+total = 0
+misses = 0
+for i in range(5000):
+    for j in range(201):
+        match j * 7:
+            case 0:
+                total = total + 0
+            case 7:
+                total = total + 1
+            case 14:
+                total = total + 2
+            case 21:
+                total = total + 3
+            case 28:
+                total = total + 4
+            case 35:
+                total = total + 5
+            case 42:
+                total = total + 6
+            case 49:
+                total = total + 7
+            case 56:
+                total = total + 8
+            case 63:
+                total = total + 9
+            case 70:
+                total = total + 10
+            case 77:
+                total = total + 11
+            case 84:
+                total = total + 12
+            case 91:
+                total = total + 13
+            case 98:
+                total = total + 14
+            case 105:
+                total = total + 15
+            case 112:
+                total = total + 16
+            case 119:
+                total = total + 17
+            case 126:
+                total = total + 18
+            case 133:
+                total = total + 19
+            case 140:
+                total = total + 20
+            case 147:
+                total = total + 21
+            case 154:
+                total = total + 22
+            case 161:
+                total = total + 23
+            case 168:
+                total = total + 24
+            case 175:
+                total = total + 25
+            case 182:
+                total = total + 26
+            case 189:
+                total = total + 27
+            case 196:
+                total = total + 28
+            case 203:
+                total = total + 29
+            case 210:
+                total = total + 30
+            case 217:
+                total = total + 31
+            case 224:
+                total = total + 32
+            case 231:
+                total = total + 33
+            case 238:
+                total = total + 34
+            case 245:
+                total = total + 35
+            case 252:
+                total = total + 36
+            case 259:
+                total = total + 37
+            case 266:
+                total = total + 38
+            case 273:
+                total = total + 39
+            case 280:
+                total = total + 40
+            case 287:
+                total = total + 41
+            case 294:
+                total = total + 42
+            case 301:
+                total = total + 43
+            case 308:
+                total = total + 44
+            case 315:
+                total = total + 45
+            case 322:
+                total = total + 46
+            case 329:
+                total = total + 47
+            case 336:
+                total = total + 48
+            case 343:
+                total = total + 49
+            case 350:
+                total = total + 50
+            case 357:
+                total = total + 51
+            case 364:
+                total = total + 52
+            case 371:
+                total = total + 53
+            case 378:
+                total = total + 54
+            case 385:
+                total = total + 55
+            case 392:
+                total = total + 56
+            case 399:
+                total = total + 57
+            case 406:
+                total = total + 58
+            case 413:
+                total = total + 59
+            case 420:
+                total = total + 60
+            case 427:
+                total = total + 61
+            case 434:
+                total = total + 62
+            case 441:
+                total = total + 63
+            case 448:
+                total = total + 64
+            case 455:
+                total = total + 65
+            case 462:
+                total = total + 66
+            case 469:
+                total = total + 67
+            case 476:
+                total = total + 68
+            case 483:
+                total = total + 69
+            case 490:
+                total = total + 70
+            case 497:
+                total = total + 71
+            case 504:
+                total = total + 72
+            case 511:
+                total = total + 73
+            case 518:
+                total = total + 74
+            case 525:
+                total = total + 75
+            case 532:
+                total = total + 76
+            case 539:
+                total = total + 77
+            case 546:
+                total = total + 78
+            case 553:
+                total = total + 79
+            case 560:
+                total = total + 80
+            case 567:
+                total = total + 81
+            case 574:
+                total = total + 82
+            case 581:
+                total = total + 83
+            case 588:
+                total = total + 84
+            case 595:
+                total = total + 85
+            case 602:
+                total = total + 86
+            case 609:
+                total = total + 87
+            case 616:
+                total = total + 88
+            case 623:
+                total = total + 89
+            case 630:
+                total = total + 90
+            case 637:
+                total = total + 91
+            case 644:
+                total = total + 92
+            case 651:
+                total = total + 93
+            case 658:
+                total = total + 94
+            case 665:
+                total = total + 95
+            case 672:
+                total = total + 96
+            case 679:
+                total = total + 97
+            case 686:
+                total = total + 98
+            case 693:
+                total = total + 99
+            case 700:
+                total = total + 100
+            case 707:
+                total = total + 101
+            case 714:
+                total = total + 102
+            case 721:
+                total = total + 103
+            case 728:
+                total = total + 104
+            case 735:
+                total = total + 105
+            case 742:
+                total = total + 106
+            case 749:
+                total = total + 107
+            case 756:
+                total = total + 108
+            case 763:
+                total = total + 109
+            case 770:
+                total = total + 110
+            case 777:
+                total = total + 111
+            case 784:
+                total = total + 112
+            case 791:
+                total = total + 113
+            case 798:
+                total = total + 114
+            case 805:
+                total = total + 115
+            case 812:
+                total = total + 116
+            case 819:
+                total = total + 117
+            case 826:
+                total = total + 118
+            case 833:
+                total = total + 119
+            case 840:
+                total = total + 120
+            case 847:
+                total = total + 121
+            case 854:
+                total = total + 122
+            case 861:
+                total = total + 123
+            case 868:
+                total = total + 124
+            case 875:
+                total = total + 125
+            case 882:
+                total = total + 126
+            case 889:
+                total = total + 127
+            case 896:
+                total = total + 128
+            case 903:
+                total = total + 129
+            case 910:
+                total = total + 130
+            case 917:
+                total = total + 131
+            case 924:
+                total = total + 132
+            case 931:
+                total = total + 133
+            case 938:
+                total = total + 134
+            case 945:
+                total = total + 135
+            case 952:
+                total = total + 136
+            case 959:
+                total = total + 137
+            case 966:
+                total = total + 138
+            case 973:
+                total = total + 139
+            case 980:
+                total = total + 140
+            case 987:
+                total = total + 141
+            case 994:
+                total = total + 142
+            case 1001:
+                total = total + 143
+            case 1008:
+                total = total + 144
+            case 1015:
+                total = total + 145
+            case 1022:
+                total = total + 146
+            case 1029:
+                total = total + 147
+            case 1036:
+                total = total + 148
+            case 1043:
+                total = total + 149
+            case 1050:
+                total = total + 150
+            case 1057:
+                total = total + 151
+            case 1064:
+                total = total + 152
+            case 1071:
+                total = total + 153
+            case 1078:
+                total = total + 154
+            case 1085:
+                total = total + 155
+            case 1092:
+                total = total + 156
+            case 1099:
+                total = total + 157
+            case 1106:
+                total = total + 158
+            case 1113:
+                total = total + 159
+            case 1120:
+                total = total + 160
+            case 1127:
+                total = total + 161
+            case 1134:
+                total = total + 162
+            case 1141:
+                total = total + 163
+            case 1148:
+                total = total + 164
+            case 1155:
+                total = total + 165
+            case 1162:
+                total = total + 166
+            case 1169:
+                total = total + 167
+            case 1176:
+                total = total + 168
+            case 1183:
+                total = total + 169
+            case 1190:
+                total = total + 170
+            case 1197:
+                total = total + 171
+            case 1204:
+                total = total + 172
+            case 1211:
+                total = total + 173
+            case 1218:
+                total = total + 174
+            case 1225:
+                total = total + 175
+            case 1232:
+                total = total + 176
+            case 1239:
+                total = total + 177
+            case 1246:
+                total = total + 178
+            case 1253:
+                total = total + 179
+            case 1260:
+                total = total + 180
+            case 1267:
+                total = total + 181
+            case 1274:
+                total = total + 182
+            case 1281:
+                total = total + 183
+            case 1288:
+                total = total + 184
+            case 1295:
+                total = total + 185
+            case 1302:
+                total = total + 186
+            case 1309:
+                total = total + 187
+            case 1316:
+                total = total + 188
+            case 1323:
+                total = total + 189
+            case 1330:
+                total = total + 190
+            case 1337:
+                total = total + 191
+            case 1344:
+                total = total + 192
+            case 1351:
+                total = total + 193
+            case 1358:
+                total = total + 194
+            case 1365:
+                total = total + 195
+            case 1372:
+                total = total + 196
+            case 1379:
+                total = total + 197
+            case 1386:
+                total = total + 198
+            case 1393:
+                total = total + 199
+            case _:
+                misses = misses + 1
+print(total)
+print(misses)
@@ -0,0 +1,19 @@
+#!/bin/bash
+# Times the 200-case match in bench/match.py under `compiler --run` with
+# cases tested one after another (--match-linear) and through the compiled
+# decision tree, after checking that both match the number patterns in
+# bench/match_numbers.py as python3 does. Run from the repository root
+# after ./build.sh.
+TIMEFORMAT=%R
+
+expected=$(python3 bench/match_numbers.py)
+for mode in --match-linear ""; do
+    if [ "$(./compiler --run $mode bench/match_numbers.py 2> /dev/null | grep -E '^-?[0-9]+$')" != "$expected" ]; then
+        echo "match_numbers: ${mode:-decision tree} differs from python3"
+    fi
+done
+
+linear=$( { time ./compiler --run --jit-threshold 0 --match-linear bench/match.py > /dev/null; } 2>&1 )
+tree=$( { time ./compiler --run --jit-threshold 0 bench/match.py > /dev/null; } 2>&1 )
+speedup=$(awk -v a="$linear" -v b="$tree" 'BEGIN { printf "%.1f", (b > 0) ? a / b : 0 }')
+printf "match        linear %6ss   decision tree %6ss   speedup %sx\n" "$linear" "$tree" "$speedup"
@@ -0,0 +1,29 @@
+# Number patterns compare with ==, as in Python: `case 2.0:` takes 2 and
+# `case 0.0:` takes -0.0 and False. bench/match.sh checks that the decision
+# tree and --match-linear both print what python3 prints.
+def check(x):
+    match x:
+        case 2.0:
+            return 1
+        case 0.0:
+            return 2
+        case 2.5:
+            return 3
+        case 7:
+            return 4
+        case 1:
+            return 5
+        case _:
+            return 0
+    return 0
+
+print(check(2))
+print(check(2.0))
+print(check(-0.0))
+print(check(0))
+print(check(False))
+print(check(True))
+print(check(2.5))
+print(check(1.5 + 1))
+print(check(7.0))
+print(check(3))
@@ -0,0 +1,27 @@
+#!/bin/bash
+# Heap growth of a resident `compiler --serve` over many requests: sends
+# each script in bench/ REQUESTS times with --mem-audit and prints the
+# audit of the first request and of the last. Past the first requests no
+# nodes should be outstanding and the heap should no longer grow.
+# Run from the repository root after ./build.sh.
+REQUESTS=${REQUESTS:-200}
+SOCKET=${SOCKET:-/tmp/compiler-mem.sock}
+
+./compiler --serve "$SOCKET" 2> /dev/null &
+for _ in $(seq 50); do
+    [ -S "$SOCKET" ] && break
+    sleep 0.1
+done
+
+for script in bench/*.py; do
+    echo "$(basename "$script" .py)"
+    for i in $(seq "$REQUESTS"); do
+        audit=$(./pyclient "$SOCKET" --mem-audit --ast-out /dev/null "$script" 2>&1 > /dev/null | grep '^mem:')
+        if [ "$i" -eq 1 ] || [ "$i" -eq "$REQUESTS" ]; then
+            echo "  request $i"
+            echo "$audit" | sed 's/^/    /'
+        fi
+    done
+done
+
+./pyclient "$SOCKET" --stop > /dev/null
@@ -0,0 +1,31 @@
+#!/bin/bash
+# Times `compiler` on a generated module of LINES lines, lexed serially and
+# with --parallel-lex on one process per core, and checks both print the
+# same tree. Run from the repository root after ./build.sh.
+LINES=${LINES:-400000}
+JOBS=${JOBS:-$(nproc)}
+TIMEFORMAT=%R
+
+python3 - "$LINES" > bench/big_module.py <<'PY'
+import sys
+n = 0
+i = 0
+while n < int(sys.argv[1]):
+    print(f"def f{i}(a):")
+    print('    """')
+    print(f"x{i} = not code")
+    print('    """')
+    print(f"    t = a + {i}")
+    print("    return t")
+    print(f"g{i} = f{i}({i})")
+    n += 7
+    i += 1
+PY
+
+serial=$( { time ./compiler bench/big_module.py > bench/big_module_1.txt; } 2>&1 )
+parallel=$( { time ./compiler --parallel-lex --jobs "$JOBS" bench/big_module.py > bench/big_module_n.txt 2> /dev/null; } 2>&1 )
+speedup=$(awk -v a="$serial" -v b="$parallel" 'BEGIN { printf "%.1f", (b > 0) ? a / b : 0 }')
+printf "%-14s serial %6ss   --parallel-lex --jobs %s %6ss   speedup %sx\n" "$LINES lines" "$serial" "$JOBS" "$parallel" "$speedup"
+sed -n '/^digraph G {/,$p' bench/big_module_1.txt > bench/big_module_1.dot
+sed -n '/^digraph G {/,$p' bench/big_module_n.txt > bench/big_module_n.dot
+cmp -s bench/big_module_1.dot bench/big_module_n.dot || echo "tree differs between serial and --parallel-lex"
@@ -0,0 +1,31 @@
+#!/bin/bash
+# Times `compiler --project` on a generated tree of MODULES modules, in
+# layers of WIDTH that each import the layer before, with --jobs 1 and with
+# one worker per core. Run from the repository root after ./build.sh.
+MODULES=${MODULES:-2000}
+WIDTH=${WIDTH:-100}
+JOBS=${JOBS:-$(nproc)}
+TIMEFORMAT=%R
+
+rm -rf bench/project
+python3 - "$MODULES" "$WIDTH" <<'PY'
+import os, sys
+modules, width = int(sys.argv[1]), int(sys.argv[2])
+for i in range(modules):
+    package = f"bench/project/layer{i // width}"
+    os.makedirs(package, exist_ok=True)
+    with open(f"{package}/m{i}.py", "w") as f:
+        if i >= width:
+            f.write(f"from layer{i // width - 1}.m{i - width} import *\n")
+        for k in range(20):
+            f.write(f"def f{i}_{k}(a):\n")
+            f.write("    t = 0\n")
+            f.write("    for i in range(10):\n")
+            f.write("        t = t + a * i\n")
+            f.write("    return t\n")
+PY
+
+serial=$( { time ./compiler --jobs 1 --project bench/project > /dev/null 2>&1; } 2>&1 )
+parallel=$( { time ./compiler --jobs "$JOBS" --project bench/project > /dev/null 2>&1; } 2>&1 )
+speedup=$(awk -v a="$serial" -v b="$parallel" 'BEGIN { printf "%.1f", (b > 0) ? a / b : 0 }')
+printf "%-14s --jobs 1 %6ss   --jobs %s %6ss   speedup %sx\n" "$MODULES modules" "$serial" "$JOBS" "$parallel" "$speedup"
@@ -0,0 +1,23 @@
+#!/bin/bash
+# Focused output (`compiler --select`, selection.hpp): times printing the
+# whole tree of a generated module of LINES lines against printing one def
+# of it by name and by line range, with the size of everything each run
+# writes to stdout. Run from the repository root after ./build.sh.
+LINES=${LINES:-100000}
+TIMEFORMAT=%R
+
+python3 - "$LINES" > bench/select_module.py <<'PY'
+import sys
+for i in range(int(sys.argv[1]) // 4):
+    print(f"def f{i}(a, b):")
+    print(f"    if a < {i}:")
+    print(f"        return a + b * {i}")
+    print(f"    return a - 1")
+PY
+
+middle=$(( LINES / 8 ))
+for selection in "" "--select f$middle" "--select-lines $(( LINES / 2 ))-$(( LINES / 2 + 3 ))"; do
+    elapsed=$( { time ./compiler $selection bench/select_module.py > bench/select.dot 2> /dev/null; } 2>&1 )
+    echo "${selection:-whole tree}: $(stat -c %s bench/select.dot) bytes, ${elapsed}s"
+done
+rm -f bench/select_module.py bench/select.dot
@@ -0,0 +1,32 @@
+#!/bin/bash
+# Per-request latency of `compiler --serve` against cold starts: compiles
+# each script in bench/ to C REQUESTS times with a fresh `compiler` process
+# and as many times through pyclient and one resident server.
+# Run from the repository root after ./build.sh.
+REQUESTS=${REQUESTS:-200}
+SOCKET=${SOCKET:-/tmp/compiler-bench.sock}
+
+./compiler --serve "$SOCKET" 2> bench/server.log &
+for _ in $(seq 50); do
+    [ -S "$SOCKET" ] && break
+    sleep 0.1
+done
+
+for script in bench/*.py; do
+    start=$(date +%s.%N)
+    for _ in $(seq "$REQUESTS"); do
+        ./compiler --emit-c bench/server_cold.c "$script" > /dev/null 2>&1
+    done
+    cold=$(echo "$(date +%s.%N) - $start" | bc)
+    start=$(date +%s.%N)
+    for _ in $(seq "$REQUESTS"); do
+        ./pyclient "$SOCKET" --emit-c bench/server_warm.c "$script" > /dev/null 2>&1
+    done
+    warm=$(echo "$(date +%s.%N) - $start" | bc)
+    printf "%-20s cold %8.2f ms/request   served %8.2f ms/request\n" "$(basename "$script")" \
+        "$(echo "$cold * 1000 / $REQUESTS" | bc -l)" "$(echo "$warm * 1000 / $REQUESTS" | bc -l)"
+    cmp -s bench/server_cold.c bench/server_warm.c || echo "$script: output differs between cold and served"
+done
+
+./pyclient "$SOCKET" --stop
+cat bench/server.log
@@ -0,0 +1,5 @@
+total = 0
+for i in range(20000):
+    for j in range(1000):
+        total = total + i * j - j * j
+print(total)
@@ -0,0 +1,1014 @@
+# 500-arm if/elif chain on one name, the shape generated dispatch code has.
+# bench/switch.sh runs it for the first and the last arm: with the chain
+# lowered to a jump table both take the same time.
+def dispatch(x):
+    r = 0
+    if x == 0:
+        r = 1
+    elif x == 1:
+        r = 2
+    elif x == 2:
+        r = 3
+    elif x == 3:
+        r = 4
+    elif x == 4:
+        r = 5
+    elif x == 5:
+        r = 6
+    elif x == 6:
+        r = 7
+    elif x == 7:
+        r = 8
+    elif x == 8:
+        r = 9
+    elif x == 9:
+        r = 10
+    elif x == 10:
+        r = 11
+    elif x == 11:
+        r = 12
+    elif x == 12:
+        r = 13
+    elif x == 13:
+        r = 14
+    elif x == 14:
+        r = 15
+    elif x == 15:
+        r = 16
+    elif x == 16:
+        r = 17
+    elif x == 17:
+        r = 18
+    elif x == 18:
+        r = 19
+    elif x == 19:
+        r = 20
+    elif x == 20:
+        r = 21
+    elif x == 21:
+        r = 22
+    elif x == 22:
+        r = 23
+    elif x == 23:
+        r = 24
+    elif x == 24:
+        r = 25
+    elif x == 25:
+        r = 26
+    elif x == 26:
+        r = 27
+    elif x == 27:
+        r = 28
+    elif x == 28:
+        r = 29
+    elif x == 29:
+        r = 30
+    elif x == 30:
+        r = 31
+    elif x == 31:
+        r = 32
+    elif x == 32:
+        r = 33
+    elif x == 33:
+        r = 34
+    elif x == 34:
+        r = 35
+    elif x == 35:
+        r = 36
+    elif x == 36:
+        r = 37
+    elif x == 37:
+        r = 38
+    elif x == 38:
+        r = 39
+    elif x == 39:
+        r = 40
+    elif x == 40:
+        r = 41
+    elif x == 41:
+        r = 42
+    elif x == 42:
+        r = 43
+    elif x == 43:
+        r = 44
+    elif x == 44:
+        r = 45
+    elif x == 45:
+        r = 46
+    elif x == 46:
+        r = 47
+    elif x == 47:
+        r = 48
+    elif x == 48:
+        r = 49
+    elif x == 49:
+        r = 50
+    elif x == 50:
+        r = 51
+    elif x == 51:
+        r = 52
+    elif x == 52:
+        r = 53
+    elif x == 53:
+        r = 54
+    elif x == 54:
+        r = 55
+    elif x == 55:
+        r = 56
+    elif x == 56:
+        r = 57
+    elif x == 57:
+        r = 58
+    elif x == 58:
+        r = 59
+    elif x == 59:
+        r = 60
+    elif x == 60:
+        r = 61
+    elif x == 61:
+        r = 62
+    elif x == 62:
+        r = 63
+    elif x == 63:
+        r = 64
+    elif x == 64:
+        r = 65
+    elif x == 65:
+        r = 66
+    elif x == 66:
+        r = 67
+    elif x == 67:
+        r = 68
+    elif x == 68:
+        r = 69
+    elif x == 69:
+        r = 70
+    elif x == 70:
+        r = 71
+    elif x == 71:
+        r = 72
+    elif x == 72:
+        r = 73
+    elif x == 73:
+        r = 74
+    elif x == 74:
+        r = 75
+    elif x == 75:
+        r = 76
+    elif x == 76:
+        r = 77
+    elif x == 77:
+        r = 78
+    elif x == 78:
+        r = 79
+    elif x == 79:
+        r = 80
+    elif x == 80:
+        r = 81
+    elif x == 81:
+        r = 82
+    elif x == 82:
+        r = 83
+    elif x == 83:
+        r = 84
+    elif x == 84:
+        r = 85
+    elif x == 85:
+        r = 86
+    elif x == 86:
+        r = 87
+    elif x == 87:
+        r = 88
+    elif x == 88:
+        r = 89
+    elif x == 89:
+        r = 90
+    elif x == 90:
+        r = 91
+    elif x == 91:
+        r = 92
+    elif x == 92:
+        r = 93
+    elif x == 93:
+        r = 94
+    elif x == 94:
+        r = 95
+    elif x == 95:
+        r = 96
+    elif x == 96:
+        r = 97
+    elif x == 97:
+        r = 98
+    elif x == 98:
+        r = 99
+    elif x == 99:
+        r = 100
+    elif x == 100:
+        r = 101
+    elif x == 101:
+        r = 102
+    elif x == 102:
+        r = 103
+    elif x == 103:
+        r = 104
+    elif x == 104:
+        r = 105
+    elif x == 105:
+        r = 106
+    elif x == 106:
+        r = 107
+    elif x == 107:
+        r = 108
+    elif x == 108:
+        r = 109
+    elif x == 109:
+        r = 110
+    elif x == 110:
+        r = 111
+    elif x == 111:
+        r = 112
+    elif x == 112:
+        r = 113
+    elif x == 113:
+        r = 114
+    elif x == 114:
+        r = 115
+    elif x == 115:
+        r = 116
+    elif x == 116:
+        r = 117
+    elif x == 117:
+        r = 118
+    elif x == 118:
+        r = 119
+    elif x == 119:
+        r = 120
+    elif x == 120:
+        r = 121
+    elif x == 121:
+        r = 122
+    elif x == 122:
+        r = 123
+    elif x == 123:
+        r = 124
+    elif x == 124:
+        r = 125
+    elif x == 125:
+        r = 126
+    elif x == 126:
+        r = 127
+    elif x == 127:
+        r = 128
+    elif x == 128:
+        r = 129
+    elif x == 129:
+        r = 130
+    elif x == 130:
+        r = 131
+    elif x == 131:
+        r = 132
+    elif x == 132:
+        r = 133
+    elif x == 133:
+        r = 134
+    elif x == 134:
+        r = 135
+    elif x == 135:
+        r = 136
+    elif x == 136:
+        r = 137
+    elif x == 137:
+        r = 138
+    elif x == 138:
+        r = 139
+    elif x == 139:
+        r = 140
+    elif x == 140:
+        r = 141
+    elif x == 141:
+        r = 142
+    elif x == 142:
+        r = 143
+    elif x == 143:
+        r = 144
+    elif x == 144:
+        r = 145
+    elif x == 145:
+        r = 146
+    elif x == 146:
+        r = 147
+    elif x == 147:
+        r = 148
+    elif x == 148:
+        r = 149
+    elif x == 149:
+        r = 150
+    elif x == 150:
+        r = 151
+    elif x == 151:
+        r = 152
+    elif x == 152:
+        r = 153
+    elif x == 153:
+        r = 154
+    elif x == 154:
+        r = 155
+    elif x == 155:
+        r = 156
+    elif x == 156:
+        r = 157
+    elif x == 157:
+        r = 158
+    elif x == 158:
+        r = 159
+    elif x == 159:
+        r = 160
+    elif x == 160:
+        r = 161
+    elif x == 161:
+        r = 162
+    elif x == 162:
+        r = 163
+    elif x == 163:
+        r = 164
+    elif x == 164:
+        r = 165
+    elif x == 165:
+        r = 166
+    elif x == 166:
+        r = 167
+    elif x == 167:
+        r = 168
+    elif x == 168:
+        r = 169
+    elif x == 169:
+        r = 170
+    elif x == 170:
+        r = 171
+    elif x == 171:
+        r = 172
+    elif x == 172:
+        r = 173
+    elif x == 173:
+        r = 174
+    elif x == 174:
+        r = 175
+    elif x == 175:
+        r = 176
+    elif x == 176:
+        r = 177
+    elif x == 177:
+        r = 178
+    elif x == 178:
+        r = 179
+    elif x == 179:
+        r = 180
+    elif x == 180:
+        r = 181
+    elif x == 181:
+        r = 182
+    elif x == 182:
+        r = 183
+    elif x == 183:
+        r = 184
+    elif x == 184:
+        r = 185
+    elif x == 185:
+        r = 186
+    elif x == 186:
+        r = 187
+    elif x == 187:
+        r = 188
+    elif x == 188:
+        r = 189
+    elif x == 189:
+        r = 190
+    elif x == 190:
+        r = 191
+    elif x == 191:
+        r = 192
+    elif x == 192:
+        r = 193
+    elif x == 193:
+        r = 194
+    elif x == 194:
+        r = 195
+    elif x == 195:
+        r = 196
+    elif x == 196:
+        r = 197
+    elif x == 197:
+        r = 198
+    elif x == 198:
+        r = 199
+    elif x == 199:
+        r = 200
+    elif x == 200:
+        r = 201
+    elif x == 201:
+        r = 202
+    elif x == 202:
+        r = 203
+    elif x == 203:
+        r = 204
+    elif x == 204:
+        r = 205
+    elif x == 205:
+        r = 206
+    elif x == 206:
+        r = 207
+    elif x == 207:
+        r = 208
+    elif x == 208:
+        r = 209
+    elif x == 209:
+        r = 210
+    elif x == 210:
+        r = 211
+    elif x == 211:
+        r = 212
+    elif x == 212:
+        r = 213
+    elif x == 213:
+        r = 214
+    elif x == 214:
+        r = 215
+    elif x == 215:
+        r = 216
+    elif x == 216:
+        r = 217
+    elif x == 217:
+        r = 218
+    elif x == 218:
+        r = 219
+    elif x == 219:
+        r = 220
+    elif x == 220:
+        r = 221
+    elif x == 221:
+        r = 222
+    elif x == 222:
+        r = 223
+    elif x == 223:
+        r = 224
+    elif x == 224:
+        r = 225
+    elif x == 225:
+        r = 226
+    elif x == 226:
+        r = 227
+    elif x == 227:
+        r = 228
+    elif x == 228:
+        r = 229
+    elif x == 229:
+        r = 230
+    elif x == 230:
+        r = 231
+    elif x == 231:
+        r = 232
+    elif x == 232:
+        r = 233
+    elif x == 233:
+        r = 234
+    elif x == 234:
+        r = 235
+    elif x == 235:
+        r = 236
+    elif x == 236:
+        r = 237
+    elif x == 237:
+        r = 238
+    elif x == 238:
+        r = 239
+    elif x == 239:
+        r = 240
+    elif x == 240:
+        r = 241
+    elif x == 241:
+        r = 242
+    elif x == 242:
+        r = 243
+    elif x == 243:
+        r = 244
+    elif x == 244:
+        r = 245
+    elif x == 245:
+        r = 246
+    elif x == 246:
+        r = 247
+    elif x == 247:
+        r = 248
+    elif x == 248:
+        r = 249
+    elif x == 249:
+        r = 250
+    elif x == 250:
+        r = 251
+    elif x == 251:
+        r = 252
+    elif x == 252:
+        r = 253
+    elif x == 253:
+        r = 254
+    elif x == 254:
+        r = 255
+    elif x == 255:
+        r = 256
+    elif x == 256:
+        r = 257
+    elif x == 257:
+        r = 258
+    elif x == 258:
+        r = 259
+    elif x == 259:
+        r = 260
+    elif x == 260:
+        r = 261
+    elif x == 261:
+        r = 262
+    elif x == 262:
+        r = 263
+    elif x == 263:
+        r = 264
+    elif x == 264:
+        r = 265
+    elif x == 265:
+        r = 266
+    elif x == 266:
+        r = 267
+    elif x == 267:
+        r = 268
+    elif x == 268:
+        r = 269
+    elif x == 269:
+        r = 270
+    elif x == 270:
+        r = 271
+    elif x == 271:
+        r = 272
+    elif x == 272:
+        r = 273
+    elif x == 273:
+        r = 274
+    elif x == 274:
+        r = 275
+    elif x == 275:
+        r = 276
+    elif x == 276:
+        r = 277
+    elif x == 277:
+        r = 278
+    elif x == 278:
+        r = 279
+    elif x == 279:
+        r = 280
+    elif x == 280:
+        r = 281
+    elif x == 281:
+        r = 282
+    elif x == 282:
+        r = 283
+    elif x == 283:
+        r = 284
+    elif x == 284:
+        r = 285
+    elif x == 285:
+        r = 286
+    elif x == 286:
+        r = 287
+    elif x == 287:
+        r = 288
+    elif x == 288:
+        r = 289
+    elif x == 289:
+        r = 290
+    elif x == 290:
+        r = 291
+    elif x == 291:
+        r = 292
+    elif x == 292:
+        r = 293
+    elif x == 293:
+        r = 294
+    elif x == 294:
+        r = 295
+    elif x == 295:
+        r = 296
+    elif x == 296:
+        r = 297
+    elif x == 297:
+        r = 298
+    elif x == 298:
+        r = 299
+    elif x == 299:
+        r = 300
+    elif x == 300:
+        r = 301
+    elif x == 301:
+        r = 302
+    elif x == 302:
+        r = 303
+    elif x == 303:
+        r = 304
+    elif x == 304:
+        r = 305
+    elif x == 305:
+        r = 306
+    elif x == 306:
+        r = 307
+    elif x == 307:
+        r = 308
+    elif x == 308:
+        r = 309
+    elif x == 309:
+        r = 310
+    elif x == 310:
+        r = 311
+    elif x == 311:
+        r = 312
+    elif x == 312:
+        r = 313
+    elif x == 313:
+        r = 314
+    elif x == 314:
+        r = 315
+    elif x == 315:
+        r = 316
+    elif x == 316:
+        r = 317
+    elif x == 317:
+        r = 318
+    elif x == 318:
+        r = 319
+    elif x == 319:
+        r = 320
+    elif x == 320:
+        r = 321
+    elif x == 321:
+        r = 322
+    elif x == 322:
+        r = 323
+    elif x == 323:
+        r = 324
+    elif x == 324:
+        r = 325
+    elif x == 325:
+        r = 326
+    elif x == 326:
+        r = 327
+    elif x == 327:
+        r = 328
+    elif x == 328:
+        r = 329
+    elif x == 329:
+        r = 330
+    elif x == 330:
+        r = 331
+    elif x == 331:
+        r = 332
+    elif x == 332:
+        r = 333
+    elif x == 333:
+        r = 334
+    elif x == 334:
+        r = 335
+    elif x == 335:
+        r = 336
+    elif x == 336:
+        r = 337
+    elif x == 337:
+        r = 338
+    elif x == 338:
+        r = 339
+    elif x == 339:
+        r = 340
+    elif x == 340:
+        r = 341
+    elif x == 341:
+        r = 342
+    elif x == 342:
+        r = 343
+    elif x == 343:
+        r = 344
+    elif x == 344:
+        r = 345
+    elif x == 345:
+        r = 346
+    elif x == 346:
+        r = 347
+    elif x == 347:
+        r = 348
+    elif x == 348:
+        r = 349
+    elif x == 349:
+        r = 350
+    elif x == 350:
+        r = 351
+    elif x == 351:
+        r = 352
+    elif x == 352:
+        r = 353
+    elif x == 353:
+        r = 354
+    elif x == 354:
+        r = 355
+    elif x == 355:
+        r = 356
+    elif x == 356:
+        r = 357
+    elif x == 357:
+        r = 358
+    elif x == 358:
+        r = 359
+    elif x == 359:
+        r = 360
+    elif x == 360:
+        r = 361
+    elif x == 361:
+        r = 362
+    elif x == 362:
+        r = 363
+    elif x == 363:
+        r = 364
+    elif x == 364:
+        r = 365
+    elif x == 365:
+        r = 366
+    elif x == 366:
+        r = 367
+    elif x == 367:
+        r = 368
+    elif x == 368:
+        r = 369
+    elif x == 369:
+        r = 370
+    elif x == 370:
+        r = 371
+    elif x == 371:
+        r = 372
+    elif x == 372:
+        r = 373
+    elif x == 373:
+        r = 374
+    elif x == 374:
+        r = 375
+    elif x == 375:
+        r = 376
+    elif x == 376:
+        r = 377
+    elif x == 377:
+        r = 378
+    elif x == 378:
+        r = 379
+    elif x == 379:
+        r = 380
+    elif x == 380:
+        r = 381
+    elif x == 381:
+        r = 382
+    elif x == 382:
+        r = 383
+    elif x == 383:
+        r = 384
+    elif x == 384:
+        r = 385
+    elif x == 385:
+        r = 386
+    elif x == 386:
+        r = 387
+    elif x == 387:
+        r = 388
+    elif x == 388:
+        r = 389
+    elif x == 389:
+        r = 390
+    elif x == 390:
+        r = 391
+    elif x == 391:
+        r = 392
+    elif x == 392:
+        r = 393
+    elif x == 393:
+        r = 394
+    elif x == 394:
+        r = 395
+    elif x == 395:
+        r = 396
+    elif x == 396:
+        r = 397
+    elif x == 397:
+        r = 398
+    elif x == 398:
+        r = 399
+    elif x == 399:
+        r = 400
+    elif x == 400:
+        r = 401
+    elif x == 401:
+        r = 402
+    elif x == 402:
+        r = 403
+    elif x == 403:
+        r = 404
+    elif x == 404:
+        r = 405
+    elif x == 405:
+        r = 406
+    elif x == 406:
+        r = 407
+    elif x == 407:
+        r = 408
+    elif x == 408:
+        r = 409
+    elif x == 409:
+        r = 410
+    elif x == 410:
+        r = 411
+    elif x == 411:
+        r = 412
+    elif x == 412:
+        r = 413
+    elif x == 413:
+        r = 414
+    elif x == 414:
+        r = 415
+    elif x == 415:
+        r = 416
+    elif x == 416:
+        r = 417
+    elif x == 417:
+        r = 418
+    elif x == 418:
+        r = 419
+    elif x == 419:
+        r = 420
+    elif x == 420:
+        r = 421
+    elif x == 421:
+        r = 422
+    elif x == 422:
+        r = 423
+    elif x == 423:
+        r = 424
+    elif x == 424:
+        r = 425
+    elif x == 425:
+        r = 426
+    elif x == 426:
+        r = 427
+    elif x == 427:
+        r = 428
+    elif x == 428:
+        r = 429
+    elif x == 429:
+        r = 430
+    elif x == 430:
+        r = 431
+    elif x == 431:
+        r = 432
+    elif x == 432:
+        r = 433
+    elif x == 433:
+        r = 434
+    elif x == 434:
+        r = 435
+    elif x == 435:
+        r = 436
+    elif x == 436:
+        r = 437
+    elif x == 437:
+        r = 438
+    elif x == 438:
+        r = 439
+    elif x == 439:
+        r = 440
+    elif x == 440:
+        r = 441
+    elif x == 441:
+        r = 442
+    elif x == 442:
+        r = 443
+    elif x == 443:
+        r = 444
+    elif x == 444:
+        r = 445
+    elif x == 445:
+        r = 446
+    elif x == 446:
+        r = 447
+    elif x == 447:
+        r = 448
+    elif x == 448:
+        r = 449
+    elif x == 449:
+        r = 450
+    elif x == 450:
+        r = 451
+    elif x == 451:
+        r = 452
+    elif x == 452:
+        r = 453
+    elif x == 453:
+        r = 454
+    elif x == 454:
+        r = 455
+    elif x == 455:
+        r = 456
+    elif x == 456:
+        r = 457
+    elif x == 457:
+        r = 458
+    elif x == 458:
+        r = 459
+    elif x == 459:
+        r = 460
+    elif x == 460:
+        r = 461
+    elif x == 461:
+        r = 462
+    elif x == 462:
+        r = 463
+    elif x == 463:
+        r = 464
+    elif x == 464:
+        r = 465
+    elif x == 465:
+        r = 466
+    elif x == 466:
+        r = 467
+    elif x == 467:
+        r = 468
+    elif x == 468:
+        r = 469
+    elif x == 469:
+        r = 470
+    elif x == 470:
+        r = 471
+    elif x == 471:
+        r = 472
+    elif x == 472:
+        r = 473
+    elif x == 473:
+        r = 474
+    elif x == 474:
+        r = 475
+    elif x == 475:
+        r = 476
+    elif x == 476:
+        r = 477
+    elif x == 477:
+        r = 478
+    elif x == 478:
+        r = 479
+    elif x == 479:
+        r = 480
+    elif x == 480:
+        r = 481
+    elif x == 481:
+        r = 482
+    elif x == 482:
+        r = 483
+    elif x == 483:
+        r = 484
+    elif x == 484:
+        r = 485
+    elif x == 485:
+        r = 486
+    elif x == 486:
+        r = 487
+    elif x == 487:
+        r = 488
+    elif x == 488:
+        r = 489
+    elif x == 489:
+        r = 490
+    elif x == 490:
+        r = 491
+    elif x == 491:
+        r = 492
+    elif x == 492:
+        r = 493
+    elif x == 493:
+        r = 494
+    elif x == 494:
+        r = 495
+    elif x == 495:
+        r = 496
+    elif x == 496:
+        r = 497
+    elif x == 497:
+        r = 498
+    elif x == 498:
+        r = 499
+    elif x == 499:
+        r = 500
+    else:
+        r = -1
+    return r
+
+arm = 0
+total = 0
+for i in range(1000000):
+    total = total + dispatch(arm)
+print(total)
@@ -0,0 +1,13 @@
+#!/bin/bash
+# Times the 500-arm chain in bench/switch.py under `compiler --run` taking
+# its first arm and its last arm, interpreted and with the JIT. Run from the
+# repository root after ./build.sh.
+TIMEFORMAT=%R
+
+sed 's/^arm = 0$/arm = 499/' bench/switch.py > bench/switch_last.py
+for threshold in 0 1000; do
+    first=$( { time ./compiler --run --jit-threshold "$threshold" bench/switch.py > /dev/null; } 2>&1 )
+    last=$( { time ./compiler --run --jit-threshold "$threshold" bench/switch_last.py > /dev/null; } 2>&1 )
+    printf "switch       jit threshold %-5s first arm %6ss   last arm %6ss\n" "$threshold" "$first" "$last"
+done
+rm -f bench/switch_last.py
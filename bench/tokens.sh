@@ -0,0 +1,22 @@
+#!/bin/bash
+# Tokens per second of the tokenize-only entry point (`compiler
+# --token-bench`, token_stream.hpp) on each bench/*.py and on a generated
+# module of LINES lines. The tokenizer is reused across rounds, as a linter
+# or formatter would keep it. Run from the repository root after ./build.sh.
+ROUNDS=${ROUNDS:-200}
+LINES=${LINES:-100000}
+
+python3 - "$LINES" > bench/token_module.py <<'PY'
+import sys
+for i in range(int(sys.argv[1]) // 4):
+    print(f"def f{i}(a, b):")
+    print(f"    if a < {i}:")
+    print(f"        return a + b * {i}")
+    print(f"    return \"f{i}\"")
+PY
+
+for script in bench/*.py; do
+    echo "$(basename "$script" .py)"
+    ./compiler --token-bench "$ROUNDS" "$script" 2>&1 > /dev/null | grep '^tokens:'
+done
+rm -f bench/token_module.py
@@ -0,0 +1,11 @@
+#!/bin/bash
+# Times full-tree walks of each bench/*.py with `compiler --visit-bench`:
+# AstVisitor against a dynamic_cast chain, and the DOT, JSON and binary tree
+# writers with the bytes each emits. Run from the repository root after
+# ./build.sh.
+ROUNDS=${ROUNDS:-2000}
+
+for script in bench/*.py; do
+    echo "$(basename "$script" .py)"
+    ./compiler --visit-bench "$ROUNDS" "$script" 2>&1 > /dev/null | grep '^visit:'
+done
@@ -1,3 +1,4 @@
 flex pycompile.l
 bison -d parser.y
-gcc -o compiler parser.tab.c lex.yy.c
\ No newline at end of file
+g++ -pthread -o compiler parser.tab.c lex.yy.c
+gcc -o pyclient pyclient.c
\ No newline at end of file
@@ -0,0 +1,568 @@
+#ifndef C_BACKEND_H
+#define C_BACKEND_H
+
+#include "counted_loop.hpp"
+#include "switch_chain.hpp"
+#include "task_scheduler.hpp"
+#include "type_inference.hpp"
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Translates a module into one portable C file that links against pyrt.c:
+//
+//     ./compiler --emit-c prog.c prog.py
+//     gcc -o prog prog.c pyrt.c
+//
+// Module-level defs become static C functions, module names become static
+// globals and function locals become C locals. Every slot, parameter and
+// result that TypeInference proved to be an int is an unboxed int64_t, with
+// overflow-checked arithmetic in place of Python's unbounded ints; everything
+// else is a pyrt_value handled by the runtime. Constructs outside the supported subset
+// (classes, closures, try/with/match/yield, iteration over anything but a
+// literal range) are reported through getErrors() and nothing is emitted.
+class CBackend {
+public:
+    CBackend(const SymbolTable& symbols, const TypeInference& types)
+        : symbols(symbols), types(types) {}
+
+    bool emit(AstNode* root, std::ostream& out) {
+        StatementsNode* module = dynamic_cast<StatementsNode*>(root);
+        if (!module) {
+            errors.push_back("--emit-c: empty module");
+            return false;
+        }
+
+        std::ostringstream globals, prototypes, functions, mainBody;
+        const Scope* moduleScope = symbols.module();
+        std::map<int, const FunctionNode*> defs = functionSlots(module);
+        for (const auto& sym : moduleScope->symbols) {
+            if (sym.kind == NameKind::Global && !defs.count(sym.slot)) {
+                globals << "static " << cType(types.slotType(moduleScope, sym.slot))
+                        << " g_" << sym.name << ";" << std::endl;
+            }
+        }
+
+        // Module statements are emitted here, in order; defs are collected
+        // and emitted on the scheduler's workers. Every statement keeps its
+        // own code and errors, joined in source order below.
+        const std::vector<AstNode*>& stmts = module->getStatements();
+        std::vector<Unit> units(stmts.size());
+        std::vector<size_t> defIndexes;
+        for (size_t i = 0; i < stmts.size(); ++i) {
+            where = "module scope";
+            currentFunction = nullptr;
+            currentScope = moduleScope;
+            errors.swap(units[i].errors);
+            if (FunctionNode* function = dynamic_cast<FunctionNode*>(stmts[i])) {
+                if (!types.isDirectFunction(function)) {
+                    unsupported("redefinition of '" + function->name + "'");
+                } else {
+                    units[i].function = function;
+                    defIndexes.push_back(i);
+                }
+            } else {
+                emitStatement(stmts[i], units[i].code, 1);
+            }
+            errors.swap(units[i].errors);
+        }
+        auto emitDef = [&](size_t k) {
+            Unit& unit = units[defIndexes[k]];
+            CBackend backend(symbols, types);
+            unit.prototype = backend.signature(unit.function);
+            backend.emitFunction(unit.function, unit.code);
+            unit.errors.insert(unit.errors.end(), backend.errors.begin(), backend.errors.end());
+        };
+        if (scheduler) {
+            scheduler->parallelFor(defIndexes.size(), emitDef);
+        } else {
+            for (size_t k = 0; k < defIndexes.size(); ++k) {
+                emitDef(k);
+            }
+        }
+        for (const Unit& unit : units) {
+            if (unit.function) {
+                prototypes << unit.prototype << ";" << std::endl;
+                functions << unit.code.str();
+            } else {
+                mainBody << unit.code.str();
+            }
+            errors.insert(errors.end(), unit.errors.begin(), unit.errors.end());
+        }
+        if (!errors.empty()) {
+            return false;
+        }
+
+        out << "/* generated by compiler --emit-c */" << std::endl;
+        out << "#include \"pyrt.h\"" << std::endl << std::endl;
+        out << globals.str() << std::endl;
+        out << prototypes.str() << std::endl;
+        out << functions.str();
+        out << "int main(void)" << std::endl << "{" << std::endl;
+        out << mainBody.str();
+        out << "    return 0;" << std::endl << "}" << std::endl;
+        return true;
+    }
+
+    const std::vector<std::string>& getErrors() const { return errors; }
+
+    // Emits the module's defs in parallel (--jobs); the output is the same
+    void setScheduler(TaskScheduler* pool) { scheduler = pool; }
+
+private:
+    // One module statement: a def's prototype and body, or module code
+    struct Unit {
+        const FunctionNode* function = nullptr;
+        std::string prototype;
+        std::ostringstream code;
+        std::vector<std::string> errors;
+    };
+
+    struct CExpr {
+        std::string code;
+        ValueType type;
+    };
+
+    const SymbolTable& symbols;
+    const TypeInference& types;
+    TaskScheduler* scheduler = nullptr;
+    std::vector<std::string> errors;
+    std::string where;
+    const FunctionNode* currentFunction = nullptr;
+    const Scope* currentScope = nullptr;
+    int loopCounter = 0;
+
+    void unsupported(const std::string& what) {
+        errors.push_back("--emit-c: unsupported " + what + " in " + where);
+    }
+
+    static std::string cType(ValueType type) {
+        return type == ValueType::Int ? "int64_t" : "pyrt_value";
+    }
+
+    static std::string indent(int level) {
+        return std::string(level * 4, ' ');
+    }
+
+    static std::string boxed(const CExpr& expr) {
+        return expr.type == ValueType::Int ? "pyrt_int(" + expr.code + ")" : expr.code;
+    }
+
+    static std::string converted(const CExpr& expr, ValueType target) {
+        return target == ValueType::Int ? expr.code : boxed(expr);
+    }
+
+    std::map<int, const FunctionNode*> functionSlots(StatementsNode* module) const {
+        std::map<int, const FunctionNode*> slots;
+        for (const auto& stmt : module->getStatements()) {
+            if (FunctionNode* function = dynamic_cast<FunctionNode*>(stmt)) {
+                slots[function->binding.slot] = function;
+            }
+        }
+        return slots;
+    }
+
+    std::vector<IdentifierNode*> params(const FunctionNode* function) {
+        std::vector<IdentifierNode*> ids;
+        if (Args* args = dynamic_cast<Args*>(function->getArgs())) {
+            for (const auto& arg : args->getArgs()) {
+                IdentifierNode* id = dynamic_cast<IdentifierNode*>(arg);
+                if (!id) {
+                    unsupported("non-identifier parameter");
+                    continue;
+                }
+                ids.push_back(id);
+            }
+        }
+        return ids;
+    }
+
+    std::string signature(const FunctionNode* function) {
+        const Scope* scope = symbols.scopeOf(function);
+        std::string sig = "static " + cType(types.returnType(function)) + " f_" + function->name + "(";
+        std::vector<IdentifierNode*> ids = params(function);
+        if (ids.empty()) {
+            sig += "void";
+        }
+        for (size_t i = 0; i < ids.size(); ++i) {
+            if (i > 0) {
+                sig += ", ";
+            }
+            sig += cType(types.slotType(scope, ids[i]->binding.slot)) + " v_" + ids[i]->value;
+        }
+        return sig + ")";
+    }
+
+    void emitFunction(const FunctionNode* function, std::ostream& out) {
+        const Scope* scope = symbols.scopeOf(function);
+        where = "function '" + function->name + "'";
+        currentFunction = function;
+        currentScope = scope;
+        for (const auto& sym : scope->symbols) {
+            if (sym.kind == NameKind::Free || sym.kind == NameKind::Nonlocal || sym.captured) {
+                unsupported("closure over '" + sym.name + "'");
+                return;
+            }
+        }
+
+        out << signature(function) << std::endl << "{" << std::endl;
+        for (const auto& sym : scope->symbols) {
+            if (sym.kind == NameKind::Local && !sym.isParam) {
+                ValueType type = types.slotType(scope, sym.slot);
+                out << indent(1) << cType(type) << " v_" << sym.name
+                    << (type == ValueType::Int ? " = 0;" : " = pyrt_none();") << std::endl;
+            }
+        }
+        emitStatement(function->getBody(), out, 1);
+        const StatementsNode* body = dynamic_cast<const StatementsNode*>(function->getBody());
+        bool endsWithReturn = body && !body->getStatements().empty()
+            && dynamic_cast<const ReturnStatementNode*>(body->getStatements().back());
+        if (!endsWithReturn) {
+            out << indent(1) << "return pyrt_none();" << std::endl;
+        }
+        out << "}" << std::endl << std::endl;
+    }
+
+    std::string variable(const NameBinding& binding, const std::string& id) {
+        if (binding.kind == NameKind::Local) {
+            return "v_" + id;
+        }
+        if (binding.kind == NameKind::Global) {
+            return "g_" + id;
+        }
+        unsupported(std::string(nameKindToString(binding.kind)) + " name '" + id + "'");
+        return "0";
+    }
+
+    std::vector<AstNode*> callArguments(const FunctionCallNode* call) const {
+        std::vector<AstNode*> args;
+        for (const auto& arg : call->getArguments()) {
+            if (ArgumentsNode* list = dynamic_cast<ArgumentsNode*>(arg)) {
+                args.insert(args.end(), list->getArguments().begin(), list->getArguments().end());
+            } else {
+                args.push_back(arg);
+            }
+        }
+        return args;
+    }
+
+    CExpr emitCall(const FunctionCallNode* call) {
+        std::vector<AstNode*> args = callArguments(call);
+        if (call->binding.kind == NameKind::Builtin && call->getIdentifier() == "print") {
+            if (args.empty()) {
+                return {"pyrt_print(0, 0)", ValueType::Dynamic};
+            }
+            std::string code = "pyrt_print(" + std::to_string(args.size()) + ", (pyrt_value[]){";
+            for (size_t i = 0; i < args.size(); ++i) {
+                code += (i > 0 ? ", " : "") + boxed(emitExpression(args[i]));
+            }
+            return {code + "})", ValueType::Dynamic};
+        }
+
+        const FunctionNode* callee = types.calledFunction(call);
+        if (!callee) {
+            unsupported("call of '" + call->getIdentifier() + "'");
+            return {"pyrt_none()", ValueType::Dynamic};
+        }
+        std::vector<IdentifierNode*> ids = params(callee);
+        if (ids.size() != args.size()) {
+            unsupported("call of '" + call->getIdentifier() + "' with " + std::to_string(args.size())
+                        + " arguments, expected " + std::to_string(ids.size()));
+            return {"pyrt_none()", ValueType::Dynamic};
+        }
+        const Scope* calleeScope = symbols.scopeOf(callee);
+        std::string code = "f_" + callee->name + "(";
+        for (size_t i = 0; i < args.size(); ++i) {
+            ValueType paramType = types.slotType(calleeScope, ids[i]->binding.slot);
+            code += (i > 0 ? ", " : "") + converted(emitExpression(args[i]), paramType);
+        }
+        return {code + ")", types.returnType(callee)};
+    }
+
+    CExpr emitExpression(const AstNode* node) {
+        if (const PrimaryExpressionNode* n = dynamic_cast<const PrimaryExpressionNode*>(node)) {
+            const std::string& value = n->getValue();
+            if (isIntLiteral(value)) {
+                return {value, ValueType::Int};
+            }
+            if (isFloatLiteral(value)) {
+                return {"pyrt_float(" + literalDigits(value) + ")", ValueType::Dynamic};
+            }
+            if (std::isdigit((unsigned char)value[0])) {
+                unsupported("number " + value);
+                return {"pyrt_none()", ValueType::Dynamic};
+            }
+            if (value == "true" || value == "false") {
+                return {value == "true" ? "pyrt_bool(1)" : "pyrt_bool(0)", ValueType::Dynamic};
+            }
+            return {variable(n->binding, value), types.bindingType(n->binding, currentScope)};
+        }
+        if (const FunctionCallNode* n = dynamic_cast<const FunctionCallNode*>(node)) {
+            return emitCall(n);
+        }
+        if (const NegatedExpressionNode* n = dynamic_cast<const NegatedExpressionNode*>(node)) {
+            return {"pyrt_bool(!" + emitCondition(n->getOperand()) + ")", ValueType::Dynamic};
+        }
+        if (const ExpressionNode* n = dynamic_cast<const ExpressionNode*>(node)) {
+            const std::string& op = n->getOp();
+            if (!n->getLeft()) {
+                CExpr operand = emitExpression(n->getRight());
+                if (op != "-") {
+                    unsupported("unary operator '" + op + "'");
+                }
+                if (operand.type == ValueType::Int) {
+                    return {"pyrt_ineg(" + operand.code + ")", ValueType::Int};
+                }
+                return {"pyrt_neg(" + operand.code + ")", ValueType::Dynamic};
+            }
+            CExpr left = emitExpression(n->getLeft());
+            CExpr right = emitExpression(n->getRight());
+            static const std::map<std::string, std::string> intOps = {
+                {"+", "pyrt_iadd"}, {"-", "pyrt_isub"}, {"*", "pyrt_imul"},
+            };
+            auto intOp = intOps.find(op);
+            if (intOp != intOps.end() && left.type == ValueType::Int && right.type == ValueType::Int) {
+                return {intOp->second + "(" + left.code + ", " + right.code + ")", ValueType::Int};
+            }
+            static const std::map<std::string, std::string> helpers = {
+                {"+", "pyrt_add"}, {"-", "pyrt_sub"}, {"*", "pyrt_mul"}, {"/", "pyrt_div"},
+            };
+            auto helper = helpers.find(op);
+            if (helper == helpers.end()) {
+                unsupported("operator '" + op + "'");
+                return {"pyrt_none()", ValueType::Dynamic};
+            }
+            return {helper->second + "(" + boxed(left) + ", " + boxed(right) + ")", ValueType::Dynamic};
+        }
+        if (dynamic_cast<const ComparisonNode*>(node)) {
+            return {"pyrt_bool(" + emitCondition(node) + ")", ValueType::Dynamic};
+        }
+        unsupported(node ? "expression '" + node->label + "'" : "empty expression");
+        return {"pyrt_none()", ValueType::Dynamic};
+    }
+
+    // A C int that is nonzero when the Python condition is true
+    std::string emitCondition(const AstNode* node) {
+        if (const ComparisonNode* n = dynamic_cast<const ComparisonNode*>(node)) {
+            static const std::map<std::string, std::string> ops = {
+                {"<", "PYRT_LT"}, {">", "PYRT_GT"}, {"<=", "PYRT_LTE"},
+                {">=", "PYRT_GTE"}, {"==", "PYRT_EQ"}, {"!=", "PYRT_NEQ"},
+            };
+            auto op = ops.find(n->getOp());
+            if (op == ops.end()) {
+                unsupported("comparison '" + n->getOp() + "'");
+                return "0";
+            }
+            CExpr left = emitExpression(n->getLeft());
+            CExpr right = emitExpression(n->getRight());
+            if (left.type == ValueType::Int && right.type == ValueType::Int) {
+                return "(" + left.code + " " + n->getOp() + " " + right.code + ")";
+            }
+            return "pyrt_compare(" + boxed(left) + ", " + boxed(right) + ", " + op->second + ")";
+        }
+        CExpr expr = emitExpression(node);
+        if (expr.type == ValueType::Int) {
+            return "(" + expr.code + " != 0)";
+        }
+        return "pyrt_truthy(" + expr.code + ")";
+    }
+
+    void emitElifChain(const AstNode* node, std::ostream& out, int level) {
+        if (const ElifStmtsNode* n = dynamic_cast<const ElifStmtsNode*>(node)) {
+            for (const auto& stmt : n->getElifStmts()) {
+                emitElifChain(stmt, out, level);
+            }
+        } else if (const ElifStmtNode* n = dynamic_cast<const ElifStmtNode*>(node)) {
+            const ElifHeaderNode* header = dynamic_cast<const ElifHeaderNode*>(n->getHeader());
+            out << indent(level) << "} else if (" << emitCondition(header ? header->getExpression() : nullptr)
+                << ") {" << std::endl;
+            emitStatement(n->getBlock(), out, level + 1);
+        }
+    }
+
+    // Whether a `break` in this statement would leave the enclosing loop,
+    // which a C switch around it would capture instead
+    static bool breaksOut(const AstNode* node) {
+        if (dynamic_cast<const BreakStmtNode*>(node)) {
+            return true;
+        }
+        if (const StatementsNode* n = dynamic_cast<const StatementsNode*>(node)) {
+            for (const auto& stmt : n->getStatements()) {
+                if (breaksOut(stmt)) {
+                    return true;
+                }
+            }
+        } else if (const BlockNode* n = dynamic_cast<const BlockNode*>(node)) {
+            for (const auto& stmt : n->getStatements()) {
+                if (breaksOut(stmt)) {
+                    return true;
+                }
+            }
+        } else if (const IfStatementNode* n = dynamic_cast<const IfStatementNode*>(node)) {
+            if (breaksOut(n->getBlock())) {
+                return true;
+            }
+            if (const ElifElseNode* tail = dynamic_cast<const ElifElseNode*>(n->getElifElse())) {
+                for (const auto& elif : tail->getElifStmts()) {
+                    if (breaksOut(elif)) {
+                        return true;
+                    }
+                }
+                return breaksOut(tail->getElseStmt());
+            }
+        } else if (const ElifStmtsNode* n = dynamic_cast<const ElifStmtsNode*>(node)) {
+            for (const auto& stmt : n->getElifStmts()) {
+                if (breaksOut(stmt)) {
+                    return true;
+                }
+            }
+        } else if (const ElifStmtNode* n = dynamic_cast<const ElifStmtNode*>(node)) {
+            return breaksOut(n->getBlock());
+        } else if (const ElseStmtNode* n = dynamic_cast<const ElseStmtNode*>(node)) {
+            return breaksOut(n->getBlock());
+        }
+        return false;
+    }
+
+    // An if/elif chain on one int variable becomes a C switch, which gcc
+    // turns into a jump table or a binary search instead of one compare per arm
+    bool emitSwitch(const IfStatementNode* node, std::ostream& out, int level) {
+        SwitchChain chain;
+        if (!lowerSwitchChain(node, chain)
+            || types.bindingType(chain.subject->binding, currentScope) != ValueType::Int) {
+            return false;
+        }
+        for (const auto& arm : chain.arms) {
+            if (breaksOut(arm.second)) {
+                return false;
+            }
+        }
+        if (chain.otherwise && breaksOut(chain.otherwise)) {
+            return false;
+        }
+        out << indent(level) << "switch (" << emitExpression(chain.subject).code << ") {" << std::endl;
+        for (const auto& arm : chain.arms) {
+            out << indent(level) << "case " << arm.first << ": {" << std::endl;
+            emitStatement(arm.second, out, level + 1);
+            out << indent(level + 1) << "break;" << std::endl;
+            out << indent(level) << "}" << std::endl;
+        }
+        if (chain.otherwise) {
+            out << indent(level) << "default: {" << std::endl;
+            emitStatement(chain.otherwise, out, level + 1);
+            out << indent(level + 1) << "break;" << std::endl;
+            out << indent(level) << "}" << std::endl;
+        }
+        out << indent(level) << "}" << std::endl;
+        return true;
+    }
+
+    // range() loops are emitted in counted form: the counter runs from 0 to the
+    // constant trip count, which is the loop shape gcc unrolls and vectorizes
+    void emitFor(const ForStatementNode* loop, std::ostream& out, int level) {
+        CountedLoop counted;
+        if (!lowerCountedLoop(loop, counted)) {
+            unsupported("for loop over anything but range() of literals");
+            return;
+        }
+        if (counted.step == 0) {
+            unsupported("range() with a zero step");
+            return;
+        }
+
+        std::string counter = "r" + std::to_string(loopCounter++);
+        std::string value = counter;
+        if (counted.step != 1) {
+            value = counter + " * " + std::to_string(counted.step);
+        }
+        if (counted.start != 0) {
+            value = std::to_string(counted.start) + " + " + value;
+        }
+        const ForHeaderNode* header = counted.target;
+        std::string target = variable(header->binding, header->getIdentifier());
+        ValueType targetType = types.bindingType(header->binding, currentScope);
+        out << indent(level) << "for (int64_t " << counter << " = 0; " << counter << " < "
+            << counted.tripCount << "; " << counter << "++) {" << std::endl;
+        out << indent(level + 1) << target << " = "
+            << converted({value, ValueType::Int}, targetType) << ";" << std::endl;
+        emitStatement(counted.body, out, level + 1);
+        out << indent(level) << "}" << std::endl;
+    }
+
+    void emitStatement(const AstNode* node, std::ostream& out, int level) {
+        if (!node) {
+            return;
+        }
+        if (const StatementsNode* n = dynamic_cast<const StatementsNode*>(node)) {
+            for (const auto& stmt : n->getStatements()) {
+                emitStatement(stmt, out, level);
+            }
+        } else if (const BlockNode* n = dynamic_cast<const BlockNode*>(node)) {
+            for (const auto& stmt : n->getStatements()) {
+                emitStatement(stmt, out, level);
+            }
+        } else if (const assignmentStatement* n = dynamic_cast<const assignmentStatement*>(node)) {
+            const IdentifierNode* target = dynamic_cast<const IdentifierNode*>(n->getTarget());
+            if (!target) {
+                unsupported("assignment target");
+                return;
+            }
+            CExpr value = emitExpression(n->getValue());
+            ValueType targetType = types.bindingType(target->binding, currentScope);
+            out << indent(level) << variable(target->binding, target->value) << " = "
+                << converted(value, targetType) << ";" << std::endl;
+        } else if (const ReturnStatementNode* n = dynamic_cast<const ReturnStatementNode*>(node)) {
+            if (!currentFunction) {
+                unsupported("'return' outside function");
+                return;
+            }
+            ValueType resultType = types.returnType(currentFunction);
+            if (!n->getReturnValue()) {
+                out << indent(level) << "return pyrt_none();" << std::endl;
+                return;
+            }
+            out << indent(level) << "return " << converted(emitExpression(n->getReturnValue()), resultType)
+                << ";" << std::endl;
+        } else if (const IfStatementNode* n = dynamic_cast<const IfStatementNode*>(node)) {
+            if (emitSwitch(n, out, level)) {
+                return;
+            }
+            const IfHeaderNode* header = dynamic_cast<const IfHeaderNode*>(n->getHeader());
+            out << indent(level) << "if (" << emitCondition(header ? header->getExpression() : nullptr)
+                << ") {" << std::endl;
+            emitStatement(n->getBlock(), out, level + 1);
+            if (const ElifElseNode* tail = dynamic_cast<const ElifElseNode*>(n->getElifElse())) {
+                for (const auto& elif : tail->getElifStmts()) {
+                    emitElifChain(elif, out, level);
+                }
+                if (const ElseStmtNode* otherwise = dynamic_cast<const ElseStmtNode*>(tail->getElseStmt())) {
+                    out << indent(level) << "} else {" << std::endl;
+                    emitStatement(otherwise->getBlock(), out, level + 1);
+                }
+            }
+            out << indent(level) << "}" << std::endl;
+        } else if (const WhileStatementNode* n = dynamic_cast<const WhileStatementNode*>(node)) {
+            out << indent(level) << "while (" << emitCondition(n->getCondition()) << ") {" << std::endl;
+            emitStatement(n->getBody(), out, level + 1);
+            out << indent(level) << "}" << std::endl;
+        } else if (const ForStatementNode* n = dynamic_cast<const ForStatementNode*>(node)) {
+            emitFor(n, out, level);
+        } else if (dynamic_cast<const BreakStmtNode*>(node)) {
+            out << indent(level) << "break;" << std::endl;
+        } else if (dynamic_cast<const ContinueStmtNode*>(node)) {
+            out << indent(level) << "continue;" << std::endl;
+        } else if (dynamic_cast<const PassStmtNode*>(node) || dynamic_cast<const GlobalStmtNode*>(node)) {
+            out << indent(level) << ";" << std::endl;
+        } else if (dynamic_cast<const FunctionCallNode*>(node) || dynamic_cast<const ExpressionNode*>(node)
+                   || dynamic_cast<const PrimaryExpressionNode*>(node)
+                   || dynamic_cast<const NegatedExpressionNode*>(node)) {
+            out << indent(level) << "(void)" << emitExpression(node).code << ";" << std::endl;
+        } else {
+            unsupported("statement '" + node->label + "'");
+        }
+    }
+};
+
+#endif
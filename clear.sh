@@ -1,4 +1,5 @@
 rm parser.tab.c
-rm parser.tab.h
+rm parser.hpp
 rm lex.yy.c
-rm compiler
\ No newline at end of file
+rm compiler
+rm pyclient
\ No newline at end of file
@@ -0,0 +1,279 @@
+#ifndef COMPILE_SERVER_H
+#define COMPILE_SERVER_H
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Thrown by stopCompile() while a served request runs, in place of exiting
+struct CompileStopped {
+    int status;
+};
+
+inline bool& serving() {
+    static bool flag = false;
+    return flag;
+}
+
+// Ends the compile with `status` where it used to call exit(): the scanner
+// on bad indentation, yyerror, the interpreter's fatal errors. Under
+// --serve only the request ends, and the server answers the next one.
+[[noreturn]] inline void stopCompile(int status) {
+    if (serving()) {
+        throw CompileStopped{status};
+    }
+    std::fflush(stdout);
+    std::exit(status);
+}
+
+// `compiler --serve SOCKET` (or `--serve -` for stdin/stdout): a resident
+// compiler that takes one compile per request, so thousands of small files
+// pay for process startup, allocator warm-up and the thread pool once.
+//
+// Every integer on the wire is a native-endian uint32. A request is a count
+// and that many length-prefixed strings: the client's working directory,
+// then the command line as `compiler` would get it, argv[0] included. A
+// request of no strings stops the server. The response is the exit status
+// and the bytes the compile wrote to stdout and to stderr, each length-
+// prefixed, the same a cold `compiler` run would have printed.
+//
+// The scanner and parser keep their state in globals, so requests run one
+// at a time on the serving thread; within a request, the compile uses the
+// resident pool as before. Output is captured by pointing fds 1 and 2 at
+// two temporary files for the length of the request.
+class CompileServer {
+public:
+    typedef std::function<int(std::vector<std::string>& args)> Handler;
+
+    explicit CompileServer(Handler handler) : handler(handler) {}
+
+    ~CompileServer() {
+        if (out) {
+            fclose(out);
+        }
+        if (err) {
+            fclose(err);
+        }
+        if (home >= 0) {
+            close(home);
+        }
+    }
+
+    CompileServer(const CompileServer&) = delete;
+    CompileServer& operator=(const CompileServer&) = delete;
+
+    // Accepts one client at a time, each for any number of requests
+    bool serveSocket(const char* path) {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (std::string(path).size() >= sizeof(address.sun_path)) {
+            std::fprintf(stderr, "--serve: socket path too long: %s\n", path);
+            return false;
+        }
+        std::copy(path, path + std::string(path).size(), address.sun_path);
+        int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(path);
+        if (listener < 0 || bind(listener, (sockaddr*)&address, sizeof(address)) != 0
+            || listen(listener, 64) != 0 || !start()) {
+            std::perror("--serve");
+            return false;
+        }
+        std::signal(SIGPIPE, SIG_IGN);      // a client that went away ends its connection only
+        while (!stopped) {
+            int client = accept(listener, nullptr, nullptr);
+            if (client < 0) {
+                continue;
+            }
+            while (!stopped && handle(client, client)) {
+            }
+            close(client);
+        }
+        close(listener);
+        unlink(path);
+        return true;
+    }
+
+    // Requests on stdin, responses on stdout. The compile's own stdout is
+    // captured like any other, so nothing else reaches the response stream.
+    bool serveStdio() {
+        int responses = dup(STDOUT_FILENO);
+        int null = open("/dev/null", O_WRONLY);
+        if (responses < 0 || null < 0 || dup2(null, STDOUT_FILENO) < 0 || !start()) {
+            std::perror("--serve");
+            return false;
+        }
+        close(null);
+        while (!stopped && handle(STDIN_FILENO, responses)) {
+        }
+        close(responses);
+        return true;
+    }
+
+    void report(std::ostream& stream) const {
+        stream << "serve: " << requests << " requests";
+        if (requests) {
+            stream << ", " << total / requests * 1e6 << " us mean, " << fastest * 1e6 << " us min, "
+                   << slowest * 1e6 << " us max";
+        }
+        stream << std::endl;
+    }
+
+private:
+    Handler handler;
+    FILE* out = nullptr;                // the request's stdout
+    FILE* err = nullptr;                // and stderr
+    int home = -1;                      // the server's working directory
+    bool stopped = false;
+    size_t requests = 0;
+    double total = 0;
+    double fastest = 1e30;
+    double slowest = 0;
+
+    bool start() {
+        out = tmpfile();
+        err = tmpfile();
+        home = open(".", O_RDONLY | O_DIRECTORY);
+        serving() = true;
+        return out && err && home >= 0;
+    }
+
+    static bool readAll(int fd, void* data, size_t size) {
+        char* p = (char*)data;
+        while (size > 0) {
+            ssize_t n = read(fd, p, size);
+            if (n <= 0) {
+                return false;
+            }
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    static bool writeAll(int fd, const void* data, size_t size) {
+        const char* p = (const char*)data;
+        while (size > 0) {
+            ssize_t n = write(fd, p, size);
+            if (n <= 0) {
+                return false;
+            }
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    static bool readString(int fd, std::string& s) {
+        uint32_t size;
+        if (!readAll(fd, &size, sizeof(size))) {
+            return false;
+        }
+        s.resize(size);
+        return size == 0 || readAll(fd, &s[0], size);
+    }
+
+    static bool writeString(int fd, const std::string& s) {
+        uint32_t size = (uint32_t)s.size();
+        return writeAll(fd, &size, sizeof(size)) && writeAll(fd, s.data(), s.size());
+    }
+
+    // Empties one capture file and returns what the request wrote to it
+    static std::string drain(FILE* file) {
+        int fd = fileno(file);
+        struct stat st;
+        std::string text;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            text.resize((size_t)st.st_size);
+            ssize_t n = pread(fd, &text[0], text.size(), 0);
+            text.resize(n > 0 ? (size_t)n : 0);
+        }
+        if (ftruncate(fd, 0) != 0) {
+            std::perror("--serve");
+        }
+        lseek(fd, 0, SEEK_SET);
+        return text;
+    }
+
+    // One request and its response; false when the client is gone
+    bool handle(int in, int replies) {
+        uint32_t count;
+        if (!readAll(in, &count, sizeof(count))) {
+            return false;
+        }
+        std::vector<std::string> args(count);
+        for (std::string& arg : args) {
+            if (!readString(in, arg)) {
+                return false;
+            }
+        }
+        if (count == 0) {
+            stopped = true;
+            int32_t status = 0;
+            return writeAll(replies, &status, sizeof(status)) && writeString(replies, "") && writeString(replies, "");
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        int32_t status = run(args);
+        std::string stdoutText = drain(out);
+        std::string stderrText = drain(err);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        ++requests;
+        total += seconds;
+        fastest = std::min(fastest, seconds);
+        slowest = std::max(slowest, seconds);
+        return writeAll(replies, &status, sizeof(status)) && writeString(replies, stdoutText)
+            && writeString(replies, stderrText);
+    }
+
+    int run(std::vector<std::string>& args) {
+        std::fflush(stdout);
+        std::fflush(stderr);
+        int savedOut = dup(STDOUT_FILENO);
+        int savedErr = dup(STDERR_FILENO);
+        dup2(fileno(out), STDOUT_FILENO);
+        dup2(fileno(err), STDERR_FILENO);
+        int status;
+        if (args.size() < 2) {
+            std::fprintf(stderr, "--serve: request without a command line\n");
+            status = 2;
+        } else if (chdir(args[0].c_str()) != 0) {
+            std::perror(args[0].c_str());
+            status = 1;
+        } else {
+            args.erase(args.begin());
+            try {
+                status = handler(args);
+            } catch (const CompileStopped& stop) {
+                status = stop.status;
+            } catch (const std::exception& e) {
+                std::fprintf(stderr, "%s\n", e.what());
+                status = 1;
+            }
+        }
+        std::fflush(stdout);
+        std::fflush(stderr);
+        if (fchdir(home) != 0) {
+            std::perror("--serve");
+        }
+        dup2(savedOut, STDOUT_FILENO);
+        dup2(savedErr, STDERR_FILENO);
+        close(savedOut);
+        close(savedErr);
+        return status;
+    }
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef COUNTED_LOOP_H
+#define COUNTED_LOOP_H
+
+#include "python_ast_node.hpp"
+#include <cstdint>
+
+// `for target in range(start, stop, step)` lowered to a counted loop: an
+// unboxed counter k runs from 0 to tripCount and the target takes
+// start + k * step. No iterator object exists, and the trip count is known
+// before the first iteration so backends can decide on unrolling or
+// vectorization up front.
+struct CountedLoop {
+    const ForHeaderNode* target = nullptr;
+    const AstNode* body = nullptr;
+    int64_t start = 0;
+    int64_t stop = 0;
+    int64_t step = 1;
+    int64_t tripCount = 0;  // 0 when step is 0: range() rejects that at run time
+
+    static CountedLoop over(int64_t start, int64_t stop, int64_t step) {
+        CountedLoop loop;
+        loop.start = start;
+        loop.stop = stop;
+        loop.step = step;
+        if (step > 0 && stop > start) {
+            loop.tripCount = (stop - start + step - 1) / step;
+        } else if (step < 0 && stop < start) {
+            loop.tripCount = (start - stop - step - 1) / -step;
+        }
+        return loop;
+    }
+
+    int64_t valueAt(int64_t k) const { return start + k * step; }
+};
+
+// Lowers a for loop over range() of literals (MyRangeNode). Returns false for
+// any other loop, which keeps its generic form.
+inline bool lowerCountedLoop(const ForStatementNode* loop, CountedLoop& out) {
+    const ForHeaderNode* header = dynamic_cast<const ForHeaderNode*>(loop->getHeader());
+    const ChangesNode* changes = dynamic_cast<const ChangesNode*>(loop->getChanges());
+    const MyRangeNode* range = changes ? dynamic_cast<const MyRangeNode*>(changes->getRange()) : nullptr;
+    if (!header || !range || range->getValues().empty()) {
+        return false;
+    }
+    const std::vector<int>& values = range->getValues();
+    if (values.size() == 1) {
+        out = CountedLoop::over(0, values[0], 1);
+    } else {
+        out = CountedLoop::over(values[0], values[1], values.size() > 2 ? values[2] : 1);
+    }
+    out.target = header;
+    out.body = loop->getBlock();
+    return true;
+}
+
+#endif
@@ -0,0 +1,251 @@
+#ifndef DOT_PRINTER_H
+#define DOT_PRINTER_H
+
+#include "ast_visitor.hpp"
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Prints the tree as the body of a Graphviz digraph: one statement per node
+// and one per edge, nodes named by AstNode::name. The if/elif, match, with
+// item and argument list parts have no statement of their own and print
+// their children in place through the visitor's default.
+//
+// A node --hash-cons shared between parents (hash_cons.hpp) is printed,
+// with its own children, where it is first reached; later parents only
+// print their edge to it.
+class DotPrinter : public AstVisitor<DotPrinter> {
+public:
+    explicit DotPrinter(std::ostream& out) : out(out) {}
+
+    void visitFunction(const FunctionNode* n) { labeled(n, n->name); }
+    void visitIdentifier(const IdentifierNode* n) { box(n, n->value); }
+    void visitArgs(const Args* n) { labeled(n); }
+    void visitFunctionCall(const FunctionCallNode* n) { labeled(n, n->getIdentifier()); }
+    void visitFor(const ForStatementNode* n) { labeled(n, n->name); }
+    void visitChanges(const ChangesNode* n) { labeled(n, n->getIdentifier()); }
+    void visitTry(const TryStatementNode* n) { labeled(n, n->name); }
+    void visitTryStmts(const TryStmtsNode* n) { labeled(n, n->name); }
+    void visitExceptBlock(const ExceptBlockNode* n) { labeled(n, n->getIdentifier()); }
+    void visitFinallyBlock(const FinallyBlockNode* n) { labeled(n, n->name); }
+    void visitDecorators(const DecoratorsNode* n) { labeled(n, n->name); }
+    void visitClassDef(const ClassDefNode* n) { labeled(n, n->name); }
+    void visitClassDefRaw(const ClassDefRawNode* n) { labeled(n, n->getIdentifier()); }
+    void visitBlock(const BlockNode* n) { labeled(n); }
+    void visitStatements(const StatementsNode* n) { labeled(n); }
+    void visitAssignment(const assignmentStatement* n) { labeled(n); }
+
+    void visitCompOp(const CompOpNode* n) { node(n, n->getOp()); }
+    void visitForHeader(const ForHeaderNode* n) { node(n, n->getIdentifier()); }
+    void visitRange(const RangeNode* n) { values(n, n->getValues()); }
+    void visitMyFunc(const MyFuncNode* n) { node(n, n->getIdentifier()); }
+    void visitMyRange(const MyRangeNode* n) { values(n, n->getValues()); }
+    void visitNumber(const NumberNode* n) { box(n, n->getValue()); }
+    void visitLiteral(const LiteralNode* n) { box(n, n->getValue()); }
+    void visitBreak(const BreakStmtNode* n) { node(n); }
+    void visitContinue(const ContinueStmtNode* n) { node(n); }
+    void visitPass(const PassStmtNode* n) { node(n); }
+
+    void visitArg(const Arg* n) {
+        node(n);
+        visitNode(n);
+    }
+
+    void visitWhile(const WhileStatementNode* n) {
+        node(n, n->name);
+        edge(n, n->getCondition(), "condition");
+        edge(n, n->getBody(), "body");
+    }
+
+    void visitPrimaryExpression(const PrimaryExpressionNode* n) {
+        if (printedBefore(n)) {
+            return;
+        }
+        node(n, n->getValue());
+    }
+
+    void visitNegatedExpression(const NegatedExpressionNode* n) {
+        if (printedBefore(n)) {
+            return;
+        }
+        labeled(n);
+    }
+
+    void visitExpression(const ExpressionNode* n) {
+        if (printedBefore(n)) {
+            return;
+        }
+        labeled(n, n->getOp());
+    }
+
+    void visitComparison(const ComparisonNode* n) {
+        if (printedBefore(n)) {
+            return;
+        }
+        node(n, n->getOp());
+        edge(n, n->getLeft(), "left");
+        edge(n, n->getRight(), "right");
+    }
+
+    // Edges to the items, the block in place
+    void visitWith(const WithStmtNode* n) {
+        node(n, n->name);
+        for (const AstNode* item : n->getWithItems()) {
+            edge(n, item);
+        }
+        if (n->getBlock()) {
+            dispatch(n->getBlock());
+        }
+    }
+
+    void visitWithItem(const WithItem* n) {
+        open(n);
+        out << " : " << n->getIdentifier1();
+        if (!n->getStringLiteral().empty()) {
+            out << " = " << n->getStringLiteral();
+        }
+        if (!n->getIdentifier2().empty()) {
+            out << " as " << n->getIdentifier2();
+        }
+        close();
+    }
+
+    void visitGlobal(const GlobalStmtNode* n) {
+        node(n, n->getIdentifier());
+        for (const std::string& param : n->getParams()) {
+            out << "\t" << n->getIdentifier() << " -> " << param << ";\n";
+        }
+    }
+
+    void visitNonlocal(const NonlocalStmtNode* n) {
+        node(n, n->getIdentifier());
+        for (const std::string& param : n->getParams()) {
+            out << "\t" << n->getIdentifier() << " -> " << param << ";\n";
+        }
+    }
+
+    void visitImport(const ImportStmtNode* n) {
+        open(n);
+        out << " : ";
+        if (n->isFrom()) {
+            out << "from " << std::string(n->getLevel(), '.') << n->getModule() << " ";
+        }
+        out << "import";
+        for (size_t i = 0; i < n->getNames().size(); ++i) {
+            const ImportStmtNode::Name& imported = n->getNames()[i];
+            out << (i ? ", " : " ") << imported.name;
+            if (!imported.alias.empty()) {
+                out << " as " << imported.alias;
+            }
+        }
+        close();
+    }
+
+    // Named by the operator alone, each operand printed after its own copy
+    // of the node's statement
+    void visitBinaryExpression(const BinaryExpressionNode* n) {
+        out << "\tBinaryExpressionNode [label=\"" << n->getOp() << "\"]\n";
+        dispatch(n->getLeft());
+        out << "\tBinaryExpressionNode [label=\"" << n->getOp() << "\"]\n";
+        dispatch(n->getRight());
+    }
+
+    void visitReturn(const ReturnStatementNode* n) {
+        out << "\t" << n->name << " [label=\"ReturnStatement";
+        close();
+        if (n->getReturnValue()) {
+            dispatch(n->getReturnValue());
+        }
+    }
+
+private:
+    std::ostream& out;
+    std::unordered_set<const AstNode*> printed;     // shared nodes only
+
+    bool printedBefore(const AstNode* n) {
+        return n->shared && !printed.insert(n).second;
+    }
+
+    // The label is streamed in parts rather than concatenated, which would
+    // build and free a string per printed node
+    void open(const AstNode* n) {
+        out << "\t" << n->name << " [label=\"" << n->label;
+    }
+
+    void close() {
+        out << "\"]\n";
+    }
+
+    // `name [label="label"]` or `name [label="label : detail"]`
+    void node(const AstNode* n) {
+        open(n);
+        close();
+    }
+
+    template <class T>
+    void node(const AstNode* n, const T& detail) {
+        open(n);
+        out << " : " << detail;
+        close();
+    }
+
+    template <class T>
+    void box(const AstNode* n, const T& value) {
+        out << "\t" << n->name << " [shape=box,label=\"" << n->label << ": " << value << "\"]\n";
+    }
+
+    void values(const AstNode* n, const std::vector<int>& values) {
+        open(n);
+        out << " : ";
+        for (size_t i = 0; i < values.size(); ++i) {
+            out << (i ? ", " : "") << values[i];
+        }
+        close();
+    }
+
+    void edge(const AstNode* from, const AstNode* to, const char* label = nullptr) {
+        if (!to) {
+            return;
+        }
+        out << "\t" << from->name << " -> " << to->name;
+        if (label) {
+            out << " [label=\"" << label << "\"]";
+        }
+        out << ";\n";
+        dispatch(to);
+    }
+
+    void edges(const AstNode* n) {
+        forEachChild(n, [&](const AstNode* child) { edge(n, child); });
+    }
+
+    // The node's statement, then an edge to each child
+    void labeled(const AstNode* n) {
+        node(n);
+        edges(n);
+    }
+
+    template <class T>
+    void labeled(const AstNode* n, const T& detail) {
+        node(n, detail);
+        edges(n);
+    }
+};
+
+// A parsed tree, printed as a Graphviz digraph on stdout unless told
+// otherwise. The nodes belong to the arena they were parsed into.
+class AST {
+private:
+    AstNode* root = nullptr;
+public:
+    AST(AstNode* r) : root(r) {}
+
+    void Print(std::ostream& out = std::cout) {
+        out << "digraph G {" << std::endl;
+        DotPrinter(out).dispatch(root);
+        out << "}" << std::endl;
+    }
+};
+
+#endif
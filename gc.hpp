@@ -0,0 +1,260 @@
+#ifndef GC_H
+#define GC_H
+
+#include "value.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <ostream>
+#include <vector>
+
+class Heap;
+
+// Whoever holds Values outside the heap. A minor collection only needs the
+// roots that can point into the nursery: the runtime stacks plus whatever
+// old-generation storage the write barrier remembered since the last one.
+class RootSet {
+public:
+    virtual void scanRoots(Heap& heap, bool minor) = 0;
+    virtual ~RootSet() {}
+};
+
+struct GcStats {
+    long long minorCollections = 0;
+    long long majorCollections = 0;
+    double minorSeconds = 0;
+    double majorSeconds = 0;
+    double maxPauseSeconds = 0;
+    size_t bytesAllocated = 0;
+    size_t bytesPromoted = 0;
+    size_t bytesFreed = 0;
+};
+
+// Precise generational collector for HeapObjects. New objects are bump
+// allocated in a fixed nursery; when it is full, a minor collection copies
+// every nursery object reachable from the roots into the old generation
+// (individually malloc'd) and resets the nursery. The old generation is
+// collected by mark and sweep once it has doubled since the last major
+// collection. Values hold object addresses directly, so visit() rewrites
+// every root it is given to the object's new address.
+class Heap {
+public:
+    explicit Heap(size_t nurseryBytes = 1 << 20)
+        : nurseryCapacity(nurseryBytes), majorThreshold(4 * nurseryBytes), started(Clock::now()) {
+        nursery = static_cast<unsigned char*>(std::malloc(nurseryCapacity));
+    }
+
+    ~Heap() {
+        for (HeapObject* object : oldObjects) {
+            std::free(object);
+        }
+        std::free(nursery);
+    }
+
+    Heap(const Heap&) = delete;
+    Heap& operator=(const Heap&) = delete;
+
+    void setRoots(RootSet* rootSet) { roots = rootSet; }
+
+    Value makeInt(int64_t i) {
+        if (Value::fitsInline(i)) {
+            return Value::smallInt(i);
+        }
+        return Value::object(newObject<IntObject>(false, 0, i));
+    }
+
+    // For values that live as long as the program, like the constant pool
+    Value makeTenuredInt(int64_t i) {
+        if (Value::fitsInline(i)) {
+            return Value::smallInt(i);
+        }
+        return Value::object(newObject<IntObject>(true, 0, i));
+    }
+
+    // Generators are never moved: the interpreter holds a running one by address
+    GeneratorObject* makeGenerator(const GeneratorCode* code, uint32_t frameSize) {
+        return newObject<GeneratorObject>(true, frameSize * sizeof(Value), code, frameSize);
+    }
+
+    bool isYoung(const Value& value) const { return value.isObject() && !value.asObject()->old; }
+
+    // Called by RootSet::scanRoots for every root
+    void visit(Value& value) {
+        if (!value.isObject()) {
+            return;
+        }
+        HeapObject* object = value.asObject();
+        if (majorMarking) {
+            mark(object);
+        } else if (!object->old) {
+            value = Value::object(evacuate(object));
+        }
+    }
+
+    void collectMinor() {
+        Clock::time_point start = Clock::now();
+        minorCollection();
+        recordPause(start, stats.minorSeconds);
+        ++stats.minorCollections;
+        if (oldBytes > majorThreshold) {
+            collectMajor();
+        }
+    }
+
+    void collectMajor() {
+        Clock::time_point start = Clock::now();
+        minorCollection();
+        majorMarking = true;
+        if (roots) {
+            roots->scanRoots(*this, false);
+        }
+        while (!grey.empty()) {
+            HeapObject* object = grey.back();
+            grey.pop_back();
+            traceFields(object);
+        }
+        majorMarking = false;
+
+        size_t live = 0;
+        std::vector<HeapObject*> survivors;
+        for (HeapObject* object : oldObjects) {
+            if (object->marked) {
+                object->marked = false;
+                live += object->size;
+                survivors.push_back(object);
+            } else {
+                stats.bytesFreed += object->size;
+                std::free(object);
+            }
+        }
+        oldObjects.swap(survivors);
+        oldBytes = live;
+        majorThreshold = std::max(4 * nurseryCapacity, 2 * live);
+        recordPause(start, stats.majorSeconds);
+        ++stats.majorCollections;
+    }
+
+    const GcStats& getStats() const { return stats; }
+
+    void reportStats(std::ostream& out) const {
+        double elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+        double gcSeconds = stats.minorSeconds + stats.majorSeconds;
+        double mb = 1024.0 * 1024.0;
+        out << std::fixed << std::setprecision(3)
+            << "gc: " << stats.minorCollections << " minor ("
+            << (stats.minorCollections ? stats.minorSeconds * 1e3 / stats.minorCollections : 0.0) << " ms avg), "
+            << stats.majorCollections << " major ("
+            << (stats.majorCollections ? stats.majorSeconds * 1e3 / stats.majorCollections : 0.0) << " ms avg), "
+            << "max pause " << stats.maxPauseSeconds * 1e3 << " ms" << std::endl
+            << "gc: " << stats.bytesAllocated / mb << " MB allocated, " << stats.bytesPromoted / mb
+            << " MB promoted, " << stats.bytesFreed / mb << " MB freed, " << oldBytes / mb << " MB old" << std::endl
+            << "gc: " << (elapsed > 0 ? stats.bytesAllocated / mb / elapsed : 0.0) << " MB/s allocation throughput, "
+            << (elapsed > 0 ? 100.0 * gcSeconds / elapsed : 0.0) << "% of " << elapsed << " s in collection"
+            << std::defaultfloat << std::endl;
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    unsigned char* nursery = nullptr;
+    size_t nurseryCapacity;
+    size_t nurseryTop = 0;
+    std::vector<HeapObject*> oldObjects;
+    size_t oldBytes = 0;
+    size_t majorThreshold;
+    std::vector<HeapObject*> promoted;  // copied by the running minor collection, fields not yet scanned
+    std::vector<HeapObject*> grey;      // marked by the running major collection, fields not yet scanned
+    bool majorMarking = false;
+    RootSet* roots = nullptr;
+    GcStats stats;
+    Clock::time_point started;
+
+    // `extra` bytes follow the object, for the Values a generator keeps inline
+    template <class T, class... Args>
+    T* newObject(bool tenured, size_t extra, Args... args) {
+        size_t size = (sizeof(T) + extra + 7) & ~size_t(7);
+        void* memory;
+        if (tenured || size > nurseryCapacity) {
+            // generators and constants never pass through the nursery, so
+            // a program making only those would never reach collectMinor().
+            // Collect before the object exists, not while it is unbuilt.
+            if (oldBytes + size > majorThreshold) {
+                collectMajor();
+            }
+            memory = std::malloc(size);
+            oldObjects.push_back(static_cast<HeapObject*>(memory));
+            oldBytes += size;
+        } else {
+            if (nurseryTop + size > nurseryCapacity) {
+                collectMinor();
+            }
+            memory = nursery + nurseryTop;
+            nurseryTop += size;
+        }
+        stats.bytesAllocated += size;
+        T* object = new (memory) T(args...);
+        object->old = tenured || size > nurseryCapacity;
+        object->size = size;
+        return object;
+    }
+
+    HeapObject* evacuate(HeapObject* object) {
+        if (object->forward) {
+            return object->forward;
+        }
+        HeapObject* copy = static_cast<HeapObject*>(std::malloc(object->size));
+        std::memcpy(copy, object, object->size);
+        copy->old = true;
+        copy->forward = nullptr;
+        object->forward = copy;
+        oldObjects.push_back(copy);
+        oldBytes += copy->size;
+        stats.bytesPromoted += copy->size;
+        promoted.push_back(copy);
+        return copy;
+    }
+
+    void minorCollection() {
+        if (roots) {
+            roots->scanRoots(*this, true);
+        }
+        while (!promoted.empty()) {
+            HeapObject* object = promoted.back();
+            promoted.pop_back();
+            traceFields(object);
+        }
+        nurseryTop = 0;
+    }
+
+    void mark(HeapObject* object) {
+        if (!object->marked) {
+            object->marked = true;
+            grey.push_back(object);
+        }
+    }
+
+    // Visits the Values stored inside an object; ints have none
+    void traceFields(HeapObject* object) {
+        switch (object->kind) {
+            case HeapObject::Kind::Int:
+                break;
+            case HeapObject::Kind::Generator: {
+                GeneratorObject* generator = static_cast<GeneratorObject*>(object);
+                for (uint32_t i = 0; i < generator->count; ++i) {
+                    visit(generator->slots()[i]);
+                }
+                break;
+            }
+        }
+    }
+
+    void recordPause(Clock::time_point start, double& total) {
+        double pause = std::chrono::duration<double>(Clock::now() - start).count();
+        total += pause;
+        stats.maxPauseSeconds = std::max(stats.maxPauseSeconds, pause);
+    }
+};
+
+#endif
@@ -0,0 +1,268 @@
+#ifndef GENERATOR_COMPILER_H
+#define GENERATOR_COMPILER_H
+
+#include "python_ast_node.hpp"
+#include "scope_analysis.hpp"
+#include <string>
+#include <utility>
+#include <vector>
+
+// One step of a generator's state machine
+struct GeneratorOp {
+    enum class Kind {
+        Exec,           // a statement with no yield inside, run by the tree walker
+        Yield,          // suspend with the value of `node`; resuming continues at the next op
+        Jump,
+        JumpUnless,     // to `target` when `node` is false
+        Return,         // end the generator; `node` is null
+        EnterLoop,      // clear the loop-invariant values of while loop `node`
+        RangeStart,     // for loop `node` over range(): its bounds into the state slots
+        RangeNext,      // the next value into the target, or to `target` once done
+        IterStart,      // for loop `node` over a generator: the generator into a state slot
+        IterNext,       // resume it and store its value, or to `target` once it is exhausted
+    };
+
+    Kind kind;
+    const AstNode* node = nullptr;
+    int target = -1;
+    int breakTarget = -1;       // Exec: where a break inside the statement leads, -1 outside a loop
+    int continueTarget = -1;
+    int state = -1;             // first state slot of a lowered for loop
+
+    GeneratorOp(Kind kind, const AstNode* node) : kind(kind), node(node) {}
+};
+
+// Number of state slots a lowered for loop keeps: the trip index, trip
+// count, start and step of a range, or the generator it iterates
+static const int kRangeState = 4;
+static const int kIterState = 1;
+
+// A generator def lowered to a flat list of ops. Only the statements that
+// contain a yield are taken apart into jumps; everything else runs as one
+// Exec op, so the point where a generator is suspended is a single op index
+// and resuming it jumps straight there. A generator's frame holds the def's
+// locals, then its loop-invariant values, then stateSlots values for the
+// loops that yield, which keep their position there instead of on the C++
+// stack.
+struct GeneratorCode {
+    const FunctionNode* function = nullptr;
+    const Scope* scope = nullptr;
+    std::vector<GeneratorOp> ops;
+    int hoistedSlots = 0;
+    int stateSlots = 0;
+
+    int frameSize() const { return scope->numSlots + hoistedSlots + stateSlots; }
+    int firstState() const { return scope->numSlots + hoistedSlots; }
+};
+
+class GeneratorCompiler {
+public:
+    // Whether a statement yields. A def nested in it is a function of its own.
+    static bool containsYield(const AstNode* node) {
+        if (!node) {
+            return false;
+        }
+        if (dynamic_cast<const YieldStmtNode*>(node)) {
+            return true;
+        }
+        if (const StatementsNode* n = dynamic_cast<const StatementsNode*>(node)) {
+            return anyYields(n->getStatements());
+        }
+        if (const BlockNode* n = dynamic_cast<const BlockNode*>(node)) {
+            return anyYields(n->getStatements());
+        }
+        if (const IfStatementNode* n = dynamic_cast<const IfStatementNode*>(node)) {
+            if (containsYield(n->getBlock())) {
+                return true;
+            }
+            const ElifElseNode* tail = dynamic_cast<const ElifElseNode*>(n->getElifElse());
+            return tail && (anyYields(tail->getElifStmts()) || containsYield(tail->getElseStmt()));
+        }
+        if (const ElifStmtsNode* n = dynamic_cast<const ElifStmtsNode*>(node)) {
+            return anyYields(n->getElifStmts());
+        }
+        if (const ElifStmtNode* n = dynamic_cast<const ElifStmtNode*>(node)) {
+            return containsYield(n->getBlock());
+        }
+        if (const ElseStmtNode* n = dynamic_cast<const ElseStmtNode*>(node)) {
+            return containsYield(n->getBlock());
+        }
+        if (const WhileStatementNode* n = dynamic_cast<const WhileStatementNode*>(node)) {
+            return containsYield(n->getBody());
+        }
+        if (const ForStatementNode* n = dynamic_cast<const ForStatementNode*>(node)) {
+            return containsYield(n->getBlock());
+        }
+        if (const MatchStmtNode* n = dynamic_cast<const MatchStmtNode*>(node)) {
+            const MatchCasesNode* cases = dynamic_cast<const MatchCasesNode*>(n->getMatchCases());
+            for (const auto& c : cases ? cases->getMatchCases() : std::vector<AstNode*>()) {
+                const MatchCaseNode* matchCase = dynamic_cast<const MatchCaseNode*>(c);
+                if (matchCase && containsYield(matchCase->getSimpleStmt())) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Lowers the body of a def that yields. False, with the reason, when a
+    // yield sits in a statement the lowering does not take apart.
+    bool compile(const FunctionNode* function, GeneratorCode& code, std::string& reason) {
+        out = &code;
+        code.function = function;
+        code.ops.clear();
+        code.stateSlots = 0;
+        loops.clear();
+        if (!statement(function->getBody(), reason)) {
+            return false;
+        }
+        emit(GeneratorOp::Kind::Return, nullptr);
+        return true;
+    }
+
+private:
+    // A lowered loop being emitted: where continue goes and the ops whose
+    // target is the loop's exit, patched once the body is emitted
+    struct Loop {
+        int top;
+        std::vector<int> exits;
+    };
+
+    GeneratorCode* out = nullptr;
+    std::vector<Loop> loops;
+
+    static bool anyYields(const std::vector<AstNode*>& stmts) {
+        for (const auto& stmt : stmts) {
+            if (containsYield(stmt)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int emit(GeneratorOp::Kind kind, const AstNode* node) {
+        out->ops.push_back(GeneratorOp(kind, node));
+        return (int)out->ops.size() - 1;
+    }
+
+    int here() const { return (int)out->ops.size(); }
+
+    // Jump or test whose target is the exit of the innermost lowered loop
+    void exitsLoop(int op) {
+        loops.back().exits.push_back(op);
+    }
+
+    void patch(const Loop& loop) {
+        for (int op : loop.exits) {
+            GeneratorOp& exit = out->ops[op];
+            (exit.kind == GeneratorOp::Kind::Exec ? exit.breakTarget : exit.target) = here();
+        }
+    }
+
+    bool statements(const std::vector<AstNode*>& stmts, std::string& reason) {
+        for (const auto& stmt : stmts) {
+            if (!statement(stmt, reason)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // `if` and every `elif` test their condition and jump past the chain
+    // after their block
+    bool ifStatement(const IfStatementNode* n, std::string& reason) {
+        std::vector<std::pair<const AstNode*, const AstNode*>> arms;
+        const IfHeaderNode* header = dynamic_cast<const IfHeaderNode*>(n->getHeader());
+        arms.push_back(std::make_pair(header ? header->getExpression() : nullptr, n->getBlock()));
+        const AstNode* otherwise = nullptr;
+        if (const ElifElseNode* tail = dynamic_cast<const ElifElseNode*>(n->getElifElse())) {
+            std::vector<const AstNode*> pending(tail->getElifStmts().begin(), tail->getElifStmts().end());
+            for (size_t i = 0; i < pending.size(); ++i) {
+                if (const ElifStmtsNode* list = dynamic_cast<const ElifStmtsNode*>(pending[i])) {
+                    pending.insert(pending.begin() + i + 1, list->getElifStmts().begin(), list->getElifStmts().end());
+                } else if (const ElifStmtNode* elif = dynamic_cast<const ElifStmtNode*>(pending[i])) {
+                    const ElifHeaderNode* test = dynamic_cast<const ElifHeaderNode*>(elif->getHeader());
+                    arms.push_back(std::make_pair(test ? test->getExpression() : nullptr, elif->getBlock()));
+                }
+            }
+            const ElseStmtNode* elseStmt = dynamic_cast<const ElseStmtNode*>(tail->getElseStmt());
+            otherwise = elseStmt ? elseStmt->getBlock() : nullptr;
+        }
+
+        std::vector<int> ends;
+        for (const auto& arm : arms) {
+            int test = emit(GeneratorOp::Kind::JumpUnless, arm.first);
+            if (!statement(arm.second, reason)) {
+                return false;
+            }
+            ends.push_back(emit(GeneratorOp::Kind::Jump, nullptr));
+            out->ops[test].target = here();
+        }
+        if (!statement(otherwise, reason)) {
+            return false;
+        }
+        for (int end : ends) {
+            out->ops[end].target = here();
+        }
+        return true;
+    }
+
+    bool loopBody(const AstNode* body, std::string& reason) {
+        if (!statement(body, reason)) {
+            return false;
+        }
+        out->ops[emit(GeneratorOp::Kind::Jump, nullptr)].target = loops.back().top;
+        patch(loops.back());
+        loops.pop_back();
+        return true;
+    }
+
+    bool statement(const AstNode* node, std::string& reason) {
+        if (!node) {
+            return true;
+        }
+        if (!containsYield(node)) {
+            int op = emit(GeneratorOp::Kind::Exec, node);
+            if (!loops.empty()) {
+                out->ops[op].continueTarget = loops.back().top;
+                exitsLoop(op);
+            }
+            return true;
+        }
+        if (const YieldStmtNode* n = dynamic_cast<const YieldStmtNode*>(node)) {
+            emit(GeneratorOp::Kind::Yield, n->getExpression());
+            return true;
+        }
+        if (const StatementsNode* n = dynamic_cast<const StatementsNode*>(node)) {
+            return statements(n->getStatements(), reason);
+        }
+        if (const BlockNode* n = dynamic_cast<const BlockNode*>(node)) {
+            return statements(n->getStatements(), reason);
+        }
+        if (const IfStatementNode* n = dynamic_cast<const IfStatementNode*>(node)) {
+            return ifStatement(n, reason);
+        }
+        if (const WhileStatementNode* n = dynamic_cast<const WhileStatementNode*>(node)) {
+            emit(GeneratorOp::Kind::EnterLoop, n);
+            loops.push_back(Loop{here(), {}});
+            exitsLoop(emit(GeneratorOp::Kind::JumpUnless, n->getCondition()));
+            return loopBody(n->getBody(), reason);
+        }
+        if (const ForStatementNode* n = dynamic_cast<const ForStatementNode*>(node)) {
+            const ChangesNode* changes = dynamic_cast<const ChangesNode*>(n->getChanges());
+            bool overGenerator = changes && !changes->getRange();
+            int state = out->stateSlots;
+            out->stateSlots += overGenerator ? kIterState : kRangeState;
+            out->ops[emit(overGenerator ? GeneratorOp::Kind::IterStart : GeneratorOp::Kind::RangeStart, n)].state = state;
+            loops.push_back(Loop{here(), {}});
+            int next = emit(overGenerator ? GeneratorOp::Kind::IterNext : GeneratorOp::Kind::RangeNext, n);
+            out->ops[next].state = state;
+            exitsLoop(next);
+            return loopBody(n->getBlock(), reason);
+        }
+        reason = "yield inside " + node->label;
+        return false;
+    }
+};
+
+#endif
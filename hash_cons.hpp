@@ -0,0 +1,163 @@
+#ifndef HASH_CONS_H
+#define HASH_CONS_H
+
+#include "python_ast_node.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// `--hash-cons`: one node for each distinct expression of a file. Generated
+// code repeats the same names, constants and comparisons thousands of times;
+// with this on, the grammar hands every primary, negated, arithmetic and
+// comparison expression it reduces to intern(), which returns an equal node
+// made earlier, if there is one, and deletes the new one.
+//
+// Reductions run bottom-up, so a node's children have been interned before
+// it: equal subtrees are the same node, and a node's structure is its kind,
+// its operator or value and the addresses of its children. Hashing that
+// costs the same at any depth. Function calls are never shared (each call
+// site keeps its own inline cache), so an expression containing one never
+// equals another.
+//
+// A shared node has one span, the first occurrence's, and one of each of
+// the fields later passes fill in: one scope binding and one hoisted slot,
+// for expressions that may sit in different scopes or loops. The compiler
+// only hash-conses a tree it prints, never one it runs or lowers to C.
+class HashCons {
+public:
+    // The node to use for `node`, which the grammar just made: an equal
+    // node from earlier in the file, or node itself
+    AstNode* intern(AstNode* node) {
+        Key key;
+        if (!keyOf(node, key)) {
+            return node;
+        }
+        ++offered;
+        auto found = table.find(key);
+        if (found == table.end()) {
+            table.emplace(key, node);
+            ++distinct;
+            return node;
+        }
+        AstNode* earlier = found->second;
+        earlier->shared = true;
+        saved += nodeBytes(node);
+        if (AstArena::current()) {
+            AstArena::current()->discard(node);
+        }
+        return earlier;
+    }
+
+    // Drops the nodes seen so far, which are about to be deleted: a
+    // statement --select leaves out (selection.hpp)
+    void forget() {
+        if (!table.empty()) {
+            table.clear();
+        }
+    }
+
+    // `hash-cons: FILE: N expressions, M distinct (N/M x), B bytes saved`
+    void report(const std::string& path, std::ostream& out) const {
+        out << "hash-cons: " << path << ": " << offered << " expressions, " << distinct << " distinct ("
+            << (distinct == 0 ? 1.0 : (double)offered / distinct) << "x), " << saved << " bytes saved" << std::endl;
+    }
+
+    static HashCons*& current() {
+        static HashCons* table = nullptr;
+        return table;
+    }
+
+    // Makes a table current for as long as the Use lives; null turns
+    // hash-consing off
+    class Use {
+    public:
+        explicit Use(HashCons* table) : previous(current()) { current() = table; }
+        ~Use() { current() = previous; }
+
+        Use(const Use&) = delete;
+        Use& operator=(const Use&) = delete;
+
+    private:
+        HashCons* previous;
+    };
+
+private:
+    // The text views the node's own operator or value, which lives as long
+    // as the node: as long as the arena, and so as long as the table
+    struct Key {
+        NodeKind kind;
+        std::string_view text;
+        const AstNode* left = nullptr;
+        const AstNode* right = nullptr;
+
+        bool operator==(const Key& other) const {
+            return kind == other.kind && left == other.left && right == other.right && text == other.text;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            size_t h = std::hash<std::string_view>()(key.text);
+            mix(h, (size_t)key.kind);
+            mix(h, (size_t)(uintptr_t)key.left);
+            mix(h, (size_t)(uintptr_t)key.right);
+            return h;
+        }
+
+        static void mix(size_t& h, size_t v) { h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2); }
+    };
+
+    std::unordered_map<Key, AstNode*, KeyHash> table;
+    size_t offered = 0;
+    size_t distinct = 0;
+    size_t saved = 0;
+
+    static bool keyOf(const AstNode* node, Key& key) {
+        key.kind = node->kind;
+        switch (node->kind) {
+            case NodeKind::PrimaryExpression:
+                key.text = static_cast<const PrimaryExpressionNode*>(node)->getValue();
+                return true;
+            case NodeKind::NegatedExpression:
+                key.left = static_cast<const NegatedExpressionNode*>(node)->getOperand();
+                return true;
+            case NodeKind::Expression: {
+                const ExpressionNode* n = static_cast<const ExpressionNode*>(node);
+                key.text = n->getOp();
+                key.left = n->getLeft();
+                key.right = n->getRight();
+                return true;
+            }
+            case NodeKind::Comparison: {
+                const ComparisonNode* n = static_cast<const ComparisonNode*>(node);
+                key.text = n->getOp();
+                key.left = n->getLeft();
+                key.right = n->getRight();
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+
+    // Heap bytes behind s, when it is too long for the string's own buffer
+    static size_t heapBytes(const std::string& s) {
+        const char* inside = reinterpret_cast<const char*>(&s);
+        bool local = s.data() >= inside && s.data() < inside + sizeof(s);
+        return local ? 0 : s.capacity() + 1;
+    }
+
+    static size_t nodeBytes(const AstNode* node) {
+        size_t bytes = nodeSize(node->kind) + heapBytes(node->name) + heapBytes(node->label);
+        if (node->kind == NodeKind::PrimaryExpression) {
+            bytes += heapBytes(static_cast<const PrimaryExpressionNode*>(node)->getValue());
+        }
+        return bytes;
+    }
+};
+
+#endif
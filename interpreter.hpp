@@ -0,0 +1,1140 @@
+#ifndef INTERPRETER_H
+#define INTERPRETER_H
+
+#include "compile_server.hpp"
+#include "jit_x86_64.hpp"
+#include "gc.hpp"
+#include "generator_compiler.hpp"
+#include "loop_invariant.hpp"
+#include "match_compiler.hpp"
+#include "switch_chain.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Call counts and timings of one def, kept for the JIT
+struct FunctionProfile {
+    enum class State { Interpreted, Compiled, Rejected };
+
+    State state = State::Interpreted;
+    JitEntry entry = nullptr;
+    std::string rejectReason;
+    long long calls = 0;
+    long long compiledAtCall = 0;
+    long long bailouts = 0;
+    double compileSeconds = 0;
+    int active = 0;                 // calls of this def currently on the stack
+    long long interpretedSamples = 0;
+    double interpretedSeconds = 0;
+    long long nativeSamples = 0;
+    double nativeSeconds = 0;
+};
+
+// Callee of a call site: the def plus the frame layout its calls need
+struct CallTarget {
+    const FunctionNode* function = nullptr;
+    const Scope* scope = nullptr;
+    std::vector<int> paramSlots;
+    int hoistedSlots = 0;
+    FunctionProfile* profile = nullptr;
+    const GeneratorCode* generator = nullptr;   // set when the def yields
+};
+
+// Inline cache of one FunctionCallNode: up to kEntries callees seen there
+struct InlineCache {
+    enum class State { Empty, Monomorphic, Polymorphic, Megamorphic };
+    static const int kEntries = 4;
+
+    State state = State::Empty;
+    const FunctionCallNode* node = nullptr;
+    const CallTarget* entries[kEntries] = {};
+    int count = 0;
+    uint64_t version = 0;           // version of the global callee slot when filled
+    long long hits = 0;
+    long long misses = 0;
+    long long invalidations = 0;    // monomorphic guard failed after the global was rebound
+};
+
+// An if/elif chain dispatched through one table lookup (switch_chain.hpp)
+struct LoweredSwitch {
+    SwitchChain chain;
+    SwitchDispatch dispatch;
+
+    explicit LoweredSwitch(const SwitchChain& chain) : chain(chain), dispatch(chain) {}
+};
+
+// Tree-walking evaluator for `compiler --run`. Names are read through the
+// slots the scope pass assigned, so a call allocates one vector of
+// Scope::numSlots values and never looks a name up by string. Every call site
+// has an inline cache of the defs it called, so the callee's frame layout is
+// not recomputed per call; storing to a global, including through a `global`
+// declaration, invalidates the sites that call it. Each def counts
+// its calls; once a def reaches the JIT threshold it is handed to JitCompiler
+// and, when that succeeds, later calls run the native code. Defs the JIT
+// rejects, and calls whose native code bails out on int overflow, keep
+// running here. Calling a def that yields returns a generator instead
+// (generator_compiler.hpp), whose frame lives inside the GeneratorObject;
+// resuming it continues the def's state machine at the op it stopped at.
+// Values that may point into the collected heap are only kept where
+// scanRoots() finds them: frame slots, globals, constants, generators the
+// write barrier remembered and the operand stack, which holds pending
+// operands, call arguments and the generators for loops iterate.
+class Interpreter : public RootSet {
+public:
+    Interpreter(const SymbolTable& symbols, const TypeInference& types, long long jitThreshold)
+        : symbols(symbols), types(types), licm(symbols), jit(symbols, types), jitThreshold(jitThreshold) {}
+
+    void run(AstNode* root) {
+        for (const auto& literal : symbols.constants) {
+            constants.push_back(decodeConstant(literal));
+        }
+        globals.assign(symbols.module()->numSlots, Value());
+        globalVersions.assign(symbols.module()->numSlots, 0);
+        rememberedGlobal.assign(symbols.module()->numSlots, false);
+        caches.assign(symbols.numCallSites, InlineCache());
+        heap.setRoots(this);
+        licm.run(root);
+        Frame frame;
+        frame.scope = symbols.module();
+        frame.allocate(0, licm.slotsOf(frame.scope));
+        frames.push_back(&frame);
+        exec(root, frame);
+        frames.pop_back();
+    }
+
+    // One line per def that was called: why it was not compiled, or how long
+    // compiling took and how outermost calls compare before and after
+    void reportJitStats(std::ostream& out) const {
+        for (const auto& entry : order) {
+            const FunctionProfile& p = profiles.at(entry);
+            out << "jit: " << entry->name << ": " << p.calls << " calls, ";
+            if (p.state == FunctionProfile::State::Rejected) {
+                out << "not compiled (" << p.rejectReason << ")" << std::endl;
+                continue;
+            }
+            if (p.state == FunctionProfile::State::Interpreted) {
+                out << (jitThreshold > 0 ? "below threshold" : "JIT disabled") << std::endl;
+                continue;
+            }
+            double interpreted = p.interpretedSamples ? p.interpretedSeconds / p.interpretedSamples : 0;
+            double native = p.nativeSamples ? p.nativeSeconds / p.nativeSamples : 0;
+            out << std::fixed << std::setprecision(3)
+                << "compiled at call " << p.compiledAtCall << " in " << p.compileSeconds * 1e3 << " ms ("
+                << jit.codeSize(entry) << " bytes)";
+            if (p.interpretedSamples > 0) {
+                out << ", interpreted " << interpreted * 1e6 << " us/call";
+            }
+            if (p.nativeSamples == 0) {
+                out << ", no outermost call ran native";
+            } else {
+                out << ", native " << native * 1e6 << " us/call";
+            }
+            if (interpreted > 0 && native > 0) {
+                out << ", speedup " << std::setprecision(1) << interpreted / native << "x";
+            }
+            if (p.bailouts) {
+                out << ", " << p.bailouts << " bailouts";
+            }
+            out << std::defaultfloat << std::endl;
+        }
+    }
+
+    void reportGcStats(std::ostream& out) const { heap.reportStats(out); }
+
+    void reportLoopInvariants(std::ostream& out) const { licm.report(out); }
+
+    // Workers for the per-function analysis done before running (--jobs)
+    void setScheduler(TaskScheduler* pool) { licm.setScheduler(pool); }
+
+    // Test match cases one after another instead of through the decision tree
+    void setLinearMatch(bool linear) { linearMatch = linear; }
+
+    void scanRoots(Heap& gc, bool minor) override {
+        for (auto& value : stack) {
+            gc.visit(value);
+        }
+        for (Frame* frame : frames) {
+            for (size_t i = 0; i < frame->size; ++i) {
+                gc.visit(frame->slots[i]);
+            }
+            gc.visit(frame->result);
+        }
+        if (minor) {
+            for (int slot : rememberedGlobals) {
+                gc.visit(globals[slot]);
+                rememberedGlobal[slot] = false;
+            }
+            rememberedGlobals.clear();
+            for (GeneratorObject* generator : rememberedGenerators) {
+                for (uint32_t i = 0; i < generator->count; ++i) {
+                    gc.visit(generator->slots()[i]);
+                }
+                generator->remembered = false;
+            }
+            rememberedGenerators.clear();
+            return;
+        }
+        for (auto& value : globals) {
+            gc.visit(value);
+        }
+        for (auto& value : constants) {
+            gc.visit(value);
+        }
+    }
+
+    // Hit rate of every call site that ran, by site number
+    void reportCallSites(std::ostream& out) const {
+        static const char* const states[] = {"empty", "monomorphic", "polymorphic", "megamorphic"};
+        for (const auto& cache : caches) {
+            if (!cache.node) {
+                continue;
+            }
+            long long lookups = cache.hits + cache.misses;
+            out << "ic: site " << cache.node->site << " call of '" << cache.node->getIdentifier() << "': "
+                << states[(int)cache.state] << ", " << cache.count << " targets, " << lookups << " calls, "
+                << std::fixed << std::setprecision(1) << (lookups ? 100.0 * cache.hits / lookups : 0.0)
+                << "% hits" << std::defaultfloat;
+            if (cache.invalidations) {
+                out << ", " << cache.invalidations << " invalidations";
+            }
+            out << std::endl;
+        }
+    }
+
+private:
+    enum class Flow { Normal, Break, Continue, Return };
+
+    // A call's locals and hoisted values live in `storage`; a generator's
+    // live in its GeneratorObject, so resuming one allocates nothing
+    struct Frame {
+        const Scope* scope = nullptr;
+        Value* slots = nullptr;
+        Value* hoisted = nullptr;       // loop-invariant values, unbound until first computed
+        size_t size = 0;                // Values from `slots` on that are GC roots
+        std::vector<Value> storage;
+        Value result;
+
+        void allocate(size_t numSlots, size_t numHoisted) {
+            storage.assign(numSlots + numHoisted, Value());
+            slots = storage.data();
+            hoisted = slots + numSlots;
+            size = storage.size();
+        }
+    };
+
+    typedef std::chrono::steady_clock Clock;
+
+    const SymbolTable& symbols;
+    const TypeInference& types;
+    LoopInvariantMotion licm;
+    JitCompiler jit;
+    long long jitThreshold;         // 0 disables the JIT
+    Heap heap;
+    std::vector<Value> constants;               // decoded SymbolTable::constants, tenured
+    std::vector<Value> globals;
+    std::vector<int> rememberedGlobals;         // global slots written with a nursery object
+    std::vector<bool> rememberedGlobal;
+    std::vector<Value> stack;                   // operands and arguments under evaluation
+    std::vector<Frame*> frames;                 // active calls, innermost last
+    std::vector<uint64_t> globalVersions;       // bumped on every store, guards inline caches
+    std::vector<InlineCache> caches;            // indexed by FunctionCallNode::site
+    std::unordered_map<const FunctionNode*, CallTarget> targets;
+    std::unordered_map<const FunctionNode*, FunctionProfile> profiles;
+    std::unordered_map<const FunctionNode*, GeneratorCode> generators;
+    std::vector<GeneratorObject*> rememberedGenerators;   // suspended since the last minor collection
+    std::vector<const FunctionNode*> order;     // defs in order of first call
+    std::unordered_map<const MatchStmtNode*, MatchTree> matches;   // compiled on first execution
+    std::vector<Value> matchRegisters;          // subject and its parts while a match dispatches
+    std::vector<std::pair<const PrimaryExpressionNode*, Value>> captured;
+    bool linearMatch = false;
+    std::unordered_map<const IfStatementNode*, std::unique_ptr<LoweredSwitch>> switches;  // null: not lowered
+
+    [[noreturn]] static void fatal(const char* kind, const std::string& msg) {
+        std::fflush(stdout);
+        std::fprintf(stderr, "%s: %s\n", kind, msg.c_str());
+        stopCompile(1);
+    }
+
+    Value decodeConstant(const std::string& literal) {
+        if (isIntLiteral(literal)) {
+            return heap.makeTenuredInt(std::stoll(literal));
+        }
+        if (isFloatLiteral(literal)) {
+            return Value::real(std::strtod(literalDigits(literal).c_str(), nullptr));
+        }
+        if (!literal.empty() && std::isdigit((unsigned char)literal[0])) {
+            // 0x10, 0o17, 0b101 and 1_000, as long as they fit in 64 bits
+            std::string digits = literalDigits(literal);
+            int base = 10;
+            size_t skip = 0;
+            if (digits.size() > 2 && digits[0] == '0' && !std::isdigit((unsigned char)digits[1])) {
+                char prefix = (char)std::tolower((unsigned char)digits[1]);
+                base = prefix == 'x' ? 16 : prefix == 'o' ? 8 : 2;
+                skip = 2;
+            }
+            int64_t value;
+            auto parsed = std::from_chars(digits.data() + skip, digits.data() + digits.size(), value, base);
+            if (parsed.ec == std::errc() && parsed.ptr == digits.data() + digits.size()) {
+                return heap.makeTenuredInt(value);
+            }
+            fatal("NotImplementedError", "--run: int literal " + literal + " does not fit in 64 bits");
+        }
+        if (literal == "true" || literal == "false" || literal == "True" || literal == "False") {
+            return Value::boolean(literal == "true" || literal == "True");
+        }
+        if (literal == "None") {
+            return Value::none();
+        }
+        fatal("NotImplementedError", "--run: literal " + literal);
+    }
+
+    [[noreturn]] static void overflow() { fatal("OverflowError", "integer result does not fit in 64 bits"); }
+
+    Value& slotOf(const NameBinding& binding, Frame& frame, const std::string& id) {
+        switch (binding.kind) {
+            case NameKind::Local:
+                return frame.slots[binding.slot];
+            case NameKind::Global:
+                return globals[binding.slot];
+            case NameKind::Nonlocal:
+            case NameKind::Free:
+                fatal("NotImplementedError", "--run: closure variable '" + id + "'");
+            default:
+                fatal("NameError", "name '" + id + "' is not defined");
+        }
+    }
+
+    // Globals count as old-generation storage: the write barrier remembers a
+    // global slot that now points into the nursery, so minor collections scan
+    // only those slots instead of every global
+    void store(const NameBinding& binding, Frame& frame, const std::string& id, const Value& value) {
+        slotOf(binding, frame, id) = value;
+        if (binding.kind == NameKind::Global) {
+            ++globalVersions[binding.slot];
+            if (heap.isYoung(value) && !rememberedGlobal[binding.slot]) {
+                rememberedGlobal[binding.slot] = true;
+                rememberedGlobals.push_back(binding.slot);
+            }
+        }
+    }
+
+    Value load(const NameBinding& binding, Frame& frame, const std::string& id) {
+        const Value& value = slotOf(binding, frame, id);
+        if (value.isUnbound()) {
+            fatal("NameError", "name '" + id + "' is not defined");
+        }
+        return value;
+    }
+
+    static bool truthy(const Value& v) {
+        if (v.isDouble()) {
+            return v.asDouble() != 0.0;
+        }
+        if (v.isNone()) {
+            return false;
+        }
+        return v.isFunction() || !v.isNumber() || v.asInt() != 0;
+    }
+
+    // Two inline ints never reach the heap unless the result needs more than
+    // 48 bits; floats and bools are always inline
+    Value arithmetic(const std::string& op, const Value& a, const Value& b) {
+        if (!a.isNumber() || !b.isNumber()) {
+            fatal("TypeError", "unsupported operand type(s) for " + op);
+        }
+        if (op == "/") {
+            if (b.toDouble() == 0.0) {
+                fatal("ZeroDivisionError", "division by zero");
+            }
+            return Value::real(a.toDouble() / b.toDouble());
+        }
+        if (a.isDouble() || b.isDouble()) {
+            double x = a.toDouble(), y = b.toDouble();
+            return Value::real(op == "+" ? x + y : op == "-" ? x - y : x * y);
+        }
+        int64_t x = a.asInt(), y = b.asInt(), r;
+        bool overflowed = op == "+" ? __builtin_add_overflow(x, y, &r)
+                        : op == "-" ? __builtin_sub_overflow(x, y, &r)
+                                    : __builtin_mul_overflow(x, y, &r);
+        if (overflowed) {
+            overflow();
+        }
+        return heap.makeInt(r);
+    }
+
+    static bool compare(const std::string& op, const Value& a, const Value& b) {
+        if (op == "==" || op == "!=") {
+            bool equal;
+            if (a.isNumber() && b.isNumber()) {
+                equal = (a.isDouble() || b.isDouble()) ? a.toDouble() == b.toDouble() : a.asInt() == b.asInt();
+            } else {
+                equal = a.raw() == b.raw();
+            }
+            return op == "==" ? equal : !equal;
+        }
+        if (!a.isNumber() || !b.isNumber()) {
+            fatal("TypeError", "'" + op + "' not supported between these operands");
+        }
+        if (!a.isDouble() && !b.isDouble()) {
+            int64_t x = a.asInt(), y = b.asInt();
+            return op == "<" ? x < y : op == ">" ? x > y : op == "<=" ? x <= y : x >= y;
+        }
+        double x = a.toDouble(), y = b.toDouble();
+        return op == "<" ? x < y : op == ">" ? x > y : op == "<=" ? x <= y : x >= y;
+    }
+
+    // Same spelling as Python's print()
+    static void print(const Value& v) {
+        if (v.isNone()) {
+            std::fputs("None", stdout);
+        } else if (v.isBool()) {
+            std::fputs(v.asInt() ? "True" : "False", stdout);
+        } else if (v.isInt()) {
+            std::printf("%lld", (long long)v.asInt());
+        } else if (v.isDouble()) {
+            char buf[32];
+            for (int precision = 1; precision <= 17; ++precision) {
+                std::snprintf(buf, sizeof(buf), "%.*g", precision, v.asDouble());
+                if (std::strtod(buf, nullptr) == v.asDouble()) {
+                    break;
+                }
+            }
+            std::fputs(buf, stdout);
+            if (std::string(buf).find_first_not_of("-0123456789") == std::string::npos) {
+                std::fputs(".0", stdout);
+            }
+        } else if (v.isObject()) {
+            GeneratorObject* generator = static_cast<GeneratorObject*>(v.asObject());
+            std::printf("<generator object %s at %p>", generator->code->function->name.c_str(), (void*)generator);
+        } else {
+            std::printf("<function %s>", v.asFunction()->name.c_str());
+        }
+    }
+
+    static std::vector<AstNode*> flattenArguments(const FunctionCallNode* call) {
+        std::vector<AstNode*> args;
+        for (const auto& arg : call->getArguments()) {
+            if (ArgumentsNode* list = dynamic_cast<ArgumentsNode*>(arg)) {
+                args.insert(args.end(), list->getArguments().begin(), list->getArguments().end());
+            } else {
+                args.push_back(arg);
+            }
+        }
+        return args;
+    }
+
+    Value callBuiltin(const std::string& id, const std::vector<Value>& args) {
+        if (id == "print") {
+            for (size_t i = 0; i < args.size(); ++i) {
+                if (i > 0) {
+                    std::putchar(' ');
+                }
+                print(args[i]);
+            }
+            std::putchar('\n');
+            return Value::none();
+        }
+        if (id == "abs" && args.size() == 1 && args[0].isNumber()) {
+            if (args[0].isDouble()) {
+                return Value::real(std::fabs(args[0].asDouble()));
+            }
+            int64_t i = args[0].asInt();
+            if (i == INT64_MIN) {
+                overflow();
+            }
+            return heap.makeInt(i < 0 ? -i : i);
+        }
+        if ((id == "min" || id == "max") && !args.empty()) {
+            Value best = args[0];
+            for (size_t i = 1; i < args.size(); ++i) {
+                if (compare(id == "min" ? "<" : ">", args[i], best)) {
+                    best = args[i];
+                }
+            }
+            return best;
+        }
+        fatal("NotImplementedError", "--run: builtin '" + id + "'");
+    }
+
+    // Everything a call needs about its callee, worked out once per def
+    const CallTarget* targetOf(const FunctionNode* function) {
+        auto it = targets.find(function);
+        if (it != targets.end()) {
+            return &it->second;
+        }
+        CallTarget& target = targets[function];
+        target.function = function;
+        target.scope = symbols.scopeOf(function);
+        if (Args* formal = dynamic_cast<Args*>(function->getArgs())) {
+            for (const auto& param : formal->getArgs()) {
+                const IdentifierNode* id = dynamic_cast<const IdentifierNode*>(param);
+                target.paramSlots.push_back(id ? id->binding.slot : -1);
+            }
+        }
+        target.hoistedSlots = licm.slotsOf(target.scope);
+        target.profile = &profiles[function];
+        if (GeneratorCompiler::containsYield(function->getBody())) {
+            GeneratorCode& code = generators[function];
+            std::string reason;
+            if (!GeneratorCompiler().compile(function, code, reason)) {
+                fatal("NotImplementedError", "--run: " + reason + " in '" + function->name + "'");
+            }
+            code.scope = target.scope;
+            code.hoistedSlots = target.hoistedSlots;
+            target.generator = &code;
+            target.profile->state = FunctionProfile::State::Rejected;
+            target.profile->rejectReason = "generator, runs as a state machine";
+        }
+        return &target;
+    }
+
+    // Monomorphic fast path: a global callee whose slot was not stored to
+    // since the entry was filled is not even loaded. Otherwise the callee is
+    // loaded and matched against the site's entries; a miss resolves it and
+    // adds an entry until the site turns megamorphic.
+    const CallTarget* lookupCallee(const FunctionCallNode* node, Frame& frame) {
+        InlineCache& cache = caches[node->site];
+        cache.node = node;
+        bool global = node->binding.kind == NameKind::Global;
+        if (global && cache.state == InlineCache::State::Monomorphic
+            && cache.version == globalVersions[node->binding.slot]) {
+            ++cache.hits;
+            return cache.entries[0];
+        }
+
+        Value callee = load(node->binding, frame, node->getIdentifier());
+        if (!callee.isFunction()) {
+            fatal("TypeError", "'" + node->getIdentifier() + "' is not callable");
+        }
+        if (global && cache.state == InlineCache::State::Monomorphic) {
+            ++cache.invalidations;
+        }
+        uint64_t version = global ? globalVersions[node->binding.slot] : 0;
+        for (int i = 0; i < cache.count; ++i) {
+            if (cache.entries[i]->function == callee.asFunction()) {
+                ++cache.hits;
+                if (cache.state == InlineCache::State::Monomorphic) {
+                    cache.version = version;
+                }
+                return cache.entries[i];
+            }
+        }
+
+        ++cache.misses;
+        const CallTarget* target = targetOf(callee.asFunction());
+        if (cache.count < InlineCache::kEntries) {
+            cache.entries[cache.count++] = target;
+            cache.version = version;
+            cache.state = cache.count == 1 ? InlineCache::State::Monomorphic : InlineCache::State::Polymorphic;
+        } else {
+            cache.state = InlineCache::State::Megamorphic;
+        }
+        return target;
+    }
+
+    // Arguments are evaluated onto the operand stack, where the collector
+    // sees them, and stay there until the call returns
+    Value call(const FunctionCallNode* node, Frame& frame) {
+        size_t base = stack.size();
+        for (const auto& arg : flattenArguments(node)) {
+            stack.push_back(eval(arg, frame));
+        }
+        size_t count = stack.size() - base;
+        Value result;
+        if (node->binding.kind == NameKind::Builtin) {
+            result = callBuiltin(node->getIdentifier(), std::vector<Value>(stack.begin() + base, stack.end()));
+        } else {
+            result = invoke(*lookupCallee(node, frame), base, count);
+        }
+        stack.resize(base);
+        return result;
+    }
+
+    Value invoke(const CallTarget& target, size_t base, size_t count) {
+        const FunctionNode* function = target.function;
+        if (target.paramSlots.size() != count) {
+            fatal("TypeError", function->name + "() takes " + std::to_string(target.paramSlots.size())
+                  + " arguments but " + std::to_string(count) + " were given");
+        }
+
+        FunctionProfile& profile = *target.profile;
+        if (profile.calls++ == 0) {
+            order.push_back(function);
+        }
+        if (target.generator) {
+            return startGenerator(target, base);
+        }
+        if (profile.state == FunctionProfile::State::Interpreted && jitThreshold > 0
+            && profile.calls >= jitThreshold) {
+            Clock::time_point start = Clock::now();
+            profile.entry = jit.compile(function, profile.rejectReason);
+            profile.compileSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+            profile.compiledAtCall = profile.calls;
+            profile.state = profile.entry ? FunctionProfile::State::Compiled : FunctionProfile::State::Rejected;
+        }
+
+        // time only outermost calls so recursion is not counted twice
+        bool outermost = profile.active++ == 0;
+        Clock::time_point start = outermost ? Clock::now() : Clock::time_point();
+        Value result;
+        bool native = profile.state == FunctionProfile::State::Compiled && runNative(profile, base, count, result);
+        if (!native) {
+            Frame callee;
+            callee.scope = target.scope;
+            callee.allocate(target.scope->numSlots, target.hoistedSlots);
+            for (size_t i = 0; i < count; ++i) {
+                callee.slots[target.paramSlots[i]] = stack[base + i];
+            }
+            callee.result = Value::none();
+            frames.push_back(&callee);
+            exec(function->getBody(), callee);
+            frames.pop_back();
+            result = callee.result;
+        }
+        --profile.active;
+        if (outermost) {
+            double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            if (native) {
+                ++profile.nativeSamples;
+                profile.nativeSeconds += seconds;
+            } else {
+                ++profile.interpretedSamples;
+                profile.interpretedSeconds += seconds;
+            }
+        }
+        return result;
+    }
+
+    bool runNative(FunctionProfile& profile, size_t base, size_t count, Value& result) {
+        std::vector<int64_t> raw(count);
+        for (size_t i = 0; i < count; ++i) {
+            if (!stack[base + i].isInt()) {
+                return false;
+            }
+            raw[i] = stack[base + i].asInt();
+        }
+        int64_t value = profile.entry(raw.data());
+        if (jitBailout) {
+            jitBailout = 0;
+            ++profile.bailouts;
+            return false;
+        }
+        result = heap.makeInt(value);
+        return true;
+    }
+
+    // Write barrier for generators: a suspended generator is old storage
+    // that may now hold nursery values, so the next minor collection scans it
+    void remember(GeneratorObject* generator) {
+        if (!generator->remembered) {
+            generator->remembered = true;
+            rememberedGenerators.push_back(generator);
+        }
+    }
+
+    // Calling a generator def runs none of its body: the frame is allocated
+    // once, here, with the arguments in their slots
+    Value startGenerator(const CallTarget& target, size_t base) {
+        const GeneratorCode& code = *target.generator;
+        GeneratorObject* generator = heap.makeGenerator(&code, (uint32_t)code.frameSize());
+        for (size_t i = 0; i < target.paramSlots.size(); ++i) {
+            generator->slots()[target.paramSlots[i]] = stack[base + i];
+        }
+        remember(generator);
+        return Value::object(generator);
+    }
+
+    // Runs a generator from the op it stopped at up to its next yield, with
+    // the yielded value in `yielded`. False once the def has finished.
+    bool resume(GeneratorObject* generator, Value& yielded) {
+        if (generator->running) {
+            fatal("ValueError", "generator already executing");
+        }
+        if (generator->pc < 0) {
+            return false;
+        }
+        const GeneratorCode& code = *generator->code;
+        Frame frame;
+        frame.scope = code.scope;
+        frame.slots = generator->slots();
+        frame.hoisted = frame.slots + code.scope->numSlots;
+        frame.size = generator->count;
+        frame.result = Value::none();
+        Value* state = frame.slots + code.firstState();
+        generator->running = true;
+        frames.push_back(&frame);
+
+        int pc = generator->pc;
+        bool suspended = false;
+        while (pc >= 0 && !suspended) {
+            const GeneratorOp& op = code.ops[pc];
+            switch (op.kind) {
+                case GeneratorOp::Kind::Exec: {
+                    Flow flow = exec(op.node, frame);
+                    if (flow == Flow::Normal) {
+                        ++pc;
+                    } else if (flow == Flow::Return) {
+                        pc = -1;
+                    } else {
+                        pc = flow == Flow::Break ? op.breakTarget : op.continueTarget;
+                        if (pc < 0) {
+                            fatal("SyntaxError", flow == Flow::Break ? "'break' outside loop" : "'continue' not properly in loop");
+                        }
+                    }
+                    break;
+                }
+                case GeneratorOp::Kind::Yield:
+                    yielded = eval(op.node, frame);
+                    suspended = true;
+                    ++pc;
+                    break;
+                case GeneratorOp::Kind::Jump:
+                    pc = op.target;
+                    break;
+                case GeneratorOp::Kind::JumpUnless:
+                    pc = truthy(eval(op.node, frame)) ? pc + 1 : op.target;
+                    break;
+                case GeneratorOp::Kind::Return:
+                    pc = -1;
+                    break;
+                case GeneratorOp::Kind::EnterLoop: {
+                    const WhileStatementNode* loop = static_cast<const WhileStatementNode*>(op.node);
+                    std::fill_n(frame.hoisted + loop->hoistFirst, loop->hoistCount, Value());
+                    ++pc;
+                    break;
+                }
+                case GeneratorOp::Kind::RangeStart: {
+                    const ForStatementNode* loop = static_cast<const ForStatementNode*>(op.node);
+                    CountedLoop counted = countedLoop(loop, frame);
+                    state[op.state] = Value::smallInt(0);
+                    state[op.state + 1] = heap.makeInt(counted.tripCount);
+                    state[op.state + 2] = heap.makeInt(counted.start);
+                    state[op.state + 3] = heap.makeInt(counted.step);
+                    std::fill_n(frame.hoisted + loop->hoistFirst, loop->hoistCount, Value());
+                    ++pc;
+                    break;
+                }
+                case GeneratorOp::Kind::RangeNext: {
+                    int64_t k = state[op.state].asInt();
+                    if (k >= state[op.state + 1].asInt()) {
+                        pc = op.target;
+                        break;
+                    }
+                    const ForStatementNode* loop = static_cast<const ForStatementNode*>(op.node);
+                    const ForHeaderNode* target = dynamic_cast<const ForHeaderNode*>(loop->getHeader());
+                    Value value = heap.makeInt(state[op.state + 2].asInt() + k * state[op.state + 3].asInt());
+                    store(target->binding, frame, target->getIdentifier(), value);
+                    state[op.state] = heap.makeInt(k + 1);
+                    ++pc;
+                    break;
+                }
+                case GeneratorOp::Kind::IterStart: {
+                    const ForStatementNode* loop = static_cast<const ForStatementNode*>(op.node);
+                    state[op.state] = iterable(loop, frame);
+                    std::fill_n(frame.hoisted + loop->hoistFirst, loop->hoistCount, Value());
+                    ++pc;
+                    break;
+                }
+                case GeneratorOp::Kind::IterNext: {
+                    Value item;
+                    if (!resume(static_cast<GeneratorObject*>(state[op.state].asObject()), item)) {
+                        state[op.state] = Value();
+                        pc = op.target;
+                        break;
+                    }
+                    const ForStatementNode* loop = static_cast<const ForStatementNode*>(op.node);
+                    const ForHeaderNode* target = dynamic_cast<const ForHeaderNode*>(loop->getHeader());
+                    store(target->binding, frame, target->getIdentifier(), item);
+                    ++pc;
+                    break;
+                }
+            }
+        }
+
+        frames.pop_back();
+        generator->running = false;
+        generator->pc = pc;
+        if (pc < 0) {
+            std::fill_n(frame.slots, frame.size, Value());  // a finished generator keeps nothing alive
+        }
+        remember(generator);
+        return suspended;
+    }
+
+    // Value of an expression the loop-invariant pass hoisted: computed on
+    // the first evaluation since the loop was entered, then reused
+    template <class Node>
+    Value invariant(const Node* node, int slot, Frame& frame) {
+        if (frame.hoisted[slot].isUnbound()) {
+            Value value = operation(node, frame);
+            frame.hoisted[slot] = value;
+        }
+        return frame.hoisted[slot];
+    }
+
+    Value operation(const ExpressionNode* n, Frame& frame) {
+        if (!n->getLeft()) {
+            Value operand = eval(n->getRight(), frame);
+            if (n->getOp() != "-" || !operand.isNumber()) {
+                fatal("TypeError", "bad operand type for unary " + n->getOp());
+            }
+            if (operand.isDouble()) {
+                return Value::real(-operand.asDouble());
+            }
+            if (operand.asInt() == INT64_MIN) {
+                overflow();
+            }
+            return heap.makeInt(-operand.asInt());
+        }
+        stack.push_back(eval(n->getLeft(), frame));
+        Value right = eval(n->getRight(), frame);
+        Value left = stack.back();
+        stack.pop_back();
+        return arithmetic(n->getOp(), left, right);
+    }
+
+    Value operation(const ComparisonNode* n, Frame& frame) {
+        stack.push_back(eval(n->getLeft(), frame));
+        Value right = eval(n->getRight(), frame);
+        Value left = stack.back();
+        stack.pop_back();
+        return Value::boolean(compare(n->getOp(), left, right));
+    }
+
+    Value operation(const NegatedExpressionNode* n, Frame& frame) {
+        return Value::boolean(!truthy(eval(n->getOperand(), frame)));
+    }
+
+    Value eval(const AstNode* node, Frame& frame) {
+        if (const PrimaryExpressionNode* n = dynamic_cast<const PrimaryExpressionNode*>(node)) {
+            if (n->constant >= 0) {
+                return constants[n->constant];
+            }
+            return load(n->binding, frame, n->getValue());
+        }
+        if (const FunctionCallNode* n = dynamic_cast<const FunctionCallNode*>(node)) {
+            return call(n, frame);
+        }
+        if (const ExpressionNode* n = dynamic_cast<const ExpressionNode*>(node)) {
+            return n->hoisted >= 0 ? invariant(n, n->hoisted, frame) : operation(n, frame);
+        }
+        if (const ComparisonNode* n = dynamic_cast<const ComparisonNode*>(node)) {
+            return n->hoisted >= 0 ? invariant(n, n->hoisted, frame) : operation(n, frame);
+        }
+        if (const NegatedExpressionNode* n = dynamic_cast<const NegatedExpressionNode*>(node)) {
+            return n->hoisted >= 0 ? invariant(n, n->hoisted, frame) : operation(n, frame);
+        }
+        fatal("NotImplementedError", "--run: expression '" + (node ? node->label : std::string("?")) + "'");
+    }
+
+    Flow execAll(const std::vector<AstNode*>& stmts, Frame& frame) {
+        for (const auto& stmt : stmts) {
+            Flow flow = exec(stmt, frame);
+            if (flow != Flow::Normal) {
+                return flow;
+            }
+        }
+        return Flow::Normal;
+    }
+
+    // True when a loop stops after a body that ended with `flow`
+    static bool leavesLoop(Flow flow, Flow& result) {
+        if (flow == Flow::Break) {
+            return true;
+        }
+        if (flow == Flow::Return) {
+            result = Flow::Return;
+            return true;
+        }
+        return false;
+    }
+
+    // First elif in the chain whose condition holds
+    const ElifStmtNode* elifTaken(const AstNode* node, Frame& frame) {
+        if (const ElifStmtsNode* n = dynamic_cast<const ElifStmtsNode*>(node)) {
+            for (const auto& stmt : n->getElifStmts()) {
+                if (const ElifStmtNode* taken = elifTaken(stmt, frame)) {
+                    return taken;
+                }
+            }
+            return nullptr;
+        }
+        const ElifStmtNode* n = dynamic_cast<const ElifStmtNode*>(node);
+        const ElifHeaderNode* header = n ? dynamic_cast<const ElifHeaderNode*>(n->getHeader()) : nullptr;
+        return header && truthy(eval(header->getExpression(), frame)) ? n : nullptr;
+    }
+
+    // Bounds of a for loop over range() of literals or over range(f)
+    CountedLoop countedLoop(const ForStatementNode* loop, Frame& frame) {
+        CountedLoop counted;
+        if (!lowerCountedLoop(loop, counted)) {
+            const ChangesNode* changes = dynamic_cast<const ChangesNode*>(loop->getChanges());
+            const MyFuncNode* bound = changes ? dynamic_cast<const MyFuncNode*>(changes->getRange()) : nullptr;
+            if (!bound) {
+                fatal("NotImplementedError", "--run: iteration over anything but range() or a generator");
+            }
+            // range(f) iterates up to the result of calling f()
+            Value callee = load(bound->binding, frame, bound->getIdentifier());
+            Value limit = callee.isFunction() ? invoke(*targetOf(callee.asFunction()), stack.size(), 0) : callee;
+            if (!limit.isInt()) {
+                fatal("TypeError", "range() argument must be an int");
+            }
+            counted = CountedLoop::over(0, limit.asInt(), 1);
+            counted.target = dynamic_cast<const ForHeaderNode*>(loop->getHeader());
+            counted.body = loop->getBlock();
+        }
+        if (counted.step == 0) {
+            fatal("ValueError", "range() arg 3 must not be zero");
+        }
+        return counted;
+    }
+
+    // The generator a `for x in g` loop iterates
+    Value iterable(const ForStatementNode* loop, Frame& frame) {
+        const ChangesNode* changes = static_cast<const ChangesNode*>(loop->getChanges());
+        Value source = load(changes->binding, frame, changes->getIdentifier());
+        if (!source.isObject() || source.asObject()->kind != HeapObject::Kind::Generator) {
+            fatal("TypeError", "'" + changes->getIdentifier() + "' is not iterable");
+        }
+        return source;
+    }
+
+    // The generator stays on the operand stack while the loop runs, so it
+    // outlives the body rebinding the name it came from
+    Flow forEach(const ForStatementNode* loop, Frame& frame) {
+        stack.push_back(iterable(loop, frame));
+        GeneratorObject* generator = static_cast<GeneratorObject*>(stack.back().asObject());
+        const ForHeaderNode* target = dynamic_cast<const ForHeaderNode*>(loop->getHeader());
+        std::fill_n(frame.hoisted + loop->hoistFirst, loop->hoistCount, Value());
+        Flow result = Flow::Normal;
+        Value item;
+        while (resume(generator, item)) {
+            store(target->binding, frame, target->getIdentifier(), item);
+            if (leavesLoop(exec(loop->getBlock(), frame), result)) {
+                break;
+            }
+        }
+        stack.pop_back();
+        return result;
+    }
+
+    Flow forLoop(const ForStatementNode* loop, Frame& frame) {
+        const ChangesNode* changes = dynamic_cast<const ChangesNode*>(loop->getChanges());
+        if (changes && !changes->getRange()) {
+            return forEach(loop, frame);
+        }
+        CountedLoop counted = countedLoop(loop, frame);
+        const ForHeaderNode* target = counted.target;
+        std::fill_n(frame.hoisted + loop->hoistFirst, loop->hoistCount, Value());
+        Flow result = Flow::Normal;
+        for (int64_t k = 0; k < counted.tripCount; ++k) {
+            store(target->binding, frame, target->getIdentifier(), heap.makeInt(counted.valueAt(k)));
+            if (leavesLoop(exec(counted.body, frame), result)) {
+                break;
+            }
+        }
+        return result;
+    }
+
+    // A Python match pattern against a value, the way a case list without a
+    // decision tree would test it
+    bool matchesPattern(const MatchPattern& pattern, const Value& value) {
+        switch (pattern.kind) {
+            case MatchPattern::Kind::Wildcard:
+                return true;
+            case MatchPattern::Kind::Capture:
+                captured.push_back(std::make_pair(pattern.capture, value));
+                return true;
+            case MatchPattern::Kind::Literal:
+                return MatchCompiler::literalMatches(pattern.literal, value);
+            case MatchPattern::Kind::Sequence:
+            case MatchPattern::Kind::Mapping:
+                return false;   // no runtime value is a sequence or a mapping yet
+        }
+        return false;
+    }
+
+    // Matching allocates nothing, so the registers need not be GC roots:
+    // they are dead by the time the case body runs
+    Flow matchStatement(const MatchStmtNode* match, Frame& frame) {
+        auto found = matches.find(match);
+        if (found == matches.end()) {
+            found = matches.emplace(match, MatchTree()).first;
+            std::string reason;
+            MatchCompiler compiler(constants);
+            if (!compiler.compile(match, found->second, reason)) {
+                fatal("NotImplementedError", "--run: " + reason);
+            }
+        }
+        const MatchTree& tree = found->second;
+        Value subject = eval(match->getExpression(), frame);
+
+        captured.clear();
+        int taken = -1;
+        if (linearMatch) {
+            for (size_t i = 0; i < tree.patterns.size() && taken < 0; ++i) {
+                captured.clear();
+                if (matchesPattern(tree.patterns[i], subject)) {
+                    taken = (int)i;
+                }
+            }
+        } else {
+            matchRegisters.assign(tree.numRegisters, Value());
+            matchRegisters[0] = subject;
+            const MatchNode* node = tree.root;
+            while (node->kind == MatchNode::Kind::Switch || node->kind == MatchNode::Kind::Present) {
+                const Value& value = matchRegisters[node->reg];
+                if (node->kind == MatchNode::Kind::Present) {
+                    node = value.isUnbound() ? node->absent : node->present;
+                    continue;
+                }
+                // `lengths` and `mapping` are never taken: no runtime value
+                // is a sequence or a mapping yet
+                const MatchNode* next = node->otherwise;
+                int64_t key;
+                if (value.isBool() || value.isNone()) {
+                    auto it = node->singletons.find(value.raw());
+                    if (it != node->singletons.end()) {
+                        next = it->second;
+                    }
+                } else if (MatchCompiler::intKey(value, key)) {
+                    auto it = node->ints.find(key);
+                    if (it != node->ints.end()) {
+                        next = it->second;
+                    }
+                } else if (value.isDouble()) {
+                    for (const auto& f : node->floats) {
+                        if (f.first == value.asDouble()) {
+                            next = f.second;
+                            break;
+                        }
+                    }
+                }
+                node = next;
+            }
+            if (node->kind == MatchNode::Kind::Leaf) {
+                taken = node->caseIndex;
+                for (const auto& binding : node->bindings) {
+                    captured.push_back(std::make_pair(binding.first, matchRegisters[binding.second]));
+                }
+            }
+        }
+        if (taken < 0) {
+            return Flow::Normal;
+        }
+        for (const auto& capture : captured) {
+            store(capture.first->binding, frame, capture.first->getValue(), capture.second);
+        }
+        return exec(tree.bodies[taken], frame);
+    }
+
+    // The jump table of an if statement, built on its first execution, or
+    // null when the chain does not qualify and keeps testing in order
+    const LoweredSwitch* switchOf(const IfStatementNode* node) {
+        auto found = switches.find(node);
+        if (found == switches.end()) {
+            SwitchChain chain;
+            std::unique_ptr<LoweredSwitch> lowered;
+            if (lowerSwitchChain(node, chain)) {
+                lowered.reset(new LoweredSwitch(chain));
+            }
+            found = switches.emplace(node, std::move(lowered)).first;
+        }
+        return found->second.get();
+    }
+
+    Flow exec(const AstNode* node, Frame& frame) {
+        if (!node) {
+            return Flow::Normal;
+        }
+        if (const StatementsNode* n = dynamic_cast<const StatementsNode*>(node)) {
+            return execAll(n->getStatements(), frame);
+        }
+        if (const BlockNode* n = dynamic_cast<const BlockNode*>(node)) {
+            return execAll(n->getStatements(), frame);
+        }
+        if (const assignmentStatement* n = dynamic_cast<const assignmentStatement*>(node)) {
+            const IdentifierNode* target = dynamic_cast<const IdentifierNode*>(n->getTarget());
+            Value value = eval(n->getValue(), frame);
+            store(target->binding, frame, target->value, value);
+            return Flow::Normal;
+        }
+        if (const FunctionNode* n = dynamic_cast<const FunctionNode*>(node)) {
+            store(n->binding, frame, n->name, Value::def(n));
+            return Flow::Normal;
+        }
+        if (const ReturnStatementNode* n = dynamic_cast<const ReturnStatementNode*>(node)) {
+            frame.result = n->getReturnValue() ? eval(n->getReturnValue(), frame) : Value::none();
+            return Flow::Return;
+        }
+        if (const IfStatementNode* n = dynamic_cast<const IfStatementNode*>(node)) {
+            if (const LoweredSwitch* lowered = switchOf(n)) {
+                // x == literal holds exactly when x is a number equal to the literal
+                const PrimaryExpressionNode* subject = lowered->chain.subject;
+                int64_t key;
+                int arm = MatchCompiler::intKey(load(subject->binding, frame, subject->getValue()), key)
+                    ? lowered->dispatch.lookup(key) : -1;
+                return exec(arm >= 0 ? lowered->chain.arms[arm].second : lowered->chain.otherwise, frame);
+            }
+            const IfHeaderNode* header = dynamic_cast<const IfHeaderNode*>(n->getHeader());
+            if (truthy(eval(header->getExpression(), frame))) {
+                return exec(n->getBlock(), frame);
+            }
+            const ElifElseNode* tail = dynamic_cast<const ElifElseNode*>(n->getElifElse());
+            if (!tail) {
+                return Flow::Normal;
+            }
+            for (const auto& elif : tail->getElifStmts()) {
+                if (const ElifStmtNode* taken = elifTaken(elif, frame)) {
+                    return exec(taken->getBlock(), frame);
+                }
+            }
+            if (const ElseStmtNode* otherwise = dynamic_cast<const ElseStmtNode*>(tail->getElseStmt())) {
+                return exec(otherwise->getBlock(), frame);
+            }
+            return Flow::Normal;
+        }
+        if (const WhileStatementNode* n = dynamic_cast<const WhileStatementNode*>(node)) {
+            std::fill_n(frame.hoisted + n->hoistFirst, n->hoistCount, Value());
+            Flow result = Flow::Normal;
+            while (truthy(eval(n->getCondition(), frame))) {
+                if (leavesLoop(exec(n->getBody(), frame), result)) {
+                    break;
+                }
+            }
+            return result;
+        }
+        if (const ForStatementNode* n = dynamic_cast<const ForStatementNode*>(node)) {
+            return forLoop(n, frame);
+        }
+        if (const MatchStmtNode* n = dynamic_cast<const MatchStmtNode*>(node)) {
+            return matchStatement(n, frame);
+        }
+        if (dynamic_cast<const BreakStmtNode*>(node)) {
+            return Flow::Break;
+        }
+        if (dynamic_cast<const ContinueStmtNode*>(node)) {
+            return Flow::Continue;
+        }
+        if (dynamic_cast<const PassStmtNode*>(node) || dynamic_cast<const GlobalStmtNode*>(node)) {
+            return Flow::Normal;
+        }
+        if (dynamic_cast<const PrimaryExpressionNode*>(node) || dynamic_cast<const FunctionCallNode*>(node)
+            || dynamic_cast<const ExpressionNode*>(node) || dynamic_cast<const ComparisonNode*>(node)) {
+            eval(node, frame);
+            return Flow::Normal;
+        }
+        fatal("NotImplementedError", "--run: statement '" + node->label + "'");
+    }
+};
+
+#endif
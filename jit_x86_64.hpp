@@ -0,0 +1,608 @@
+#ifndef JIT_X86_64_H
+#define JIT_X86_64_H
+
+#include "counted_loop.hpp"
+#include "switch_chain.hpp"
+#include "type_inference.hpp"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#include <sys/mman.h>
+#define PY_JIT_SUPPORTED 1
+#endif
+
+// Native entry point of a compiled function: args[i] is parameter i
+typedef int64_t (*JitEntry)(const int64_t* args);
+
+// Set by compiled code when an int operation overflows. Compiled functions are
+// free of side effects (they only touch their own frame and call other
+// compiled functions), so the caller can simply rerun the call in the
+// interpreter.
+inline unsigned char jitBailout = 0;
+
+// Baseline JIT: each supported node is translated by appending a fixed,
+// pre-assembled x86-64 template (operands patched in) to the code buffer. The
+// value of an expression is left in rax, binary operators keep the left
+// operand on the machine stack, and every local lives in a frame slot at
+// [rbp - 8 * (slot + 1)]. Only functions whose parameters, locals and result
+// TypeInference proved to be ints are accepted; they may use int arithmetic,
+// comparisons, if/elif/else, while, for over a literal range and calls to
+// other compilable functions.
+class JitCompiler {
+public:
+    JitCompiler(const SymbolTable& symbols, const TypeInference& types)
+        : symbols(symbols), types(types) {}
+
+    ~JitCompiler() {
+#ifdef PY_JIT_SUPPORTED
+        for (const auto& region : regions) {
+            munmap(region.first, region.second);
+        }
+#endif
+    }
+
+    // Compiles `function` (and the functions it calls). Returns nullptr and
+    // sets `reason` when some construct has no template.
+    JitEntry compile(const FunctionNode* function, std::string& reason) {
+        auto done = compiled.find(function);
+        if (done != compiled.end()) {
+            return done->second;
+        }
+#ifndef PY_JIT_SUPPORTED
+        reason = "no code generator for this platform";
+        return nullptr;
+#else
+        if (inProgress.count(function)) {
+            reason = "mutual recursion with '" + function->name + "'";
+            return nullptr;
+        }
+        inProgress.insert(function);
+        FunctionCodegen codegen(*this, function);
+        bool ok = codegen.generate();
+        inProgress.erase(function);
+        if (!ok) {
+            reason = codegen.error;
+            return nullptr;
+        }
+
+        size_t size = codegen.code.size();
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            reason = "cannot map executable memory";
+            return nullptr;
+        }
+        std::memcpy(memory, codegen.code.data(), size);
+        if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+            munmap(memory, size);
+            reason = "cannot map executable memory";
+            return nullptr;
+        }
+        regions.push_back({memory, size});
+        codeSizes[function] = size;
+        JitEntry entry = reinterpret_cast<JitEntry>(memory);
+        compiled[function] = entry;
+        return entry;
+#endif
+    }
+
+    size_t codeSize(const FunctionNode* function) const {
+        auto it = codeSizes.find(function);
+        return it == codeSizes.end() ? 0 : it->second;
+    }
+
+private:
+    const SymbolTable& symbols;
+    const TypeInference& types;
+    std::unordered_map<const FunctionNode*, JitEntry> compiled;
+    std::unordered_map<const FunctionNode*, size_t> codeSizes;
+    std::unordered_set<const FunctionNode*> inProgress;
+    std::vector<std::pair<void*, size_t>> regions;
+
+    // Condition codes of the jcc that is taken when the comparison is false
+    enum Cond : unsigned char {
+        JO = 0x80, JAE = 0x83, JE = 0x84, JNE = 0x85, JL = 0x8C, JGE = 0x8D, JLE = 0x8E, JG = 0x8F,
+    };
+
+    class FunctionCodegen {
+    public:
+        std::vector<unsigned char> code;
+        std::string error;
+
+        FunctionCodegen(JitCompiler& jit, const FunctionNode* function)
+            : jit(jit), function(function), scope(jit.symbols.scopeOf(function)) {}
+
+        bool generate() {
+            if (!scope || jit.types.returnType(function) != ValueType::Int) {
+                return fail("result is not provably an int");
+            }
+            for (const auto& sym : scope->symbols) {
+                if (sym.kind == NameKind::Local && jit.types.slotType(scope, sym.slot) != ValueType::Int) {
+                    return fail("'" + sym.name + "' is not provably an int");
+                }
+                if (sym.captured) {
+                    return fail("'" + sym.name + "' is captured by an inner function");
+                }
+            }
+            frameSlots = scope->numSlots;
+            bailLabel = newLabel();
+
+            // push rbp; mov rbp, rsp; sub rsp, imm32 (frame size patched below)
+            bytes({0x55, 0x48, 0x89, 0xE5, 0x48, 0x81, 0xEC});
+            size_t frameSizeAt = code.size();
+            imm32(0);
+            int param = 0;
+            if (Args* args = dynamic_cast<Args*>(function->getArgs())) {
+                for (const auto& arg : args->getArgs()) {
+                    IdentifierNode* id = dynamic_cast<IdentifierNode*>(arg);
+                    if (!id) {
+                        return fail("non-identifier parameter");
+                    }
+                    bytes({0x48, 0x8B, 0x87});                  // mov rax, [rdi + disp32]
+                    imm32(8 * param++);
+                    storeSlot(id->binding.slot);
+                }
+            }
+            for (const auto& sym : scope->symbols) {
+                if (sym.kind == NameKind::Local && !sym.isParam) {
+                    bytes({0x31, 0xC0});                        // xor eax, eax
+                    storeSlot(sym.slot);
+                }
+            }
+
+            if (!statement(function->getBody())) {
+                return false;
+            }
+            bytes({0x31, 0xC0, 0xC9, 0xC3});                    // xor eax, eax; leave; ret
+
+            // overflow or a bailed-out callee: raise the flag and unwind
+            bind(bailLabel);
+            movRcxImm64(reinterpret_cast<int64_t>(&jitBailout));
+            bytes({0xC6, 0x01, 0x01, 0xC9, 0xC3});              // mov byte [rcx], 1; leave; ret
+
+            int32_t frameBytes = 8 * ((frameSlots + 1) & ~1);   // keeps rsp 16-byte aligned
+            std::memcpy(&code[frameSizeAt], &frameBytes, 4);
+            for (const auto& label : labels) {
+                for (size_t at : label.fixups) {
+                    int32_t rel = (int32_t)(label.position - (at + 4));
+                    std::memcpy(&code[at], &rel, 4);
+                }
+            }
+            for (const auto& entry : tableEntries) {
+                int32_t rel = (int32_t)(labels[entry.target].position - labels[entry.table].position);
+                std::memcpy(&code[entry.at], &rel, 4);
+            }
+            return true;
+        }
+
+    private:
+        struct Label {
+            size_t position = 0;
+            std::vector<size_t> fixups;
+        };
+        struct Loop {
+            int continueLabel;
+            int breakLabel;
+        };
+        struct TableEntry {
+            size_t at;          // int32 in the code: target minus table start
+            int table;
+            int target;
+        };
+
+        JitCompiler& jit;
+        const FunctionNode* function;
+        const Scope* scope;
+        std::vector<Label> labels;
+        std::vector<Loop> loops;
+        std::vector<TableEntry> tableEntries;
+        int frameSlots = 0;
+        int pushDepth = 0;      // 8-byte temporaries currently pushed, for call alignment
+        int bailLabel = 0;
+
+        bool fail(const std::string& why) {
+            if (error.empty()) {
+                error = why;
+            }
+            return false;
+        }
+
+        void bytes(std::initializer_list<unsigned char> list) {
+            code.insert(code.end(), list.begin(), list.end());
+        }
+
+        void imm32(int32_t value) {
+            unsigned char raw[4];
+            std::memcpy(raw, &value, 4);
+            code.insert(code.end(), raw, raw + 4);
+        }
+
+        void imm64(int64_t value) {
+            unsigned char raw[8];
+            std::memcpy(raw, &value, 8);
+            code.insert(code.end(), raw, raw + 8);
+        }
+
+        int newLabel() {
+            labels.push_back(Label());
+            return labels.size() - 1;
+        }
+
+        void bind(int label) { labels[label].position = code.size(); }
+
+        void jump(int label) {
+            bytes({0xE9});                                      // jmp rel32
+            labels[label].fixups.push_back(code.size());
+            imm32(0);
+        }
+
+        void jumpIf(Cond cond, int label) {
+            bytes({0x0F, (unsigned char)cond});                 // jcc rel32
+            labels[label].fixups.push_back(code.size());
+            imm32(0);
+        }
+
+        void movRaxImm64(int64_t value) { bytes({0x48, 0xB8}); imm64(value); }
+        void movRcxImm64(int64_t value) { bytes({0x48, 0xB9}); imm64(value); }
+        void loadSlot(int slot) { bytes({0x48, 0x8B, 0x85}); imm32(-8 * (slot + 1)); }   // mov rax, [rbp+d]
+        void storeSlot(int slot) { bytes({0x48, 0x89, 0x85}); imm32(-8 * (slot + 1)); }  // mov [rbp+d], rax
+        void pushRax() { bytes({0x50}); ++pushDepth; }
+        void popRax() { bytes({0x58}); --pushDepth; }
+
+        // Evaluates left into rax and right into rcx
+        bool operands(const AstNode* left, const AstNode* right) {
+            if (!expression(left)) {
+                return false;
+            }
+            pushRax();
+            if (!expression(right)) {
+                return false;
+            }
+            bytes({0x48, 0x89, 0xC1});                          // mov rcx, rax
+            popRax();
+            return true;
+        }
+
+        bool call(const FunctionCallNode* node) {
+            const FunctionNode* callee = jit.types.calledFunction(node);
+            if (!callee) {
+                return fail("call of '" + node->getIdentifier() + "'");
+            }
+            std::vector<AstNode*> args;
+            for (const auto& arg : node->getArguments()) {
+                if (ArgumentsNode* list = dynamic_cast<ArgumentsNode*>(arg)) {
+                    args.insert(args.end(), list->getArguments().begin(), list->getArguments().end());
+                } else {
+                    args.push_back(arg);
+                }
+            }
+            const Scope* calleeScope = jit.symbols.scopeOf(callee);
+            int params = 0;
+            for (const auto& sym : calleeScope->symbols) {
+                params += sym.isParam;
+            }
+            if (params != (int)args.size()) {
+                return fail("call of '" + callee->name + "' with the wrong number of arguments");
+            }
+
+            JitEntry target = nullptr;
+            if (callee != function) {
+                std::string reason;
+                target = jit.compile(callee, reason);
+                if (!target) {
+                    return fail("calls '" + callee->name + "': " + reason);
+                }
+            }
+
+            // args are pushed last to first so that args[0] ends up at rsp
+            int padding = (pushDepth + (int)args.size()) % 2;
+            if (padding) {
+                bytes({0x48, 0x83, 0xEC, 0x08});                // sub rsp, 8
+                ++pushDepth;
+            }
+            for (size_t i = args.size(); i-- > 0;) {
+                if (!expression(args[i])) {
+                    return false;
+                }
+                pushRax();
+            }
+            bytes({0x48, 0x89, 0xE7});                          // mov rdi, rsp
+            if (target) {
+                movRaxImm64(reinterpret_cast<int64_t>(target));
+                bytes({0xFF, 0xD0});                            // call rax
+            } else {
+                bytes({0xE8});                                  // call rel32 to our own entry
+                imm32(-(int32_t)(code.size() + 4));
+            }
+            int popped = (int)args.size() + padding;
+            if (popped) {
+                bytes({0x48, 0x81, 0xC4});                      // add rsp, imm32
+                imm32(8 * popped);
+                pushDepth -= popped;
+            }
+            movRcxImm64(reinterpret_cast<int64_t>(&jitBailout));
+            bytes({0x80, 0x39, 0x00});                          // cmp byte [rcx], 0
+            jumpIf(JNE, bailLabel);
+            return true;
+        }
+
+        bool expression(const AstNode* node) {
+            if (const PrimaryExpressionNode* n = dynamic_cast<const PrimaryExpressionNode*>(node)) {
+                if (isIntLiteral(n->getValue())) {
+                    movRaxImm64(std::stoll(n->getValue()));
+                    return true;
+                }
+                if (n->binding.kind != NameKind::Local) {
+                    return fail(std::string(nameKindToString(n->binding.kind)) + " name '" + n->getValue() + "'");
+                }
+                loadSlot(n->binding.slot);
+                return true;
+            }
+            if (const FunctionCallNode* n = dynamic_cast<const FunctionCallNode*>(node)) {
+                return call(n);
+            }
+            if (const ExpressionNode* n = dynamic_cast<const ExpressionNode*>(node)) {
+                const std::string& op = n->getOp();
+                if (!n->getLeft()) {
+                    if (op != "-" || !expression(n->getRight())) {
+                        return fail("unary operator '" + op + "'");
+                    }
+                    bytes({0x48, 0xF7, 0xD8});                  // neg rax
+                    jumpIf(JO, bailLabel);
+                    return true;
+                }
+                if (op != "+" && op != "-" && op != "*") {
+                    return fail("operator '" + op + "'");
+                }
+                if (!operands(n->getLeft(), n->getRight())) {
+                    return false;
+                }
+                if (op == "+") {
+                    bytes({0x48, 0x01, 0xC8});                  // add rax, rcx
+                } else if (op == "-") {
+                    bytes({0x48, 0x29, 0xC8});                  // sub rax, rcx
+                } else {
+                    bytes({0x48, 0x0F, 0xAF, 0xC1});            // imul rax, rcx
+                }
+                jumpIf(JO, bailLabel);
+                return true;
+            }
+            return fail(node ? "expression '" + node->label + "'" : "empty expression");
+        }
+
+        // Falls through when the condition holds, jumps to `otherwise` if not
+        bool condition(const AstNode* node, int otherwise) {
+            if (const ComparisonNode* n = dynamic_cast<const ComparisonNode*>(node)) {
+                static const std::unordered_map<std::string, Cond> inverse = {
+                    {"<", JGE}, {">", JLE}, {"<=", JG}, {">=", JL}, {"==", JNE}, {"!=", JE},
+                };
+                auto cond = inverse.find(n->getOp());
+                if (cond == inverse.end()) {
+                    return fail("comparison '" + n->getOp() + "'");
+                }
+                if (!operands(n->getLeft(), n->getRight())) {
+                    return false;
+                }
+                bytes({0x48, 0x39, 0xC8});                      // cmp rax, rcx
+                jumpIf(cond->second, otherwise);
+                return true;
+            }
+            if (!expression(node)) {
+                return false;
+            }
+            bytes({0x48, 0x85, 0xC0});                          // test rax, rax
+            jumpIf(JE, otherwise);
+            return true;
+        }
+
+        // A dense if/elif chain on one name: rax - low indexes a table of
+        // int32 offsets from the table to each arm, stored in the code right
+        // after the indirect jump. Sparse chains keep their compares.
+        bool jumpTable(const SwitchChain& chain) {
+            if (!expression(chain.subject)) {
+                return false;
+            }
+            int table = newLabel(), otherwise = newLabel(), end = newLabel();
+            size_t size = (size_t)(chain.high - chain.low) + 1;
+            movRcxImm64(chain.low);
+            bytes({0x48, 0x29, 0xC8});                          // sub rax, rcx
+            bytes({0x48, 0x3D});                                // cmp rax, imm32
+            imm32((int32_t)size);
+            jumpIf(JAE, otherwise);
+            bytes({0x48, 0x8D, 0x0D});                          // lea rcx, [rip + table]
+            labels[table].fixups.push_back(code.size());
+            imm32(0);
+            bytes({0x48, 0x63, 0x04, 0x81});                    // movsxd rax, dword [rcx + rax*4]
+            bytes({0x48, 0x01, 0xC8});                          // add rax, rcx
+            bytes({0xFF, 0xE0});                                // jmp rax
+
+            bind(table);
+            std::vector<int> targets(size, otherwise);
+            std::vector<int> arms;
+            for (const auto& arm : chain.arms) {
+                arms.push_back(newLabel());
+                targets[(size_t)(arm.first - chain.low)] = arms.back();
+            }
+            for (int target : targets) {
+                tableEntries.push_back({code.size(), table, target});
+                imm32(0);
+            }
+            for (size_t i = 0; i < arms.size(); ++i) {
+                bind(arms[i]);
+                if (!statement(chain.arms[i].second)) {
+                    return false;
+                }
+                jump(end);
+            }
+            bind(otherwise);
+            if (!statement(chain.otherwise)) {
+                return false;
+            }
+            bind(end);
+            return true;
+        }
+
+        // Counted form: hidden slots hold the trips left and the induction
+        // value, copied to the target on every trip so that assignments to the
+        // target in the body do not change the sequence; a loop with no trips
+        // emits nothing
+        bool forRange(const ForStatementNode* loop) {
+            CountedLoop counted;
+            if (!lowerCountedLoop(loop, counted) || counted.target->binding.kind != NameKind::Local) {
+                return fail("for loop over anything but a literal range");
+            }
+            if (counted.step == 0) {
+                return fail("range() with a zero step");
+            }
+            if (counted.tripCount == 0) {
+                return true;
+            }
+
+            int remaining = frameSlots++;
+            int induction = frameSlots++;
+            int top = newLabel(), next = newLabel(), end = newLabel();
+            movRaxImm64(counted.tripCount);
+            storeSlot(remaining);
+            movRaxImm64(counted.start);
+            storeSlot(induction);
+            bind(top);
+            loadSlot(induction);
+            storeSlot(counted.target->binding.slot);
+            loops.push_back({next, end});
+            bool ok = statement(counted.body);
+            loops.pop_back();
+            if (!ok) {
+                return false;
+            }
+            bind(next);
+            bytes({0x48, 0xFF, 0x8D});                          // dec qword [rbp+d]
+            imm32(-8 * (remaining + 1));
+            jumpIf(JE, end);
+            loadSlot(induction);
+            movRcxImm64(counted.step);
+            bytes({0x48, 0x01, 0xC8});                          // add rax, rcx
+            storeSlot(induction);
+            jump(top);
+            bind(end);
+            return true;
+        }
+
+        bool elifChain(const AstNode* node, int end) {
+            if (const ElifStmtsNode* n = dynamic_cast<const ElifStmtsNode*>(node)) {
+                for (const auto& stmt : n->getElifStmts()) {
+                    if (!elifChain(stmt, end)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            const ElifStmtNode* n = dynamic_cast<const ElifStmtNode*>(node);
+            const ElifHeaderNode* header = n ? dynamic_cast<const ElifHeaderNode*>(n->getHeader()) : nullptr;
+            if (!header) {
+                return fail("malformed elif");
+            }
+            int next = newLabel();
+            if (!condition(header->getExpression(), next) || !statement(n->getBlock())) {
+                return false;
+            }
+            jump(end);
+            bind(next);
+            return true;
+        }
+
+        bool statement(const AstNode* node) {
+            if (!node) {
+                return true;
+            }
+            if (const StatementsNode* n = dynamic_cast<const StatementsNode*>(node)) {
+                for (const auto& stmt : n->getStatements()) {
+                    if (!statement(stmt)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            if (const assignmentStatement* n = dynamic_cast<const assignmentStatement*>(node)) {
+                const IdentifierNode* target = dynamic_cast<const IdentifierNode*>(n->getTarget());
+                if (!target || target->binding.kind != NameKind::Local) {
+                    return fail("assignment to a non-local name");
+                }
+                if (!expression(n->getValue())) {
+                    return false;
+                }
+                storeSlot(target->binding.slot);
+                return true;
+            }
+            if (const ReturnStatementNode* n = dynamic_cast<const ReturnStatementNode*>(node)) {
+                if (!n->getReturnValue() || !expression(n->getReturnValue())) {
+                    return fail("return without an int value");
+                }
+                bytes({0xC9, 0xC3});                            // leave; ret
+                return true;
+            }
+            if (const IfStatementNode* n = dynamic_cast<const IfStatementNode*>(node)) {
+                SwitchChain chain;
+                if (lowerSwitchChain(n, chain) && chain.dense()) {
+                    return jumpTable(chain);
+                }
+                const IfHeaderNode* header = dynamic_cast<const IfHeaderNode*>(n->getHeader());
+                int next = newLabel(), end = newLabel();
+                if (!header || !condition(header->getExpression(), next) || !statement(n->getBlock())) {
+                    return fail("malformed if");
+                }
+                jump(end);
+                bind(next);
+                if (const ElifElseNode* tail = dynamic_cast<const ElifElseNode*>(n->getElifElse())) {
+                    for (const auto& elif : tail->getElifStmts()) {
+                        if (!elifChain(elif, end)) {
+                            return false;
+                        }
+                    }
+                    if (const ElseStmtNode* otherwise = dynamic_cast<const ElseStmtNode*>(tail->getElseStmt())) {
+                        if (!statement(otherwise->getBlock())) {
+                            return false;
+                        }
+                    }
+                }
+                bind(end);
+                return true;
+            }
+            if (const WhileStatementNode* n = dynamic_cast<const WhileStatementNode*>(node)) {
+                int top = newLabel(), end = newLabel();
+                bind(top);
+                if (!condition(n->getCondition(), end)) {
+                    return false;
+                }
+                loops.push_back({top, end});
+                bool ok = statement(n->getBody());
+                loops.pop_back();
+                if (!ok) {
+                    return false;
+                }
+                jump(top);
+                bind(end);
+                return true;
+            }
+            if (const ForStatementNode* n = dynamic_cast<const ForStatementNode*>(node)) {
+                return forRange(n);
+            }
+            if (dynamic_cast<const BreakStmtNode*>(node) && !loops.empty()) {
+                jump(loops.back().breakLabel);
+                return true;
+            }
+            if (dynamic_cast<const ContinueStmtNode*>(node) && !loops.empty()) {
+                jump(loops.back().continueLabel);
+                return true;
+            }
+            if (dynamic_cast<const PassStmtNode*>(node)) {
+                return true;
+            }
+            return fail("statement '" + node->label + "'");
+        }
+    };
+};
+
+#endif
@@ -0,0 +1,553 @@
+#ifndef LOOP_INVARIANT_H
+#define LOOP_INVARIANT_H
+
+#include "python_ast_node.hpp"
+#include "scope_analysis.hpp"
+#include "task_scheduler.hpp"
+#include <algorithm>
+#include <memory>
+#include <ostream>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Loop-invariant code motion for `compiler --run`. For every while and for
+// loop it finds the largest expressions inside the loop (condition included)
+// whose operands the loop never changes: no assignment, for target, def or
+// match capture in the loop binds them, they are not shared with a closure,
+// and a global counts only when the loop calls no def, or no def assigns it,
+// and never in a loop that yields, since the consumer runs in between.
+// Each such expression gets a slot in the frame's hoisted values
+// (ExpressionNode::hoisted and friends); the loop clears its slots on
+// entry, the first evaluation fills the slot and later iterations read it.
+// Filling it on first use rather than ahead of the loop keeps a loop that
+// runs zero times, or a branch that is never taken, from raising an error
+// the unhoisted program would not. An expression invariant in an outer loop
+// too is hoisted to the outermost one.
+class LoopInvariantMotion {
+public:
+    explicit LoopInvariantMotion(const SymbolTable& symbols) : symbols(symbols) {}
+
+    void run(AstNode* root) {
+        findGlobalWrites(root);
+        walkFunction(root, symbols.module(), "<module>");
+        walkDeferred();
+    }
+
+    // Analyzes the module-level defs on the scheduler's workers (--jobs);
+    // the result is the same
+    void setScheduler(TaskScheduler* pool) { scheduler = pool; }
+
+    // Hoisted value slots a frame of this scope needs
+    int slotsOf(const Scope* scope) const {
+        auto it = slots.find(scope);
+        return it == slots.end() ? 0 : it->second;
+    }
+
+    // One line per loop, in source order within each function
+    void report(std::ostream& out) const {
+        for (const auto& loop : loops) {
+            out << "licm: " << loop.kind << " loop " << loop.number << " in " << loop.function << ": ";
+            if (!loop.opaque.empty()) {
+                out << "not analyzed (" << loop.opaque << ")" << std::endl;
+                continue;
+            }
+            if (loop.hoisted.empty()) {
+                out << "nothing invariant" << std::endl;
+                continue;
+            }
+            out << "hoisted ";
+            for (size_t i = 0; i < loop.hoisted.size(); ++i) {
+                out << (i ? ", " : "") << describe(loop.hoisted[i]);
+            }
+            out << std::endl;
+        }
+    }
+
+    // Python spelling of an expression, for the report
+    static std::string describe(const AstNode* node) {
+        if (const PrimaryExpressionNode* n = dynamic_cast<const PrimaryExpressionNode*>(node)) {
+            const std::string& value = n->getValue();
+            return value == "true" ? "True" : value == "false" ? "False" : value;
+        }
+        if (const ExpressionNode* n = dynamic_cast<const ExpressionNode*>(node)) {
+            if (!n->getLeft()) {
+                return n->getOp() + operand(n->getRight());
+            }
+            return operand(n->getLeft()) + " " + n->getOp() + " " + operand(n->getRight());
+        }
+        if (const ComparisonNode* n = dynamic_cast<const ComparisonNode*>(node)) {
+            return operand(n->getLeft()) + " " + n->getOp() + " " + operand(n->getRight());
+        }
+        if (const NegatedExpressionNode* n = dynamic_cast<const NegatedExpressionNode*>(node)) {
+            return "not " + operand(n->getOperand());
+        }
+        if (const FunctionCallNode* n = dynamic_cast<const FunctionCallNode*>(node)) {
+            std::string text = n->getIdentifier() + "(";
+            std::vector<AstNode*> args = arguments(n);
+            for (size_t i = 0; i < args.size(); ++i) {
+                text += (i ? ", " : "") + describe(args[i]);
+            }
+            return text + ")";
+        }
+        return node ? node->label : "?";
+    }
+
+private:
+    struct Loop {
+        AstNode* node = nullptr;
+        const char* kind = "";
+        int number = 0;
+        std::string function;
+        const Scope* scope = nullptr;
+        std::set<std::pair<int, int>> assigned;     // (NameKind, slot) bound somewhere in the loop
+        bool calls = false;                         // calls a def, which may rebind globals
+        bool suspends = false;                      // yields, so module code may rebind any global
+        std::string opaque;                         // statement the analysis does not know, if any
+        std::vector<AstNode*> hoisted;
+    };
+
+    const SymbolTable& symbols;
+    std::vector<Loop> loops;                        // every loop, by function then source order
+    std::unordered_map<const Scope*, int> slots;
+    std::set<int> rebindable;                       // global slots some def assigns
+    bool anyRebindable = false;                     // some def has a statement the analysis does not know
+    TaskScheduler* scheduler = nullptr;
+    std::vector<std::pair<FunctionNode*, size_t>> deferred;   // module-level defs and where their loops go
+
+    // State of the function being walked
+    const Scope* scope = nullptr;
+    std::set<int> capturedSlots;
+    std::vector<size_t> active;                     // enclosing loops, outermost first
+    std::string function;
+    int loopCount = 0;
+
+    static std::string operand(const AstNode* node) {
+        bool compound = dynamic_cast<const ComparisonNode*>(node) || dynamic_cast<const NegatedExpressionNode*>(node)
+            || (dynamic_cast<const ExpressionNode*>(node) && static_cast<const ExpressionNode*>(node)->getLeft());
+        return compound ? "(" + describe(node) + ")" : describe(node);
+    }
+
+    static std::vector<AstNode*> arguments(const FunctionCallNode* call) {
+        std::vector<AstNode*> args;
+        for (const auto& arg : call->getArguments()) {
+            if (ArgumentsNode* list = dynamic_cast<ArgumentsNode*>(arg)) {
+                args.insert(args.end(), list->getArguments().begin(), list->getArguments().end());
+            } else if (arg) {
+                args.push_back(arg);
+            }
+        }
+        return args;
+    }
+
+    void walkFunction(AstNode* body, const Scope* functionScope, const std::string& name) {
+        const Scope* outerScope = scope;
+        std::set<int> outerCaptured;
+        outerCaptured.swap(capturedSlots);
+        std::vector<size_t> outerActive;
+        outerActive.swap(active);
+        std::string outerFunction = function;
+        int outerCount = loopCount;
+
+        scope = functionScope;
+        function = name;
+        loopCount = 0;
+        for (const auto& sym : scope ? scope->symbols : std::vector<Symbol>()) {
+            if (sym.kind == NameKind::Local && sym.captured) {
+                capturedSlots.insert(sym.slot);
+            }
+        }
+        size_t firstLoop = loops.size();
+        statement(body);
+
+        // slots are numbered loop by loop, so each loop clears one range
+        int next = 0;
+        for (size_t i = firstLoop; i < loops.size(); ++i) {
+            Loop& loop = loops[i];
+            if (loop.scope != functionScope) {
+                continue;                           // a def nested in this one
+            }
+            int first = next;
+            for (AstNode* expression : loop.hoisted) {
+                stamp(expression, next++);
+            }
+            if (WhileStatementNode* n = dynamic_cast<WhileStatementNode*>(loop.node)) {
+                n->hoistFirst = first;
+                n->hoistCount = next - first;
+            } else if (ForStatementNode* n = dynamic_cast<ForStatementNode*>(loop.node)) {
+                n->hoistFirst = first;
+                n->hoistCount = next - first;
+            }
+        }
+        if (scope) {
+            slots[scope] = next;
+        }
+
+        scope = outerScope;
+        capturedSlots.swap(outerCaptured);
+        active.swap(outerActive);
+        function = outerFunction;
+        loopCount = outerCount;
+    }
+
+    // Nothing around a def changes its analysis, so each deferred one is
+    // walked by an instance of its own and its loops are spliced in where
+    // the serial walk would have put them
+    void walkDeferred() {
+        if (deferred.empty()) {
+            return;
+        }
+        std::vector<std::unique_ptr<LoopInvariantMotion>> parts(deferred.size());
+        scheduler->parallelFor(deferred.size(), [&](size_t i) {
+            FunctionNode* function = deferred[i].first;
+            parts[i].reset(new LoopInvariantMotion(symbols));
+            parts[i]->rebindable = rebindable;
+            parts[i]->anyRebindable = anyRebindable;
+            parts[i]->walkFunction(function->getBody(), symbols.scopeOf(function), "'" + function->name + "'");
+        });
+        std::vector<Loop> merged;
+        size_t next = 0;
+        for (size_t i = 0; i < deferred.size(); ++i) {
+            for (; next < deferred[i].second; ++next) {
+                merged.push_back(std::move(loops[next]));
+            }
+            for (Loop& loop : parts[i]->loops) {
+                merged.push_back(std::move(loop));
+            }
+            slots.insert(parts[i]->slots.begin(), parts[i]->slots.end());
+        }
+        for (; next < loops.size(); ++next) {
+            merged.push_back(std::move(loops[next]));
+        }
+        loops.swap(merged);
+        deferred.clear();
+    }
+
+    // Globals that calls could rebind: every global assigned inside a def
+    void findGlobalWrites(const AstNode* node) {
+        if (const StatementsNode* n = dynamic_cast<const StatementsNode*>(node)) {
+            for (const auto& stmt : n->getStatements()) {
+                findGlobalWrites(stmt);
+            }
+        } else if (const BlockNode* n = dynamic_cast<const BlockNode*>(node)) {
+            for (const auto& stmt : n->getStatements()) {
+                findGlobalWrites(stmt);
+            }
+        } else if (const FunctionNode* n = dynamic_cast<const FunctionNode*>(node)) {
+            Loop body;
+            effects(n->getBody(), body);
+            for (const auto& name : body.assigned) {
+                if (name.first == (int)NameKind::Global) {
+                    rebindable.insert(name.second);
+                }
+            }
+            anyRebindable = anyRebindable || !body.opaque.empty();
+            findGlobalWrites(n->getBody());
+        } else if (const IfStatementNode* n = dynamic_cast<const IfStatementNode*>(node)) {
+            findGlobalWrites(n->getBlock());
+            if (const ElifElseNode* tail = dynamic_cast<const ElifElseNode*>(n->getElifElse())) {
+                for (const auto& elif : tail->getElifStmts()) {
+                    findGlobalWrites(elif);
+                }
+                findGlobalWrites(tail->getElseStmt());
+            }
+        } else if (const ElifStmtsNode* n = dynamic_cast<const ElifStmtsNode*>(node)) {
+            for (const auto& stmt : n->getElifStmts()) {
+                findGlobalWrites(stmt);
+            }
+        } else if (const ElifStmtNode* n = dynamic_cast<const ElifStmtNode*>(node)) {
+            findGlobalWrites(n->getBlock());
+        } else if (const ElseStmtNode* n = dynamic_cast<const ElseStmtNode*>(node)) {
+            findGlobalWrites(n->getBlock());
+        } else if (const WhileStatementNode* n = dynamic_cast<const WhileStatementNode*>(node)) {
+            findGlobalWrites(n->getBody());
+        } else if (const ForStatementNode* n = dynamic_cast<const ForStatementNode*>(node)) {
+            findGlobalWrites(n->getBlock());
+        }
+    }
+
+    static void stamp(AstNode* node, int slot) {
+        if (ExpressionNode* n = dynamic_cast<ExpressionNode*>(node)) {
+            n->hoisted = slot;
+        } else if (ComparisonNode* n = dynamic_cast<ComparisonNode*>(node)) {
+            n->hoisted = slot;
+        } else if (NegatedExpressionNode* n = dynamic_cast<NegatedExpressionNode*>(node)) {
+            n->hoisted = slot;
+        }
+    }
+
+    // Records what the statements of a loop can change
+    void effects(const AstNode* node, Loop& loop) {
+        if (!node) {
+            return;
+        }
+        if (const StatementsNode* n = dynamic_cast<const StatementsNode*>(node)) {
+            for (const auto& stmt : n->getStatements()) {
+                effects(stmt, loop);
+            }
+        } else if (const BlockNode* n = dynamic_cast<const BlockNode*>(node)) {
+            for (const auto& stmt : n->getStatements()) {
+                effects(stmt, loop);
+            }
+        } else if (const assignmentStatement* n = dynamic_cast<const assignmentStatement*>(node)) {
+            const IdentifierNode* target = dynamic_cast<const IdentifierNode*>(n->getTarget());
+            if (!target) {
+                loop.opaque = "assignment to '" + n->getTarget()->label + "'";
+                return;
+            }
+            loop.assigned.insert(std::make_pair((int)target->binding.kind, target->binding.slot));
+            effects(n->getValue(), loop);
+        } else if (const FunctionNode* n = dynamic_cast<const FunctionNode*>(node)) {
+            loop.assigned.insert(std::make_pair((int)n->binding.kind, n->binding.slot));
+        } else if (const ReturnStatementNode* n = dynamic_cast<const ReturnStatementNode*>(node)) {
+            effects(n->getReturnValue(), loop);
+        } else if (const IfStatementNode* n = dynamic_cast<const IfStatementNode*>(node)) {
+            const IfHeaderNode* header = dynamic_cast<const IfHeaderNode*>(n->getHeader());
+            effects(header ? header->getExpression() : nullptr, loop);
+            effects(n->getBlock(), loop);
+            if (const ElifElseNode* tail = dynamic_cast<const ElifElseNode*>(n->getElifElse())) {
+                for (const auto& elif : tail->getElifStmts()) {
+                    effects(elif, loop);
+                }
+                effects(tail->getElseStmt(), loop);
+            }
+        } else if (const ElifStmtsNode* n = dynamic_cast<const ElifStmtsNode*>(node)) {
+            for (const auto& stmt : n->getElifStmts()) {
+                effects(stmt, loop);
+            }
+        } else if (const ElifStmtNode* n = dynamic_cast<const ElifStmtNode*>(node)) {
+            const ElifHeaderNode* header = dynamic_cast<const ElifHeaderNode*>(n->getHeader());
+            effects(header ? header->getExpression() : nullptr, loop);
+            effects(n->getBlock(), loop);
+        } else if (const ElseStmtNode* n = dynamic_cast<const ElseStmtNode*>(node)) {
+            effects(n->getBlock(), loop);
+        } else if (const WhileStatementNode* n = dynamic_cast<const WhileStatementNode*>(node)) {
+            effects(n->getCondition(), loop);
+            effects(n->getBody(), loop);
+        } else if (const ForStatementNode* n = dynamic_cast<const ForStatementNode*>(node)) {
+            const ForHeaderNode* header = dynamic_cast<const ForHeaderNode*>(n->getHeader());
+            if (header) {
+                loop.assigned.insert(std::make_pair((int)header->binding.kind, header->binding.slot));
+            }
+            const ChangesNode* changes = dynamic_cast<const ChangesNode*>(n->getChanges());
+            if (changes && (!changes->getRange() || dynamic_cast<const MyFuncNode*>(changes->getRange()))) {
+                loop.calls = true;                  // range(f) calls f, a generator runs its def
+            }
+            effects(n->getBlock(), loop);
+        } else if (const MatchStmtNode* n = dynamic_cast<const MatchStmtNode*>(node)) {
+            effects(n->getExpression(), loop);
+            effects(n->getMatchCases(), loop);
+        } else if (const MatchCasesNode* n = dynamic_cast<const MatchCasesNode*>(node)) {
+            for (const auto& matchCase : n->getMatchCases()) {
+                effects(matchCase, loop);
+            }
+        } else if (const MatchCaseNode* n = dynamic_cast<const MatchCaseNode*>(node)) {
+            effects(n->getPatternList(), loop);
+            effects(n->getSimpleStmt(), loop);
+        } else if (const PatternListNode* n = dynamic_cast<const PatternListNode*>(node)) {
+            for (const auto& pattern : n->getPatterns()) {
+                effects(pattern, loop);
+            }
+        } else if (const PatternNode* n = dynamic_cast<const PatternNode*>(node)) {
+            const PrimaryExpressionNode* capture = dynamic_cast<const PrimaryExpressionNode*>(n->getExpression());
+            if (capture && capture->constant < 0) {
+                loop.assigned.insert(std::make_pair((int)capture->binding.kind, capture->binding.slot));
+            }
+        } else if (const ListPatternNode* n = dynamic_cast<const ListPatternNode*>(node)) {
+            effects(n->getPatternList(), loop);
+        } else if (const DictPatternNode* n = dynamic_cast<const DictPatternNode*>(node)) {
+            effects(n->getEntries(), loop);
+        } else if (const DictPatternEntriesNode* n = dynamic_cast<const DictPatternEntriesNode*>(node)) {
+            for (const auto& entry : n->getEntries()) {
+                effects(entry, loop);
+            }
+        } else if (const DictPatternEntryNode* n = dynamic_cast<const DictPatternEntryNode*>(node)) {
+            effects(n->getValue(), loop);
+        } else if (const YieldStmtNode* n = dynamic_cast<const YieldStmtNode*>(node)) {
+            loop.suspends = true;
+            effects(n->getExpression(), loop);
+        } else if (const FunctionCallNode* n = dynamic_cast<const FunctionCallNode*>(node)) {
+            if (n->binding.kind != NameKind::Builtin) {
+                loop.calls = true;
+            }
+            for (const auto& arg : arguments(n)) {
+                effects(arg, loop);
+            }
+        } else if (const ExpressionNode* n = dynamic_cast<const ExpressionNode*>(node)) {
+            effects(n->getLeft(), loop);
+            effects(n->getRight(), loop);
+        } else if (const ComparisonNode* n = dynamic_cast<const ComparisonNode*>(node)) {
+            effects(n->getLeft(), loop);
+            effects(n->getRight(), loop);
+        } else if (const NegatedExpressionNode* n = dynamic_cast<const NegatedExpressionNode*>(node)) {
+            effects(n->getOperand(), loop);
+        } else if (!dynamic_cast<const PrimaryExpressionNode*>(node) && !dynamic_cast<const BreakStmtNode*>(node)
+                   && !dynamic_cast<const ContinueStmtNode*>(node) && !dynamic_cast<const PassStmtNode*>(node)
+                   && !dynamic_cast<const GlobalStmtNode*>(node) && !dynamic_cast<const LiteralNode*>(node)) {
+            loop.opaque = "statement '" + node->label + "'";
+        }
+    }
+
+    // Number of enclosing loops, counted from the outermost, in which a name
+    // may change: the expression can be hoisted to the loop at that depth
+    size_t nameLevel(const PrimaryExpressionNode* name) const {
+        const NameBinding& binding = name->binding;
+        std::pair<int, int> key((int)binding.kind, binding.slot);
+        bool alwaysVariant = binding.kind == NameKind::Nonlocal || binding.kind == NameKind::Free
+            || binding.kind == NameKind::Unresolved
+            || (binding.kind == NameKind::Local && capturedSlots.count(binding.slot));
+        size_t level = 0;
+        for (size_t i = 0; i < active.size(); ++i) {
+            const Loop& loop = loops[active[i]];
+            if (alwaysVariant || !loop.opaque.empty() || loop.assigned.count(key)
+                || (binding.kind == NameKind::Global
+                    && (loop.suspends || (loop.calls && (anyRebindable || rebindable.count(binding.slot)))))) {
+                level = i + 1;
+            }
+        }
+        return level;
+    }
+
+    // Level of an expression (see nameLevel); hoists the invariant operands
+    // of a variant expression to the loops they are invariant in
+    size_t level(AstNode* node) {
+        if (!node || active.empty()) {
+            return 0;
+        }
+        if (PrimaryExpressionNode* n = dynamic_cast<PrimaryExpressionNode*>(node)) {
+            return n->constant >= 0 ? 0 : nameLevel(n);
+        }
+        std::vector<AstNode*> operands;
+        size_t result = 0;
+        if (FunctionCallNode* n = dynamic_cast<FunctionCallNode*>(node)) {
+            operands = arguments(n);
+            result = active.size();                 // a call is never hoisted
+        } else if (ExpressionNode* n = dynamic_cast<ExpressionNode*>(node)) {
+            operands = {n->getLeft(), n->getRight()};
+        } else if (ComparisonNode* n = dynamic_cast<ComparisonNode*>(node)) {
+            operands = {n->getLeft(), n->getRight()};
+        } else if (NegatedExpressionNode* n = dynamic_cast<NegatedExpressionNode*>(node)) {
+            operands = {n->getOperand()};
+        } else {
+            return active.size();
+        }
+        std::vector<size_t> levels;
+        for (AstNode* op : operands) {
+            levels.push_back(level(op));
+            result = std::max(result, levels.back());
+        }
+        for (size_t i = 0; i < operands.size(); ++i) {
+            if (levels[i] < result) {
+                hoist(operands[i], levels[i]);
+            }
+        }
+        return result;
+    }
+
+    // Expression evaluated on every iteration of the innermost active loop
+    void expression(AstNode* node) {
+        size_t at = level(node);
+        if (at < active.size()) {
+            hoist(node, at);
+        }
+    }
+
+    void hoist(AstNode* node, size_t at) {
+        ExpressionNode* negated = dynamic_cast<ExpressionNode*>(node);
+        bool worthIt = (negated && (negated->getLeft() || !dynamic_cast<PrimaryExpressionNode*>(negated->getRight())))
+            || dynamic_cast<ComparisonNode*>(node) || dynamic_cast<NegatedExpressionNode*>(node);
+        if (worthIt) {
+            loops[active[at]].hoisted.push_back(node);
+        }
+    }
+
+    void loop(AstNode* node, const char* kind, AstNode* condition, AstNode* body) {
+        Loop info;
+        info.node = node;
+        info.kind = kind;
+        info.number = ++loopCount;
+        info.function = function;
+        info.scope = scope;
+        if (ForStatementNode* n = dynamic_cast<ForStatementNode*>(node)) {
+            effects(n, info);                       // the target changes on every trip
+        } else {
+            effects(condition, info);
+            effects(body, info);
+        }
+        loops.push_back(info);
+        active.push_back(loops.size() - 1);
+        if (condition) {
+            expression(condition);
+        }
+        statement(body);
+        active.pop_back();
+    }
+
+    void statement(AstNode* node) {
+        if (!node) {
+            return;
+        }
+        if (StatementsNode* n = dynamic_cast<StatementsNode*>(node)) {
+            for (const auto& stmt : n->getStatements()) {
+                statement(stmt);
+            }
+        } else if (BlockNode* n = dynamic_cast<BlockNode*>(node)) {
+            for (const auto& stmt : n->getStatements()) {
+                statement(stmt);
+            }
+        } else if (assignmentStatement* n = dynamic_cast<assignmentStatement*>(node)) {
+            expression(n->getValue());
+        } else if (FunctionNode* n = dynamic_cast<FunctionNode*>(node)) {
+            if (scheduler && scope == symbols.module()) {
+                deferred.push_back(std::make_pair(n, loops.size()));
+            } else {
+                walkFunction(n->getBody(), symbols.scopeOf(n), "'" + n->name + "'");
+            }
+        } else if (ReturnStatementNode* n = dynamic_cast<ReturnStatementNode*>(node)) {
+            expression(n->getReturnValue());
+        } else if (YieldStmtNode* n = dynamic_cast<YieldStmtNode*>(node)) {
+            expression(n->getExpression());
+        } else if (IfStatementNode* n = dynamic_cast<IfStatementNode*>(node)) {
+            IfHeaderNode* header = dynamic_cast<IfHeaderNode*>(n->getHeader());
+            expression(header ? header->getExpression() : nullptr);
+            statement(n->getBlock());
+            if (ElifElseNode* tail = dynamic_cast<ElifElseNode*>(n->getElifElse())) {
+                for (const auto& elif : tail->getElifStmts()) {
+                    statement(elif);
+                }
+                statement(tail->getElseStmt());
+            }
+        } else if (ElifStmtsNode* n = dynamic_cast<ElifStmtsNode*>(node)) {
+            for (const auto& stmt : n->getElifStmts()) {
+                statement(stmt);
+            }
+        } else if (ElifStmtNode* n = dynamic_cast<ElifStmtNode*>(node)) {
+            ElifHeaderNode* header = dynamic_cast<ElifHeaderNode*>(n->getHeader());
+            expression(header ? header->getExpression() : nullptr);
+            statement(n->getBlock());
+        } else if (ElseStmtNode* n = dynamic_cast<ElseStmtNode*>(node)) {
+            statement(n->getBlock());
+        } else if (WhileStatementNode* n = dynamic_cast<WhileStatementNode*>(node)) {
+            loop(n, "while", n->getCondition(), n->getBody());
+        } else if (ForStatementNode* n = dynamic_cast<ForStatementNode*>(node)) {
+            loop(n, "for", nullptr, n->getBlock());
+        } else if (MatchStmtNode* n = dynamic_cast<MatchStmtNode*>(node)) {
+            expression(n->getExpression());
+            if (MatchCasesNode* cases = dynamic_cast<MatchCasesNode*>(n->getMatchCases())) {
+                for (const auto& c : cases->getMatchCases()) {
+                    if (MatchCaseNode* matchCase = dynamic_cast<MatchCaseNode*>(c)) {
+                        statement(matchCase->getSimpleStmt());
+                    }
+                }
+            }
+        } else if (dynamic_cast<PrimaryExpressionNode*>(node) || dynamic_cast<FunctionCallNode*>(node)
+                   || dynamic_cast<ExpressionNode*>(node) || dynamic_cast<ComparisonNode*>(node)
+                   || dynamic_cast<NegatedExpressionNode*>(node)) {
+            expression(node);
+        }
+    }
+};
+
+#endif
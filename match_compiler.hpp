@@ -0,0 +1,435 @@
+#ifndef MATCH_COMPILER_H
+#define MATCH_COMPILER_H
+
+#include "python_ast_node.hpp"
+#include "scope_analysis.hpp"
+#include "value.hpp"
+#include <cmath>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// One case pattern, lifted out of the PatternNode / ListPatternNode /
+// DictPatternNode it was parsed as. `case a, b:` with more than one pattern
+// is a sequence pattern, as in Python.
+struct MatchPattern {
+    enum class Kind { Wildcard, Capture, Literal, Sequence, Mapping };
+
+    Kind kind = Kind::Wildcard;
+    bool required = false;                          // a mapping entry: the key has to be present
+    const PrimaryExpressionNode* capture = nullptr;
+    Value literal;
+    std::vector<MatchPattern> items;                // Sequence items, Mapping values
+    std::vector<Value> keys;                        // Mapping keys, one per item
+
+    bool irrefutable() const { return (kind == Kind::Wildcard || kind == Kind::Capture) && !required; }
+};
+
+// Decision tree node. A Switch tests the value in one register once and
+// picks the branch for its class: the hash tables hold every literal tested
+// at that position, `lengths` every sequence length and `mapping` the branch
+// for mapping subjects, whose keys are each looked up once into registers.
+// A Present node tests whether a looked-up key was found (the register holds
+// an unbound Value when it was not).
+struct MatchNode {
+    enum class Kind { Fail, Leaf, Switch, Present };
+
+    struct Sequence {
+        int firstRegister = 0;                      // items land in firstRegister...+length-1
+        MatchNode* next = nullptr;
+    };
+
+    Kind kind = Kind::Fail;
+    int reg = 0;
+
+    // Leaf
+    int caseIndex = -1;
+    std::vector<std::pair<const PrimaryExpressionNode*, int>> bindings;
+
+    // Switch
+    std::unordered_map<int64_t, MatchNode*> ints;          // ints and integral floats
+    std::vector<std::pair<double, MatchNode*>> floats;     // other floats, compared with ==
+    std::unordered_map<uint64_t, MatchNode*> singletons;   // True, False, None by raw bits
+    std::unordered_map<int64_t, Sequence> lengths;
+    std::vector<Value> mappingKeys;
+    int mappingFirstRegister = 0;
+    MatchNode* mapping = nullptr;
+    MatchNode* otherwise = nullptr;
+
+    // Present
+    MatchNode* present = nullptr;
+    MatchNode* absent = nullptr;
+};
+
+// A compiled match statement. Register 0 holds the subject.
+struct MatchTree {
+    std::vector<std::unique_ptr<MatchNode>> nodes;
+    std::vector<const AstNode*> bodies;             // simple_stmt of each case, by case index
+    std::vector<MatchPattern> patterns;             // top-level pattern of each case
+    MatchNode* root = nullptr;
+    int numRegisters = 1;
+};
+
+// Compiles the flat case list of a MatchStmtNode into a decision tree
+// (pattern-matrix compilation): each step takes the first column the
+// highest-priority remaining case actually tests and switches on the value
+// there once, specializing every case for each outcome. Cases that agree on
+// a test share it, so a subject is examined at most once per position no
+// matter how many cases mention it. Literals are decoded through the
+// interpreter's constant pool.
+class MatchCompiler {
+public:
+    explicit MatchCompiler(const std::vector<Value>& constants) : constants(constants) {}
+
+    // The int a subject equals, for the int-literal table: ints, bools and
+    // floats with an integral value
+    static bool intKey(const Value& subject, int64_t& key) {
+        if (subject.isInt() || subject.isBool()) {
+            key = subject.asInt();
+            return true;
+        }
+        if (subject.isDouble()) {
+            double d = subject.asDouble();
+            if (d == std::trunc(d) && d >= -9223372036854775808.0 && d < 9223372036854775808.0) {
+                key = (int64_t)d;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // The int table's key for a literal pattern: ints and floats with an
+    // integral value, so that `case 2.0:` is `case 2:`. Not bools, which
+    // are singletons.
+    static bool literalKey(const Value& literal, int64_t& key) {
+        return !literal.isBool() && intKey(literal, key);
+    }
+
+    // Whether a literal pattern accepts `subject`: numbers compare by value,
+    // as == does, so `case 1:` takes True and 1.0 and `case 0.0:` takes
+    // -0.0, but `case True:` and `case None:` are identity tests
+    static bool literalMatches(const Value& literal, const Value& subject) {
+        int64_t key;
+        int64_t subjectKey;
+        if (literalKey(literal, key)) {
+            return intKey(subject, subjectKey) && subjectKey == key;
+        }
+        if (literal.isDouble()) {
+            return subject.isNumber() && subject.toDouble() == literal.asDouble();
+        }
+        return literal.raw() == subject.raw();
+    }
+
+    // False with `reason` set when a pattern is not one the tree supports
+    bool compile(const MatchStmtNode* match, MatchTree& tree, std::string& reason) {
+        const MatchCasesNode* cases = dynamic_cast<const MatchCasesNode*>(match->getMatchCases());
+        if (!cases) {
+            reason = "match without cases";
+            return false;
+        }
+        std::vector<Row> rows;
+        for (const auto& node : cases->getMatchCases()) {
+            const MatchCaseNode* matchCase = dynamic_cast<const MatchCaseNode*>(node);
+            MatchPattern pattern;
+            if (!matchCase || !lowerPatternList(matchCase->getPatternList(), true, pattern, reason)) {
+                return false;
+            }
+            Row row;
+            row.caseIndex = (int)tree.bodies.size();
+            row.columns.push_back(pattern);
+            rows.push_back(row);
+            tree.bodies.push_back(matchCase->getSimpleStmt());
+            tree.patterns.push_back(pattern);
+        }
+        out = &tree;
+        tree.root = build(std::vector<int>(1, 0), rows);
+        return true;
+    }
+
+private:
+    struct Row {
+        std::vector<MatchPattern> columns;          // one per live register
+        int caseIndex = -1;
+        std::vector<std::pair<const PrimaryExpressionNode*, int>> bindings;
+    };
+
+    const std::vector<Value>& constants;
+    MatchTree* out = nullptr;
+
+    bool lowerPatternList(const AstNode* node, bool topLevel, MatchPattern& pattern, std::string& reason) {
+        const PatternListNode* list = dynamic_cast<const PatternListNode*>(node);
+        if (!list) {
+            reason = "malformed pattern list";
+            return false;
+        }
+        if (topLevel && list->getPatterns().size() == 1) {
+            return lowerPattern(list->getPatterns()[0], pattern, reason);
+        }
+        pattern.kind = MatchPattern::Kind::Sequence;
+        for (const auto& item : list->getPatterns()) {
+            pattern.items.push_back(MatchPattern());
+            if (!lowerPattern(item, pattern.items.back(), reason)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool lowerPattern(const AstNode* node, MatchPattern& pattern, std::string& reason) {
+        if (const ListPatternNode* n = dynamic_cast<const ListPatternNode*>(node)) {
+            return lowerPatternList(n->getPatternList(), false, pattern, reason);
+        }
+        if (const DictPatternNode* n = dynamic_cast<const DictPatternNode*>(node)) {
+            pattern.kind = MatchPattern::Kind::Mapping;
+            const DictPatternEntriesNode* entries = dynamic_cast<const DictPatternEntriesNode*>(n->getEntries());
+            for (const auto& e : entries ? entries->getEntries() : std::vector<AstNode*>()) {
+                const DictPatternEntryNode* entry = dynamic_cast<const DictPatternEntryNode*>(e);
+                MatchPattern key;
+                if (!entry || !lowerPattern(entry->getKey(), key, reason)) {
+                    return false;
+                }
+                if (key.kind != MatchPattern::Kind::Literal) {
+                    reason = "mapping pattern key is not a literal";
+                    return false;
+                }
+                for (const auto& seen : pattern.keys) {
+                    if (seen.raw() == key.literal.raw()) {
+                        reason = "mapping pattern checks the same key twice";
+                        return false;
+                    }
+                }
+                pattern.keys.push_back(key.literal);
+                pattern.items.push_back(MatchPattern());
+                if (!lowerPattern(entry->getValue(), pattern.items.back(), reason)) {
+                    return false;
+                }
+                pattern.items.back().required = true;
+            }
+            return true;
+        }
+        const PatternNode* n = dynamic_cast<const PatternNode*>(node);
+        if (!n) {
+            reason = "unknown pattern '" + (node ? node->label : std::string("?")) + "'";
+            return false;
+        }
+        const AstNode* expression = n->getExpression();
+        if (dynamic_cast<const LiteralNode*>(expression)) {
+            pattern.kind = MatchPattern::Kind::Wildcard;
+            return true;
+        }
+        if (const PrimaryExpressionNode* p = dynamic_cast<const PrimaryExpressionNode*>(expression)) {
+            if (p->constant >= 0) {
+                pattern.kind = MatchPattern::Kind::Literal;
+                pattern.literal = constants[p->constant];
+                return true;
+            }
+            pattern.kind = MatchPattern::Kind::Capture;
+            pattern.capture = p;
+            return true;
+        }
+        // `case -1:`
+        const ExpressionNode* negated = dynamic_cast<const ExpressionNode*>(expression);
+        const PrimaryExpressionNode* operand =
+            negated && !negated->getLeft() && negated->getOp() == "-"
+                ? dynamic_cast<const PrimaryExpressionNode*>(negated->getRight()) : nullptr;
+        if (operand && operand->constant >= 0 && constants[operand->constant].isSmallInt()) {
+            pattern.kind = MatchPattern::Kind::Literal;
+            pattern.literal = Value::smallInt(-constants[operand->constant].asInt());
+            return true;
+        }
+        reason = "pattern '" + (expression ? expression->label : std::string("?")) + "' is not a literal or a name";
+        return false;
+    }
+
+    MatchNode* newNode(MatchNode::Kind kind, int reg) {
+        out->nodes.push_back(std::unique_ptr<MatchNode>(new MatchNode()));
+        MatchNode* node = out->nodes.back().get();
+        node->kind = kind;
+        node->reg = reg;
+        return node;
+    }
+
+    // A copy of `row` with column `c` removed; a capture there binds its register
+    static Row without(const Row& row, size_t c, int reg) {
+        Row copy = row;
+        if (row.columns[c].kind == MatchPattern::Kind::Capture) {
+            copy.bindings.push_back(std::make_pair(row.columns[c].capture, reg));
+        }
+        copy.columns.erase(copy.columns.begin() + c);
+        return copy;
+    }
+
+    static std::vector<int> withoutRegister(std::vector<int> regs, size_t c) {
+        regs.erase(regs.begin() + c);
+        return regs;
+    }
+
+    MatchNode* build(const std::vector<int>& regs, const std::vector<Row>& rows) {
+        if (rows.empty()) {
+            return newNode(MatchNode::Kind::Fail, 0);
+        }
+        const Row& first = rows[0];
+        size_t c = 0;
+        while (c < first.columns.size() && first.columns[c].irrefutable()) {
+            ++c;
+        }
+        if (c == first.columns.size()) {
+            MatchNode* leaf = newNode(MatchNode::Kind::Leaf, 0);
+            leaf->caseIndex = first.caseIndex;
+            leaf->bindings = first.bindings;
+            for (size_t i = 0; i < first.columns.size(); ++i) {
+                if (first.columns[i].kind == MatchPattern::Kind::Capture) {
+                    leaf->bindings.push_back(std::make_pair(first.columns[i].capture, regs[i]));
+                }
+            }
+            return leaf;
+        }
+
+        int reg = regs[c];
+        bool anyRequired = false;
+        for (const auto& row : rows) {
+            anyRequired = anyRequired || row.columns[c].required;
+        }
+        if (anyRequired) {
+            // the key was looked up for a mapping: test for it once, then
+            // every case that names it can assume it is there
+            MatchNode* node = newNode(MatchNode::Kind::Present, reg);
+            std::vector<Row> present = rows;
+            std::vector<Row> absent;
+            for (auto& row : present) {
+                row.columns[c].required = false;
+            }
+            for (const auto& row : rows) {
+                if (!row.columns[c].required) {
+                    absent.push_back(without(row, c, reg));
+                }
+            }
+            node->present = build(regs, present);
+            node->absent = build(withoutRegister(regs, c), absent);
+            return node;
+        }
+
+        MatchNode* node = newNode(MatchNode::Kind::Switch, reg);
+        std::vector<Value> literals;
+        std::vector<int64_t> lengths;
+        bool mapping = false;
+        for (const auto& row : rows) {
+            const MatchPattern& p = row.columns[c];
+            if (p.kind == MatchPattern::Kind::Literal) {
+                literals.push_back(p.literal);
+                int64_t key;
+                if (literalKey(p.literal, key) && (key == 0 || key == 1)) {
+                    literals.push_back(Value::boolean(key == 1));
+                }
+            } else if (p.kind == MatchPattern::Kind::Sequence) {
+                lengths.push_back((int64_t)p.items.size());
+            } else if (p.kind == MatchPattern::Kind::Mapping) {
+                for (const auto& key : p.keys) {
+                    bool seen = false;
+                    for (const auto& k : node->mappingKeys) {
+                        seen = seen || k.raw() == key.raw();
+                    }
+                    if (!seen) {
+                        node->mappingKeys.push_back(key);
+                    }
+                }
+                mapping = true;
+            }
+        }
+
+        std::vector<int> dropped = withoutRegister(regs, c);
+        for (const auto& literal : literals) {
+            int64_t key;
+            bool isInt = literalKey(literal, key);
+            bool isFloat = !isInt && literal.isDouble();
+            bool seen = false;
+            for (const auto& f : node->floats) {
+                seen = seen || (isFloat && f.first == literal.asDouble());
+            }
+            if (seen || (isInt ? node->ints.count(key) : !isFloat && node->singletons.count(literal.raw()))) {
+                continue;
+            }
+            std::vector<Row> specialized;
+            for (const auto& row : rows) {
+                const MatchPattern& p = row.columns[c];
+                if (p.irrefutable() || (p.kind == MatchPattern::Kind::Literal && literalMatches(p.literal, literal))) {
+                    specialized.push_back(without(row, c, reg));
+                }
+            }
+            MatchNode* branch = build(dropped, specialized);
+            if (isInt) {
+                node->ints[key] = branch;
+            } else if (isFloat) {
+                node->floats.push_back(std::make_pair(literal.asDouble(), branch));
+            } else {
+                node->singletons[literal.raw()] = branch;
+            }
+        }
+        for (int64_t length : lengths) {
+            if (node->lengths.count(length)) {
+                continue;
+            }
+            MatchNode::Sequence sequence;
+            sequence.firstRegister = out->numRegisters;
+            out->numRegisters += (int)length;
+            std::vector<int> itemRegs = dropped;
+            for (int64_t i = 0; i < length; ++i) {
+                itemRegs.push_back(sequence.firstRegister + (int)i);
+            }
+            std::vector<Row> specialized;
+            for (const auto& row : rows) {
+                const MatchPattern& p = row.columns[c];
+                if (p.irrefutable()) {
+                    Row r = without(row, c, reg);
+                    r.columns.resize(r.columns.size() + length);
+                    specialized.push_back(r);
+                } else if (p.kind == MatchPattern::Kind::Sequence && (int64_t)p.items.size() == length) {
+                    Row r = without(row, c, reg);
+                    r.columns.insert(r.columns.end(), p.items.begin(), p.items.end());
+                    specialized.push_back(r);
+                }
+            }
+            sequence.next = build(itemRegs, specialized);
+            node->lengths[length] = sequence;
+        }
+        if (mapping) {
+            node->mappingFirstRegister = out->numRegisters;
+            out->numRegisters += (int)node->mappingKeys.size();
+            std::vector<int> keyRegs = dropped;
+            for (size_t i = 0; i < node->mappingKeys.size(); ++i) {
+                keyRegs.push_back(node->mappingFirstRegister + (int)i);
+            }
+            std::vector<Row> specialized;
+            for (const auto& row : rows) {
+                const MatchPattern& p = row.columns[c];
+                if (!p.irrefutable() && p.kind != MatchPattern::Kind::Mapping) {
+                    continue;
+                }
+                Row r = without(row, c, reg);
+                for (const auto& key : node->mappingKeys) {
+                    MatchPattern entry;                 // keys the case does not name may be absent
+                    for (size_t i = 0; i < p.keys.size(); ++i) {
+                        if (p.keys[i].raw() == key.raw()) {
+                            entry = p.items[i];
+                        }
+                    }
+                    r.columns.push_back(entry);
+                }
+                specialized.push_back(r);
+            }
+            node->mapping = build(keyRegs, specialized);
+        }
+        std::vector<Row> fallback;
+        for (const auto& row : rows) {
+            if (row.columns[c].irrefutable()) {
+                fallback.push_back(without(row, c, reg));
+            }
+        }
+        node->otherwise = build(dropped, fallback);
+        return node;
+    }
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef MEM_AUDIT_H
+#define MEM_AUDIT_H
+
+#include "python_ast_node.hpp"
+#include <cstddef>
+#include <malloc.h>
+#include <ostream>
+#include <vector>
+
+// `--mem-audit`: what one compile leaves allocated once it is over. Made
+// before the compile's arena, it takes stock of the live nodes and the heap
+// in use, and when it goes, after the arena and everything else the compile
+// allocated, it reports the nodes the compile made and freed, the ones still
+// alive by kind and how far the heap moved. Under --serve every request is
+// audited on its own, so a resident process can be watched staying flat:
+// past the first few requests the heap should stop growing.
+class MemAudit {
+public:
+    explicit MemAudit(std::ostream* report)
+        : report(report), live(AstNode::live(), AstNode::live() + nodeKindCount),
+          made(AstNode::made), unowned(AstNode::unowned), heap(heapInUse()) {}
+
+    ~MemAudit() {
+        if (!report) {
+            return;
+        }
+        std::ostream& out = *report;
+        size_t outstanding = 0;
+        for (size_t k = 0; k < nodeKindCount; ++k) {
+            outstanding += AstNode::live()[k] - live[k];
+        }
+        out << "mem: " << AstNode::made - made << " nodes made, " << AstNode::made - made - outstanding
+            << " freed, " << outstanding << " outstanding";
+        if (AstNode::unowned != unowned) {
+            out << " (" << AstNode::unowned - unowned << " made outside any arena)";
+        }
+        out << std::endl;
+        for (size_t k = 0; k < nodeKindCount; ++k) {
+            size_t count = AstNode::live()[k] - live[k];
+            if (count) {
+                out << "mem:   " << nodeKindName((NodeKind)k) << " " << count << " (" << count * nodeSize((NodeKind)k)
+                    << " bytes)" << std::endl;
+            }
+        }
+        long long now = (long long)heapInUse();
+        out << "mem: heap " << now << " bytes in use, " << (now >= (long long)heap ? "+" : "") << now - (long long)heap
+            << " over the compile" << std::endl;
+    }
+
+    MemAudit(const MemAudit&) = delete;
+    MemAudit& operator=(const MemAudit&) = delete;
+
+private:
+    std::ostream* report;               // null: not auditing
+    std::vector<size_t> live;
+    size_t made;
+    size_t unowned;
+    size_t heap;
+
+    static size_t heapInUse() { return mallinfo2().uordblks; }
+};
+
+#endif
@@ -0,0 +1,268 @@
+#ifndef PARALLEL_LEXER_H
+#define PARALLEL_LEXER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "source_map.hpp"
+
+// One token as a chunk's lexer writes it, with its span in the file,
+// followed by `length` bytes of text: the identifier, number or string
+// contents, empty for other tokens. A record with token -1 ends the chunk;
+// its span's start says whether the chunk ended outside any string or
+// comment.
+struct LexRecord {
+    int32_t token;
+    SourceSpan span;
+    uint32_t length;
+};
+
+inline void writeLexRecord(FILE* out, int token, SourceSpan span, std::string_view text) {
+    LexRecord record = {token, span, (uint32_t)text.size()};
+    fwrite(&record, sizeof(record), 1, out);
+    fwrite(text.data(), 1, record.length, out);
+}
+
+// pycompile.l
+bool lexChunk(const SourceFile& file, size_t begin, size_t end, FILE* out);
+std::string_view tokenText(int token);
+
+// `compiler --parallel-lex`: lexes one large file in chunks, one process per
+// chunk, then hands the parser the tokens in source order.
+//
+// A line that starts in column 0 with code resets the indentation to
+// indent_stack[0] == 0, so the scanner can start there with fresh state; the
+// chunks are cut at such lines. Whether the cut really was outside a string
+// is only known once the chunk before it is lexed: if that chunk ended inside
+// a """ string, a comment or a continued string, the two are joined and lexed
+// again as one. Each chunk's tokens go to a temporary file and its
+// diagnostics (the scanner's printf output) to another, which is copied to
+// stdout when the replay reaches the chunk. The scanner keeps its state in
+// globals, so chunks run in forked processes rather than threads.
+class ParallelLexer {
+public:
+    explicit ParallelLexer(unsigned jobs) : jobs(std::max(1u, jobs)) {}
+
+    ~ParallelLexer() {
+        for (Chunk& chunk : chunks) {
+            closeChunk(chunk);
+        }
+    }
+
+    // Lexes the whole file. False if it is empty or streamed (the chunks
+    // are cut from the text in memory), and the caller lexes it serially
+    // instead.
+    bool lex(const SourceFile& source) {
+        file = &source;
+        data = source.text().data();
+        size = source.text().size();
+        if (size == 0 || source.streamed()) {
+            return false;
+        }
+        // the scanner's messages give lines: build the table once here
+        // rather than once in every chunk's process
+        source.lineStarts();
+
+        split();
+        run(0, chunks.size());
+        // A chunk that ended inside a string means the next one began in
+        // it: join them and lex the span again, until every cut holds
+        for (size_t i = 0; i + 1 < chunks.size();) {
+            if (chunks[i].clean) {
+                ++i;
+                continue;
+            }
+            if (chunks[i].status != 0) {
+                break;          // began where it should, so the error is real
+            }
+            chunks[i].end = chunks[i + 1].end;
+            closeChunk(chunks[i]);
+            closeChunk(chunks[i + 1]);
+            chunks.erase(chunks.begin() + i + 1);
+            ++relexed;
+            run(i, i + 1);
+        }
+        return true;
+    }
+
+    // Next token in source order, 0 after the last; span and text as the
+    // scanner had them
+    int next(SourceSpan& span, std::string& text) {
+        while (current < chunks.size()) {
+            Chunk& chunk = chunks[current];
+            if (!started) {
+                copyLog(chunk);
+                rewind(chunk.tokens);
+                started = true;
+            }
+            LexRecord record;
+            if (fread(&record, sizeof(record), 1, chunk.tokens) == 1 && record.token != -1) {
+                text.resize(record.length);
+                if (record.length && fread(&text[0], 1, record.length, chunk.tokens) != record.length) {
+                    break;
+                }
+                span = record.span;
+                return record.token;
+            }
+            if (chunk.status != 0) {
+                // the scanner stopped the program here when lexing serially
+                fflush(stdout);
+                exit(chunk.status);
+            }
+            closeChunk(chunk);
+            ++current;
+            started = false;
+        }
+        return 0;
+    }
+
+    void report(std::ostream& out) const {
+        out << "lex: " << size << " bytes in " << chunks.size() << " chunks on "
+            << jobs << " processes, " << relexed << " joined and lexed again" << std::endl;
+    }
+
+private:
+    // yy_scan_bytes takes an int length
+    static const size_t kMaxChunk = (size_t)1 << 30;
+
+    struct Chunk {
+        size_t begin;
+        size_t end;
+        bool clean = false;
+        int status = 0;                 // exit status of the lexing process
+        FILE* tokens = nullptr;
+        FILE* log = nullptr;
+    };
+
+    unsigned jobs;
+    const SourceFile* file = nullptr;
+    const char* data = nullptr;
+    size_t size = 0;
+    std::vector<Chunk> chunks;
+    size_t relexed = 0;
+    size_t current = 0;
+    bool started = false;
+
+    // Where a line starts in column 0 with something other than blanks or
+    // a comment, which leave the indentation as it was
+    bool cutsAt(size_t offset) const {
+        if (offset == 0 || offset >= size || data[offset - 1] != '\n') {
+            return false;
+        }
+        char c = data[offset];
+        return c != ' ' && c != '\t' && c != '\r' && c != '\n' && c != '#';
+    }
+
+    void split() {
+        size_t pieces = std::max<size_t>(jobs, (size + kMaxChunk - 1) / kMaxChunk);
+        size_t begin = 0;
+        for (size_t k = 1; k <= pieces; ++k) {
+            size_t end = size;
+            if (k < pieces) {
+                end = std::max(begin + 1, size / pieces * k);
+                while (end < size && !cutsAt(end)) {
+                    const char* newline = (const char*)memchr(data + end, '\n', size - end);
+                    end = newline ? (size_t)(newline - data) + 1 : size;
+                }
+            }
+            if (end <= begin) {
+                continue;
+            }
+            Chunk chunk;
+            chunk.begin = begin;
+            chunk.end = end;
+            chunks.push_back(chunk);
+            begin = end;
+            if (begin == size) {
+                break;
+            }
+        }
+    }
+
+    // Lexes chunks [first, last), at most `jobs` processes at a time
+    void run(size_t first, size_t last) {
+        std::vector<std::pair<pid_t, size_t>> running;
+        for (size_t i = first; i < last; ++i) {
+            if (running.size() == jobs) {
+                chunks[running.front().second].status = wait(running.front().first);
+                running.erase(running.begin());
+            }
+            running.push_back(std::make_pair(start(i), i));
+        }
+        for (const auto& child : running) {
+            chunks[child.second].status = wait(child.first);
+        }
+        for (size_t i = first; i < last; ++i) {
+            LexRecord trailer;
+            fseek(chunks[i].tokens, -(long)sizeof(trailer), SEEK_END);
+            chunks[i].clean = fread(&trailer, sizeof(trailer), 1, chunks[i].tokens) == 1
+                && trailer.token == -1 && trailer.span.start == 1;
+        }
+    }
+
+    pid_t start(size_t i) {
+        Chunk& chunk = chunks[i];
+        chunk.tokens = tmpfile();
+        chunk.log = tmpfile();
+        if (!chunk.tokens || !chunk.log) {
+            perror("--parallel-lex");
+            exit(1);
+        }
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("--parallel-lex");
+            exit(1);
+        }
+        if (pid == 0) {
+            dup2(fileno(chunk.log), STDOUT_FILENO);
+            bool clean = lexChunk(*file, chunk.begin, chunk.end, chunk.tokens);
+            LexRecord trailer = {-1, SourceSpan{clean ? 1u : 0u, 0}, 0};
+            fwrite(&trailer, sizeof(trailer), 1, chunk.tokens);
+            fflush(chunk.tokens);
+            fflush(stdout);
+            _exit(0);
+        }
+        return pid;
+    }
+
+    // Nonzero when the scanner stopped the program, on bad indentation.
+    // That only counts once the chunk is known to begin where it should.
+    static int wait(pid_t pid) {
+        int status = 0;
+        if (waitpid(pid, &status, 0) < 0) {
+            return 1;
+        }
+        return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+    }
+
+    static void copyLog(Chunk& chunk) {
+        char buffer[1 << 16];
+        rewind(chunk.log);
+        for (size_t n; (n = fread(buffer, 1, sizeof(buffer), chunk.log)) > 0;) {
+            fwrite(buffer, 1, n, stdout);
+        }
+    }
+
+    static void closeChunk(Chunk& chunk) {
+        if (chunk.tokens) {
+            fclose(chunk.tokens);
+            chunk.tokens = nullptr;
+        }
+        if (chunk.log) {
+            fclose(chunk.log);
+            chunk.log = nullptr;
+        }
+    }
+};
+
+#endif
@@ -4,46 +4,147 @@
 * @author fadel-hasan
 */
 
+%require "3.2"
+%skeleton "lalr1.cc"
+%defines "parser.hpp"
+%locations
+%define api.location.type {SourceSpan}
+// "syntax error, unexpected ..., expecting ...", and the token names
+// token_stream.hpp prints
+%define parse.error detailed
+
+// Typed semantic values: each symbol's value lives in the parser's stack as
+// its own type and is moved, not copied, from one symbol to the next, so a
+// name reaches its node as the string the scanner made.
+%define api.value.type variant
+
 %code requires {
       #include "python_ast_node.hpp"
+      #include "source_map.hpp"
       #include <iostream>
       #include <string>
+      #include <utility>
+      #include <vector>
+
+      // A rule's location runs from its first symbol's start to its last
+      // symbol's end, an empty rule's is empty where the symbol before it
+      // ends. Every node the rule's action makes is given it (parseSpan).
+      #define YYLLOC_DEFAULT(Current, Rhs, N)                                       \
+            do {                                                                  \
+                  if (N) {                                                        \
+                        (Current) = SourceSpan::between(YYRHSLOC(Rhs, 1).start,   \
+                                                        YYRHSLOC(Rhs, N).end());  \
+                  } else {                                                        \
+                        (Current).start = YYRHSLOC(Rhs, 0).end();                 \
+                        (Current).length = 0;                                     \
+                  }                                                               \
+                  AstNode::parseSpan = (Current);                                 \
+            } while (0)
 }
 
-%union{
-	AstNode* astNode;
-        IdentifierNode* idNode;
-	int d;
+%code provides {
+      int yylex(yy::parser::semantic_type* value, yy::parser::location_type* location);
 }
 
 %{
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-int yydebug=1;
-FILE *yyin;
-void yyerror(const char *);
-extern int yylex();
-extern int yylineno;
-extern char* yytext;
+#include <charconv>
+#include <fstream>
+#include "scope_analysis.hpp"
+#include "c_backend.hpp"
+#include "interpreter.hpp"
+#include "dot_printer.hpp"
+#include "visit_bench.hpp"
+#include "parallel_lexer.hpp"
+#include "project_builder.hpp"
+#include "compile_server.hpp"
+#include "tree_writer.hpp"
+#include "mem_audit.hpp"
+#include "token_stream.hpp"
+#include "hash_cons.hpp"
+#include "selection.hpp"
+void yyerror(SourceSpan where, const char *);
+extern int scanToken();
+extern SourceSpan tokenSpan(int kind);
+extern void restartScanner(const SourceFile& file);
       AstNode* root = NULL;
       int n_nodes = 0;
+      ParallelLexer* parallelLexer = NULL;
+      const SourceFile* parsingSource = NULL;  // the file yyerror points into
+      TaskScheduler* residentPool = NULL;     // --serve: the pool every request shares
+      bool hashConsing = false;               // --hash-cons, for parseFile as well
 %}
 
+%code {
+// A leaf made from one token of a longer rule, on the token's span rather
+// than the rule's
+template <class Node>
+Node* at(Node* node, const SourceSpan& where)
+{
+      node->span = where;
+      return node;
+}
+
+// A number where the grammar takes an int: a parameter or a range() bound.
+// Anything but a decimal int that fits is a syntax error at `where`.
+int intValue(const std::string& spelling, const SourceSpan& where)
+{
+      int number = 0;
+      const char* end = spelling.data() + spelling.size();
+      std::from_chars_result parsed = std::from_chars(spelling.data(), end, number);
+      if (parsed.ec == std::errc::result_out_of_range)
+            yyerror(where, "integer literal out of range");
+      if (parsed.ec != std::errc() || parsed.ptr != end)
+            yyerror(where, "expected a decimal integer");
+      return number;
+}
+
+// An expression just reduced, or under --hash-cons the equal one the file
+// already has (hash_cons.hpp)
+AstNode* share(AstNode* node)
+{
+      return HashCons::current() ? HashCons::current()->intern(node) : node;
+}
+
+// A module-level statement, added to the module's Statements node. Under
+// --select it goes to the selection instead (selection.hpp), which keeps
+// the parts of it that are selected and deletes the rest, and no module
+// node is made.
+AstNode* addStatement(AstNode* module, AstNode* statement)
+{
+      if (Selection::current()) {
+            Selection::current()->offer(statement);
+            return nullptr;
+      }
+      if (module == nullptr)
+            module = new StatementsNode("Statements");
+      module->add(statement);
+      return module;
+}
+}
+
 // tokens
 
-%token<astNode> IF ELSE ELIF WHILE FOR CLASS AS IS ASSERT CONTINUE BREAK DEL EXCEPT IMPORT IN LAMBDA FINALLY GLOBAL NOT TRUE WITH YIELD FALSE AWAIT PASS RAISE NONE AND TRY FROM NONLOCAL ASYNC OR
-%token<astNode> ID NUMBER STRING ASSIGN RETURN RANGE  
-%token<astNode>  MUL  LBRACKET RBRACKET SEMICOLON EQUAL COLON
-%token<astNode> PRINT KEYWORD IDENTIFIER DEF RSHIFT LSHIFT   
-%token<astNode> INDENT DEDENT NEWLINE  NEQ  GT GTE LT  LTE MATCH CASE
-%type<astNode> program statements statement function_def arg args args_ block function_call assignment
-%type<astNode>  simple_stmt compound_stmt arguments argument global_stmt global_parms nonlocal_stmt nonlocal_parms
-%type<astNode> yield_stmt yield_expr return_stmt return_parms while_stmt while_else with_stmt with_items
-%type<astNode> with_item_list with_item if_stmt if_header elif_else_ elif_else else_stmt elif_stmts elif_stmt
-%type<astNode> elif_header named_expression comparison assignment_expression comp_op decorators class_def class_def_raw
-%type<astNode> primary_expression negated_expression expression for_stmt for_header changes range myfunc myrange try_stmt try_stmts
-%type<astNode> except_block finally_block match_stmt match_cases match_case pattern_list  pattern list_pattern dict_pattern dict_pattern_entries dict_pattern_entry
+%token IF ELSE ELIF WHILE FOR CLASS AS IS ASSERT CONTINUE BREAK DEL EXCEPT IMPORT IN LAMBDA FINALLY GLOBAL NOT TRUE WITH YIELD FALSE AWAIT PASS RAISE NONE AND TRY FROM NONLOCAL ASYNC OR
+%token ID ASSIGN RETURN RANGE
+%token MUL  LBRACKET RBRACKET SEMICOLON EQUAL COLON
+%token PRINT KEYWORD DEF RSHIFT LSHIFT
+%token INDENT DEDENT NEWLINE  NEQ  GT GTE LT  LTE MATCH CASE
+%token<std::string> IDENTIFIER STRING NUMBER
+%type<AstNode*> program module statements statement function_def arg args args_ block function_call assignment argument_list
+%type<AstNode*>  simple_stmt compound_stmt arguments argument global_stmt nonlocal_stmt
+%type<AstNode*> yield_stmt yield_expr return_stmt return_parms while_stmt while_else with_stmt with_items
+%type<AstNode*> with_item_list with_item if_stmt if_header elif_else_ elif_else else_stmt elif_stmts elif_stmt
+%type<AstNode*> elif_header named_expression comparison assignment_expression decorators class_def class_def_raw
+%type<AstNode*> primary_expression negated_expression expression for_stmt for_header changes range myfunc myrange try_stmt try_stmts
+%type<AstNode*> except_block finally_block match_stmt match_cases match_case pattern_list  pattern list_pattern dict_pattern dict_pattern_entries dict_pattern_entry
+%type<AstNode*> import_stmt
+%type<ImportStmtNode*> import_names import_from import_from_names import_from_paren
+%type<std::string> comp_op dotted_name
+%type<std::vector<std::string>> global_parms nonlocal_parms
+%type<int> import_dots
 %nonassoc EQUAL
 %left '+' '-'
 %left MUL '/'
@@ -58,12 +159,17 @@ extern char* yytext;
 |         write yyaccept          */
 /* Parser Grammar */
 program:  /*empty program*/ {$$ = nullptr;}
-       | statements {      root = $$; YYACCEPT; }
+       | module {      root = $1; YYACCEPT; }
        ;
 
+/* the module-level statements, kept apart from a block's for --select */
+module: statement { $$ = addStatement(nullptr, $1); }
+      | module statement { $$ = addStatement($1, $2); }
+      ;
+
 
 statements: 
-            statement  { $$ = new StatementsNode(); $$->add($1);}
+            statement  { $$ = new StatementsNode("Statements"); $$->add($1);}
           | statements statement  {$1->add($2); $$ = $1; }
           ;
 
@@ -81,9 +187,9 @@ simple_stmt:
           | CONTINUE     {{ $$ = new ContinueStmtNode(); }}
           | global_stmt  {{ $$ = $1; }}
           | nonlocal_stmt {{ $$ = $1; }}
+          | import_stmt   {{ $$ = $1; }}
           | yield_stmt    {{ $$ = $1; }}
           | PASS         {{ $$ = new PassStmtNode(); }}
-          | function_call {{ $$ = $1; }}
           ;
 
 compound_stmt:
@@ -98,10 +204,8 @@ compound_stmt:
     ;
 
 function_def: DEF IDENTIFIER '(' args ')' COLON block {
-      std::string name = "func" + std::to_string(n_nodes);
       ++n_nodes;
-      IdentifierNode* idFunc = dynamic_cast<IdentifierNode*>($2);
-      $$ = new FunctionNode(idFunc->value);
+      $$ = new FunctionNode(std::move($2));
       $$->add($4);
       $$->add($7);
             };
@@ -117,57 +221,112 @@ args_ : arg { $$ = new Args("Args"); $$->add($1); }
 arg   : IDENTIFIER {
         std::string nname = "iden" + std::to_string(n_nodes);
         ++n_nodes;
-        $1->name=nname;
-        $$ = $1;
+        $$ = at(new IdentifierNode(std::move(nname), "Identifier", std::move($1)), @1);
         }
       | NUMBER {
         std::string nname = "num" + std::to_string(n_nodes);
         ++n_nodes;
-        $$ = new NumberNode(nname, $1);
+        $$ = at(new NumberNode(std::move(nname), "number", intValue($1, @1)), @1);
       }
       ;
 
 block : NEWLINE INDENT statements DEDENT { $$ = $3; }
     ;
 
-function_call: IDENTIFIER '(' arguments ')' {   $$ = new FunctionCallNode($1);
+function_call: IDENTIFIER '(' arguments ')' {   $$ = new FunctionCallNode(std::move($1));
+      $$->add($3);}
+             | PRINT '(' arguments ')' {   $$ = new FunctionCallNode("print");
       $$->add($3);}
              ;
 
 arguments: /*empty*/ { $$ = new ArgumentsNode();}
-         | arguments argument { $1->add($2);
-                                    $$ = $1;}
+         | argument_list { $$ = $1;}
          ;
 
-argument:',' primary_expression {$$ = $2;}
+argument_list: argument { $$ = new ArgumentsNode();
+                          $$->add($1);}
+             | argument_list ',' argument { $1->add($3);
+                                            $$ = $1;}
+             ;
+
+argument: expression {$$ = $1;}
         ;
 
-global_stmt: GLOBAL IDENTIFIER global_parms {$$ = new GlobalStmtNode($2);
-      if ($3) {
-          for (const auto& param : $3->identifiers) {
-              $$->add(param);
-          }
-      }}
+global_stmt: GLOBAL IDENTIFIER global_parms {$$ = new GlobalStmtNode(std::move($2), std::move($3));}
            ;
 
-global_parms: /*empty*/ { $$ = new GlobalStmtNode("");}
+global_parms: /*empty*/ { }
             /* | ',' IDENTIFIER  */
-            |  global_parms ',' IDENTIFIER  { $1->add($3);
-                                                 $$ = $1;}
+            |  global_parms ',' IDENTIFIER  { $1.push_back(std::move($3));
+                                                 $$ = std::move($1);}
+            ;
+
+import_stmt: import_names { $$ = $1; }
+           | import_from_names { $$ = $1; }
+           | import_from_paren ')' { $$ = $1; }
+           | import_from_paren ',' ')' { $$ = $1; }
+           | import_from MUL { $1->addName("*", "");
+                               $$ = $1; }
+           ;
+
+/* import a.b, c as d */
+import_names: IMPORT dotted_name { $$ = new ImportStmtNode();
+                                   $$->addName(std::move($2), ""); }
+            | IMPORT dotted_name AS IDENTIFIER { $$ = new ImportStmtNode();
+                                   $$->addName(std::move($2), std::move($4)); }
+            | import_names ',' dotted_name { $1->addName(std::move($3), "");
+                                   $$ = $1; }
+            | import_names ',' dotted_name AS IDENTIFIER { $1->addName(std::move($3), std::move($5));
+                                   $$ = $1; }
             ;
 
-nonlocal_stmt: NONLOCAL IDENTIFIER nonlocal_parms {$$ = new NonlocalStmtNode($2);
-      if ($3) {
-          for (const auto& param : $3->identifiers) {
-              $$->add(param);
-          }
-      }}
+/* from ..a.b import */
+import_from: FROM dotted_name IMPORT { $$ = new ImportStmtNode();
+                                       $$->setFrom(std::move($2), 0); }
+           | FROM import_dots dotted_name IMPORT { $$ = new ImportStmtNode();
+                                       $$->setFrom(std::move($3), $2); }
+           | FROM import_dots IMPORT { $$ = new ImportStmtNode();
+                                       $$->setFrom("", $2); }
+           ;
+
+import_dots: '.' { $$ = 1; }
+           | import_dots '.' { $$ = $1 + 1; }
+           ;
+
+/* from m import x, y as z */
+import_from_names: import_from IDENTIFIER { $1->addName(std::move($2), "");
+                                            $$ = $1; }
+                 | import_from IDENTIFIER AS IDENTIFIER { $1->addName(std::move($2), std::move($4));
+                                            $$ = $1; }
+                 | import_from_names ',' IDENTIFIER { $1->addName(std::move($3), "");
+                                            $$ = $1; }
+                 | import_from_names ',' IDENTIFIER AS IDENTIFIER { $1->addName(std::move($3), std::move($5));
+                                            $$ = $1; }
+                 ;
+
+/* from m import (x, y as z), on one line */
+import_from_paren: import_from '(' IDENTIFIER { $1->addName(std::move($3), "");
+                                                $$ = $1; }
+                 | import_from '(' IDENTIFIER AS IDENTIFIER { $1->addName(std::move($3), std::move($5));
+                                                $$ = $1; }
+                 | import_from_paren ',' IDENTIFIER { $1->addName(std::move($3), "");
+                                                $$ = $1; }
+                 | import_from_paren ',' IDENTIFIER AS IDENTIFIER { $1->addName(std::move($3), std::move($5));
+                                                $$ = $1; }
+                 ;
+
+dotted_name: IDENTIFIER { $$ = std::move($1); }
+           | dotted_name '.' IDENTIFIER { $1 += "." + $3;
+                                          $$ = std::move($1); }
+           ;
+
+nonlocal_stmt: NONLOCAL IDENTIFIER nonlocal_parms {$$ = new NonlocalStmtNode(std::move($2), std::move($3));}
              ;
 
-nonlocal_parms: /*empty*/ { $$ = new NonlocalStatementNode("");}
+nonlocal_parms: /*empty*/ { }
               /* | ',' IDENTIFIER  */
-              | nonlocal_parms ',' IDENTIFIER { $1->add($3);
-                                                $$ = $1;}
+              | nonlocal_parms ',' IDENTIFIER { $1.push_back(std::move($3));
+                                                $$ = std::move($1);}
               ;
 
 yield_stmt: YIELD yield_expr {    $$ = new YieldStmtNode($2);}
@@ -179,8 +338,7 @@ yield_expr: expression {$$ = $1;}
 assignment: IDENTIFIER ASSIGN expression  {$$ = new assignmentStatement("assign1");
                                           std::string nname = "iden" + std::to_string(n_nodes);
                                           ++n_nodes;
-                                          $1->name=nname;
-                                          $$->add($1);
+                                          $$->add(at(new IdentifierNode(std::move(nname), "Identifier", std::move($1)), @1));
                                           $$->add($3);}
           ;
 
@@ -204,8 +362,8 @@ while_else: /*empty*/ { $$ = nullptr;}
           ;
 
 
-with_stmt: WITH '(' with_items ')' COLON block {    $$ = new WithStmtNode($3, $6);}
-         | WITH with_items COLON block {    $$ = new WithStmtNode($2, $4);}
+with_stmt: WITH '(' with_items ')' COLON block {    $$ = new WithStmtNode({$3}, $6);}
+         | WITH with_items COLON block {    $$ = new WithStmtNode({$2}, $4);}
          ;
 
 with_items: with_item_list ',' {    $$ = $1;}
@@ -219,7 +377,7 @@ with_item_list: with_item {$$ = new WithItemList();
     $$ = $1;}
               ;
 
-with_item: IDENTIFIER '(' STRING ')' AS IDENTIFIER { $$ = new WithItem($1, $3, $6);}
+with_item: IDENTIFIER '(' STRING ')' AS IDENTIFIER { $$ = new WithItem(std::move($1), std::move($3), std::move($6));}
          ;
 
 
@@ -228,7 +386,7 @@ with_item: IDENTIFIER '(' STRING ')' AS IDENTIFIER { $$ = new WithItem($1, $3, $
 if_stmt : if_header block elif_else_ {    $$ = new IfStatementNode($1, $2, $3);}
 
 
-if_header : IF named_expression COLON ; {    $$ = new IfHeaderNode($2);}
+if_header : IF named_expression COLON {    $$ = new IfHeaderNode($2);}
 
 
 elif_else_ : /* empty no next elif or else*/ {$$ = nullptr;}
@@ -236,10 +394,9 @@ elif_else_ : /* empty no next elif or else*/ {$$ = nullptr;}
  ; 
 
 
-elif_else : elif_stmts else_stmt {$$ = new ElifElseNode($1, $2);}
-| elif_stmts {$$ = new ElifElseNode($1, nullptr);}
-| else_stmt { std::vector<AstNode*> emptyElifStmts;
-    $$ = new ElifElseNode(emptyElifStmts, $1);}
+elif_else : elif_stmts else_stmt {$$ = new ElifElseNode({$1}, $2);}
+| elif_stmts {$$ = new ElifElseNode({$1}, nullptr);}
+| else_stmt { $$ = new ElifElseNode({}, $1);}
 ;
 
 else_stmt : ELSE COLON block {    $$ = new ElseStmtNode($3);}
@@ -247,8 +404,8 @@ else_stmt : ELSE COLON block {    $$ = new ElseStmtNode($3);}
 
 elif_stmts : elif_stmt { $$ = new ElifStmtsNode();
     $$->add($1);}
-| elif_stmt elif_stmts {$2->add($1);
-    $$ = $2;}
+| elif_stmts elif_stmt {$1->add($2);
+    $$ = $1;}
 ;
 
 elif_stmt : elif_header block {$$ = new ElifStmtNode($1, $2);}
@@ -261,12 +418,15 @@ named_expression: assignment_expression {$$ = $1;}
                 | comparison {$$ = $1;}
     ;
     
-comparison: expression comp_op expression {    $$ = new ComparisonNode($1, $2, $3);}
+comparison: expression comp_op expression {    $$ = share(new ComparisonNode($1, std::move($2), $3));}
     ;
 
 
 
-assignment_expression: IDENTIFIER ASSIGN expression {$$ = new AssignmentStatement($1);
+assignment_expression: IDENTIFIER ASSIGN expression {$$ = new assignmentStatement("assign1");
+    std::string nname = "iden" + std::to_string(n_nodes);
+    ++n_nodes;
+    $$->add(at(new IdentifierNode(std::move(nname), "Identifier", std::move($1)), @1));
     $$->add($3);}
     /* | conditional_expression */
     ;
@@ -276,7 +436,6 @@ comp_op: LT    { $$ = "<"; }
        | EQUAL { $$ = "=="; }
        | GTE   { $$ = ">="; }
        | LTE   { $$ = "<="; }
-       | '<>'  { $$ = "<>"; }
        | NEQ   { $$ = "!="; }
        | IN    { $$ = "in"; }
        | NOT IN { $$ = "not in"; }
@@ -294,52 +453,50 @@ class_def: decorators class_def_raw {$$ = new ClassDefNode($1, $2);}
          | class_def_raw {$$ = new ClassDefNode(nullptr, $1);}
          ;
 
-class_def_raw: CLASS IDENTIFIER COLON block; {$$ = new ClassDefRawNode($2, $4);}
+class_def_raw: CLASS IDENTIFIER COLON block {$$ = new ClassDefRawNode(std::move($2), $4);}
+             ;
 
 
 primary_expression
-  : IDENTIFIER {      $$ = new PrimaryExpressionNode($1);}
-  | NUMBER {      $$ = new PrimaryExpressionNode(std::to_string($1));}
-  | TRUE {      $$ = new PrimaryExpressionNode("true");}
-  | FALSE {      $$ = new PrimaryExpressionNode("true");}
+  : IDENTIFIER {      $$ = share(new PrimaryExpressionNode(std::move($1)));}
+  | NUMBER {      $$ = share(new PrimaryExpressionNode(std::move($1)));}
+  | TRUE {      $$ = share(new PrimaryExpressionNode("true"));}
+  | FALSE {      $$ = share(new PrimaryExpressionNode("false"));}
+  | function_call {      $$ = $1;}
   
   ;
 
 negated_expression
-  : NOT primary_expression {      $$ = new NegatedExpressionNode($2);}
+  : NOT primary_expression {      $$ = share(new NegatedExpressionNode($2));}
   ;
 
 expression:   primary_expression {      $$ = $1;}
             | negated_expression {      $$ = $1;}
-            | expression '+' expression {      $$ = new ExpressionNode("+", $1, $3);}
-            | expression '-' expression {      $$ = new ExpressionNode("-", $1, $3);}
-            | expression MUL expression {      $$ = new ExpressionNode("*", $1, $3);}
-            | expression '/' expression {      $$ = new ExpressionNode("/", $1, $3);}
-            | '-' expression  %prec UMINUS {      $$ = new ExpressionNode("-", nullptr, $2);}
-            | '|' expression  %prec UMINUS {      $$ = new ExpressionNode("|", nullptr, $2);}
+            | expression '+' expression {      $$ = share(new ExpressionNode("+", $1, $3));}
+            | expression '-' expression {      $$ = share(new ExpressionNode("-", $1, $3));}
+            | expression MUL expression {      $$ = share(new ExpressionNode("*", $1, $3));}
+            | expression '/' expression {      $$ = share(new ExpressionNode("/", $1, $3));}
+            | '-' expression  %prec UMINUS {      $$ = share(new ExpressionNode("-", nullptr, $2));}
+            | '|' expression  %prec UMINUS {      $$ = share(new ExpressionNode("|", nullptr, $2));}
             | '(' expression ')' {      $$ = $2;}
 ;
 
 for_stmt:  for_header changes COLON block {    $$ = new ForStatementNode($1, $2, $4);}
 
-for_header: FOR IDENTIFIER IN {    $$ = new ForStatementNode($1, $2, $4);}
+for_header: FOR IDENTIFIER IN {    $$ = new ForHeaderNode(std::move($2));}
 
-changes: IDENTIFIER {    $$ = new ChangesNode($1);}
+changes: IDENTIFIER {    $$ = new ChangesNode(std::move($1));}
         |range {$$ = new ChangesNode(""); // Assuming you want to handle range differently
     $$->add($1);}
         
 range: RANGE '(' myrange ')' {$$ = $3;}
     | RANGE '(' myfunc ')' { $$ = $3; }
     
-myfunc: IDENTIFIER '(' ')' {$$ = new MyFuncNode($1);}
-
-myrange : NUMBER { std::vector<int> values =$1;
-    $$ = new MyRangeNode(values);}
-        | NUMBER ',' NUMBER {std::vector<int> values = { $1, $3 };
-    $$ = new MyRangeNode(values);}
-        | NUMBER ',' NUMBER ',' NUMBER {
-            std::vector<int> values = { $1, $3, $5 };
-                                        $$ = new MyRangeNode(values);}
+myfunc: IDENTIFIER '(' ')' {$$ = new MyFuncNode(std::move($1));}
+
+myrange : NUMBER { $$ = new MyRangeNode({intValue($1, @1)});}
+        | NUMBER ',' NUMBER { $$ = new MyRangeNode({intValue($1, @1), intValue($3, @3)});}
+        | NUMBER ',' NUMBER ',' NUMBER { $$ = new MyRangeNode({intValue($1, @1), intValue($3, @3), intValue($5, @5)});}
         
         
 
@@ -358,9 +515,9 @@ try_stmts: except_block {  $$ = new TryStmtsNode();
          ;
 
 except_block
-    : EXCEPT IDENTIFIER COLON block {    $$ = new ExceptBlockNode($2, $4);}
+    : EXCEPT IDENTIFIER COLON block {    $$ = new ExceptBlockNode(std::move($2), $4);}
     | except_block EXCEPT IDENTIFIER COLON block { $$ = $1;
-    $$->add(new ExceptBlockNode($3, $5));}
+    $$->add(new ExceptBlockNode(std::move($3), $5));}
     ;
 
 finally_block:FINALLY COLON block {    $$ = new FinallyBlockNode($3);}
@@ -400,7 +557,7 @@ pattern:
 
 }
     | dict_pattern {    $$ = $1;}
-    | '_' {    $$ = new PatternNode(new LiteralNode("_"));}
+    | '_' {    $$ = new PatternNode(new LiteralNode("_", "wildcard", 0));}
     ;
 
 /* tuple_pattern: '(' pattern_list ')'
@@ -603,25 +760,310 @@ dict_pattern_entry
 %%
 
 
-int main(int argc, char **argv)
+// Tokens from the scanner, or from the chunks --parallel-lex lexed up front.
+// Identifiers, strings and numbers carry their text, numbers as spelled so
+// that 3.14 and 0x10 reach the tree whole; the other tokens carry none. Every token's location is its span in the file.
+int yylex(yy::parser::semantic_type* value, yy::parser::location_type* location)
+{
+     typedef yy::parser::token token;
+     int kind;
+     std::string_view text;
+     if (parallelLexer == NULL) {
+            kind = scanToken();
+            text = tokenText(kind);
+            *location = tokenSpan(kind);
+     } else {
+            static std::string replayed;
+            kind = parallelLexer->next(*location, replayed);
+            text = replayed;
+     }
+     if (kind == token::IDENTIFIER || kind == token::STRING || kind == token::NUMBER) {
+            value->emplace<std::string>(text);
+     }
+     return kind;
+}
+
+void yy::parser::error(const location_type& where, const std::string& msg)
+{
+     yyerror(where, msg.c_str());
+}
+
+// Parses one module of a --project build into `arena`; a syntax error
+// stops the build as it stops a single-file compile
+AstNode* parseFile(const std::string& path, AstArena& arena)
+{
+     SourceFile source;
+     if (!SourceFile::load(path.c_str(), source)) {
+            perror(path.c_str());
+            stopCompile(1);
+     }
+     AstArena::Use use(arena);
+     HashCons consing;
+     HashCons::Use consed(hashConsing ? &consing : NULL);
+     parsingSource = &source;
+     scanTrace = !source.streamed();
+     restartScanner(source);
+     root = NULL;
+     yy::parser().parse();
+     parsingSource = NULL;
+     if (hashConsing)
+            consing.report(path, std::cerr);
+     return root;
+}
+
+// One run of the compiler over its command line; main() calls it once, or
+// once per request under --serve
+int compile(int argc, char **argv)
 {
  /*success("This is a valid python expression");*/
-     if (argc > 1){
-        for(int i=0;i<argc;i++)
-            printf("value of argv[%d] = %s\n\n",i,argv[i]);
-            yyin=fopen(argv[1],"r");
-    }
+     bool dumpSymbols = false;
+     const char* emitC = NULL;
+     bool run = false;
+     bool jitStats = false;
+     bool icStats = false;
+     bool gcStats = false;
+     bool linearMatch = false;
+     bool licmReport = false;
+     int visitRounds = 0;
+     int jobs = 0;
+     bool parallelLex = false;
+     const char* project = NULL;
+     const char* astFormat = "dot";
+     const char* astOut = NULL;
+     bool memAudit = false;
+     bool tokensOnly = false;
+     int tokenRounds = 0;
+     bool largeInput = false;
+     Selection selection;
+     hashConsing = false;
+     long long jitThreshold = 1000;
+     const char* input = NULL;
+     root = NULL;
+     n_nodes = 0;
+     parallelLexer = NULL;
+     for(int i=1;i<argc;i++){
+        if (strcmp(argv[i], "--symbols") == 0)
+            dumpSymbols = true;
+        else if (strcmp(argv[i], "--emit-c") == 0 && i + 1 < argc)
+            emitC = argv[++i];
+        else if (strcmp(argv[i], "--run") == 0)
+            run = true;
+        else if (strcmp(argv[i], "--jit-threshold") == 0 && i + 1 < argc)
+            jitThreshold = atoll(argv[++i]);
+        else if (strcmp(argv[i], "--jit-stats") == 0)
+            jitStats = true;
+        else if (strcmp(argv[i], "--ic-stats") == 0)
+            icStats = true;
+        else if (strcmp(argv[i], "--gc-stats") == 0)
+            gcStats = true;
+        else if (strcmp(argv[i], "--match-linear") == 0)
+            linearMatch = true;
+        else if (strcmp(argv[i], "--licm-report") == 0)
+            licmReport = true;
+        else if (strcmp(argv[i], "--visit-bench") == 0 && i + 1 < argc)
+            visitRounds = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc)
+            jobs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--parallel-lex") == 0)
+            parallelLex = true;
+        else if (strcmp(argv[i], "--project") == 0 && i + 1 < argc)
+            project = argv[++i];
+        else if (strcmp(argv[i], "--ast-format") == 0 && i + 1 < argc)
+            astFormat = argv[++i];
+        else if (strcmp(argv[i], "--ast-out") == 0 && i + 1 < argc)
+            astOut = argv[++i];
+        else if (strcmp(argv[i], "--mem-audit") == 0)
+            memAudit = true;
+        else if (strcmp(argv[i], "--tokens") == 0)
+            tokensOnly = true;
+        else if (strcmp(argv[i], "--token-bench") == 0 && i + 1 < argc)
+            tokenRounds = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--large-input") == 0)
+            largeInput = true;
+        else if (strcmp(argv[i], "--hash-cons") == 0)
+            hashConsing = true;
+        else if (strcmp(argv[i], "--select") == 0 && i + 1 < argc)
+            selection.addNames(argv[++i]);
+        else if (strcmp(argv[i], "--select-lines") == 0 && i + 1 < argc) {
+            if (!selection.setLines(argv[++i])) {
+                  fprintf(stderr, "--select-lines: expected FIRST-LAST or a line number, not %s\n", argv[i]);
+                  return 2;
+            }
+        }
         else
-        yyin=stdin;
-     yyparse();
+            input = argv[i];
+     }
+     // a JSON or binary tree on stdout, or the --tokens listing, is read by
+     // a program: nothing else may go there
+     bool treeOnStdout = strcmp(astFormat, "dot") != 0 && astOut == NULL;
+     if (!treeOnStdout && !tokensOnly)
+            for(int i=0;i<argc;i++)
+               printf("value of argv[%d] = %s\n\n",i,argv[i]);
+     // reports once everything below is gone, the tree's arena included
+     MemAudit audit(memAudit ? &std::cerr : NULL);
+     std::unique_ptr<TaskScheduler> ownPool;
+     TaskScheduler* pool = residentPool;
+     if (pool == NULL || (jobs > 0 && (unsigned)jobs != pool->jobs())) {
+            ownPool.reset(new TaskScheduler(jobs > 0 ? jobs : std::thread::hardware_concurrency()));
+            pool = ownPool.get();
+     }
+     TaskScheduler& scheduler = *pool;
+     if (strcmp(astFormat, "dot") != 0 && strcmp(astFormat, "json") != 0 && strcmp(astFormat, "binary") != 0) {
+            fprintf(stderr, "--ast-format: expected dot, json or binary, not %s\n", astFormat);
+            return 2;
+     }
+     if (hashConsing && (run || emitC != NULL)) {
+            fprintf(stderr, "--hash-cons: shared expressions hold one binding each, so the tree can be printed but not run or lowered to C\n");
+            return 2;
+     }
+     if (hashConsing && strcmp(astFormat, "dot") != 0) {
+            fprintf(stderr, "--hash-cons: a shared node has one span, and the %s records would widen every parent over it, so only --ast-format dot marks sharing\n", astFormat);
+            return 2;
+     }
+     if (!selection.empty() && (run || emitC != NULL || project != NULL)) {
+            fprintf(stderr, "--select: prints part of one file's tree, and cannot be run, lowered to C or used with --project\n");
+            return 2;
+     }
+     if (project != NULL) {
+            ProjectBuilder builder(scheduler, parseFile);
+            return builder.build(project, emitC, std::cerr) ? 0 : 1;
+     }
+     if (input == NULL && serving()) {
+            fprintf(stderr, "--serve: no input file\n");
+            return 2;
+     }
+     // read whole up front, so the scanner works from memory, unless it is
+     // too large for that or --large-input streams it from the file
+     SourceFile source;
+     if (!SourceFile::load(input, source, largeInput)) {
+            perror(input != NULL ? input : "<stdin>");
+            return 1;
+     }
+     if ((tokensOnly || tokenRounds > 0) && source.size() > UINT32_MAX) {
+            fprintf(stderr, "--tokens: %s is over 4 GiB, past what a packed token's offset holds\n", source.path().c_str());
+            return 2;
+     }
+     if (tokensOnly || tokenRounds > 0) {
+            Tokenizer tokenizer;
+            if (tokenRounds > 0)
+                  tokenizer.bench(source, tokenRounds, std::cerr);
+            else
+                  tokenizer.tokenize(source);
+            if (tokensOnly)
+                  tokenizer.print(source, std::cout);
+            return 0;
+     }
+     AstArena arena;        // owns the tree, however the compile ends
+     AstArena::Use use(arena);
+     // the trace gives every newline's line, which would make a streamed
+     // file keep a table of all its lines, and under --select would make
+     // the output follow the file rather than the selection
+     scanTrace = !source.streamed() && !treeOnStdout && selection.empty();
+     restartScanner(source);
+     ParallelLexer lexer(jobs > 0 ? jobs : std::thread::hardware_concurrency());
+     // a served request is not forked: the child would carry on as a server
+     if (parallelLex && !serving() && lexer.lex(source)) {
+            parallelLexer = &lexer;
+            lexer.report(std::cerr);
+     }
+     HashCons consing;
+     HashCons::Use consed(hashConsing ? &consing : NULL);
+     selection.start(source, arena);
+     Selection::Use selecting(selection.empty() ? NULL : &selection);
+     parsingSource = &source;
+     yy::parser().parse();
+     parsingSource = NULL;
+     if (hashConsing)
+            consing.report(source.path(), std::cerr);
+     if (!selection.empty()) {
+            root = selection.root();
+            selection.report(std::cerr);
+     }
       if (root != NULL) {
             AST ast(root);
-            ast.Print();
+            SymbolTable symbols = ScopeAnalyzer().analyze(root);
+            // names defined outside a selection would look undefined
+            if (selection.empty())
+                  symbols.reportDiagnostics(std::cerr);
+            if (dumpSymbols)
+                  symbols.dump(std::cerr);
+            if (visitRounds > 0) {
+                  VisitBench().run(root, source, visitRounds, std::cerr);
+                  return 0;
+            }
+            if (emitC != NULL) {
+                  TypeInference types(symbols);
+                  types.run(root);
+                  CBackend backend(symbols, types);
+                  backend.setScheduler(&scheduler);
+                  std::ostringstream code;
+                  if (!backend.emit(root, code)) {
+                        for (const auto& msg : backend.getErrors())
+                              std::cerr << msg << std::endl;
+                        return 1;
+                  }
+                  std::ofstream out(emitC);
+                  out << code.str();
+                  return 0;
+            }
+            if (run) {
+                  TypeInference types(symbols);
+                  types.run(root);
+                  Interpreter interpreter(symbols, types, jitThreshold);
+                  interpreter.setLinearMatch(linearMatch);
+                  interpreter.setScheduler(&scheduler);
+                  interpreter.run(root);
+                  if (jitStats)
+                        interpreter.reportJitStats(std::cerr);
+                  if (icStats)
+                        interpreter.reportCallSites(std::cerr);
+                  if (gcStats)
+                        interpreter.reportGcStats(std::cerr);
+                  if (licmReport)
+                        interpreter.reportLoopInvariants(std::cerr);
+                  return 0;
+            }
+            std::ofstream astFile;
+            if (astOut != NULL)
+                  astFile.open(astOut, std::ios::binary);
+            std::ostream& astStream = astOut != NULL ? astFile : std::cout;
+            if (strcmp(astFormat, "json") == 0)
+                  TreeWriter<JsonFormat>(astStream, source).write(root);
+            else if (strcmp(astFormat, "binary") == 0)
+                  TreeWriter<BinaryFormat>(astStream, source).write(root);
+            else
+                  ast.Print(astStream);
       }
       return 0;
      
 }
 
+int main(int argc, char **argv)
+{
+     int jobs = 0;
+     const char* serve = NULL;
+     for (int i = 1; i + 1 < argc; i++) {
+            if (strcmp(argv[i], "--serve") == 0)
+                  serve = argv[++i];
+            else if (strcmp(argv[i], "--jobs") == 0)
+                  jobs = atoi(argv[++i]);
+     }
+     if (serve == NULL)
+            return compile(argc, argv);
+     TaskScheduler pool(jobs > 0 ? jobs : std::thread::hardware_concurrency());
+     residentPool = &pool;
+     CompileServer server([](std::vector<std::string>& args) {
+            std::vector<char*> requestArgv;
+            for (std::string& arg : args)
+                  requestArgv.push_back(&arg[0]);
+            requestArgv.push_back(NULL);
+            return compile((int)args.size(), requestArgv.data());
+     });
+     bool ok = strcmp(serve, "-") == 0 ? server.serveStdio() : server.serveSocket(serve);
+     server.report(std::cerr);
+     return ok ? 0 : 1;
+}
+
 /* int yyerror(const char* s) {
 //     fprintf(stderr, "Error: %s\n", s);
 //     return 1;
@@ -632,9 +1074,8 @@ int main(int argc, char **argv)
           printf(" %s \n", msg);
     } */
 
-    void yyerror(const char* s){
-    fprintf(stderr, "%s \n", s);
-    fprintf(stderr, "line %d: ", yylineno);
-    fprintf(stderr, "%s \n", yytext);
-    exit(1);
+    // file:line:column: message, and the line with the token underlined
+    void yyerror(SourceSpan where, const char* s){
+    parsingSource->report(std::cerr, where, s);
+    stopCompile(1);
 }
\ No newline at end of file
@@ -0,0 +1,321 @@
+#ifndef PROJECT_BUILDER_H
+#define PROJECT_BUILDER_H
+
+#include "ast_visitor.hpp"
+#include "c_backend.hpp"
+#include "scope_analysis.hpp"
+#include "task_scheduler.hpp"
+#include "type_inference.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// `compiler --project DIR`: compiles every .py file under DIR. Module names
+// follow the paths (pkg/sub/mod.py is pkg.sub.mod, pkg/__init__.py is pkg).
+// The import statements of each module name the modules it depends on;
+// imports of modules outside DIR are left alone. Modules are compiled in
+// waves: the first holds the modules that import nothing from the project,
+// each later one the modules whose imports are all in earlier waves, and the
+// modules of a wave are compiled concurrently on the scheduler. A module
+// finishes before anything that imports it starts, so `from m import *`
+// binds m's actual module-level names. Modules on an import cycle, and the
+// modules importing them, never become ready; the cycle is reported and
+// they are not compiled.
+//
+// Parsing goes through the global flex/bison state, so the files are parsed
+// one after another before the first wave starts.
+class ProjectBuilder {
+public:
+    // Parses the file at `path` into `arena`
+    typedef std::function<AstNode*(const std::string& path, AstArena& arena)> Parser;
+
+    ProjectBuilder(TaskScheduler& scheduler, Parser parse) : scheduler(scheduler), parse(parse) {}
+
+    ProjectBuilder(const ProjectBuilder&) = delete;
+    ProjectBuilder& operator=(const ProjectBuilder&) = delete;
+
+    // Scope-checks every module, and with emitDir writes each one's C to
+    // emitDir/<module>.c. Diagnostics and the summary go to `report`. False
+    // on an import cycle or a module the C backend rejects.
+    bool build(const std::string& dir, const char* emitDir, std::ostream& report) {
+        auto start = std::chrono::steady_clock::now();
+        scan(dir);
+        for (Module& module : modules) {
+            module.arena.reset(new AstArena());
+            module.root = parse(module.path, *module.arena);
+            ImportCollector collector;
+            if (module.root) {
+                collector.dispatch(module.root);
+            }
+            module.imports = collector.imports;
+        }
+        for (size_t i = 0; i < modules.size(); ++i) {
+            resolveImports(i);
+        }
+        std::vector<std::vector<size_t>> waves = schedule();
+        auto parsed = std::chrono::steady_clock::now();
+
+        if (emitDir) {
+            std::filesystem::create_directories(emitDir);
+        }
+        size_t widest = 0;
+        for (const std::vector<size_t>& wave : waves) {
+            widest = std::max(widest, wave.size());
+            scheduler.parallelFor(wave.size(), [&](size_t k) { compile(modules[wave[k]], emitDir); });
+        }
+        auto built = std::chrono::steady_clock::now();
+
+        bool ok = true;
+        for (const Module& module : modules) {
+            for (const std::string& msg : module.messages) {
+                report << module.path << ": " << msg << std::endl;
+            }
+            ok = ok && !module.failed;
+        }
+        size_t cycles = reportCycles(report);
+        report << "project: " << modules.size() << " modules in " << waves.size() << " waves (widest "
+               << widest << ") on " << scheduler.jobs() << " threads, " << internalImports << " imports within the project, "
+               << externalImports << " of other modules; parsed in "
+               << std::chrono::duration<double, std::milli>(parsed - start).count() << " ms, compiled in "
+               << std::chrono::duration<double, std::milli>(built - parsed).count() << " ms" << std::endl;
+        return ok && cycles == 0;
+    }
+
+private:
+    struct Module {
+        std::string path;
+        std::string name;
+        bool package = false;
+        std::unique_ptr<AstArena> arena;                            // owns the tree
+        AstNode* root = nullptr;
+        std::vector<const ImportStmtNode*> imports;
+        std::vector<size_t> deps;                                   // sorted, unique
+        std::vector<std::pair<const AstNode*, size_t>> starImports; // `from m import *` and m
+        int wave = -1;                                              // -1: waits on a cycle
+        std::vector<std::string> exports;
+        std::vector<std::string> messages;
+        bool failed = false;
+    };
+
+    struct ImportCollector : AstVisitor<ImportCollector> {
+        std::vector<const ImportStmtNode*> imports;
+
+        void visitImport(const ImportStmtNode* n) { imports.push_back(n); }
+    };
+
+    TaskScheduler& scheduler;
+    Parser parse;
+    std::vector<Module> modules;                    // in path order
+    std::unordered_map<std::string, size_t> byName;
+    size_t internalImports = 0;
+    size_t externalImports = 0;
+
+    void scan(const std::string& dir) {
+        namespace fs = std::filesystem;
+        std::vector<fs::path> paths;
+        for (auto it = fs::recursive_directory_iterator(dir); it != fs::recursive_directory_iterator(); ++it) {
+            std::string leaf = it->path().filename().string();
+            if (it->is_directory() && (leaf[0] == '.' || leaf == "__pycache__")) {
+                it.disable_recursion_pending();
+            } else if (it->is_regular_file() && it->path().extension() == ".py") {
+                paths.push_back(it->path());
+            }
+        }
+        std::sort(paths.begin(), paths.end());
+        for (const fs::path& path : paths) {
+            Module module;
+            module.path = path.string();
+            fs::path relative = fs::relative(path, dir).replace_extension();
+            module.package = relative.filename() == "__init__";
+            if (module.package && relative.has_parent_path()) {
+                relative = relative.parent_path();
+            }
+            for (const fs::path& part : relative) {
+                module.name += (module.name.empty() ? "" : ".") + part.string();
+            }
+            if (byName.count(module.name)) {
+                continue;
+            }
+            byName[module.name] = modules.size();
+            modules.push_back(std::move(module));
+        }
+    }
+
+    static std::string parent(const std::string& name) {
+        size_t dot = name.rfind('.');
+        return dot == std::string::npos ? "" : name.substr(0, dot);
+    }
+
+    // Depends on the longest prefix of `name` that is a module of the
+    // project: the module itself, or for `from pkg import f` the package.
+    // The packages around it are not dependencies, or every package whose
+    // __init__ imports its own submodules would be on a cycle.
+    bool depend(Module& module, const std::string& name) {
+        for (std::string prefix = name; !prefix.empty(); prefix = parent(prefix)) {
+            auto it = byName.find(prefix);
+            if (it != byName.end()) {
+                if (&modules[it->second] != &module) {
+                    module.deps.push_back(it->second);
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void resolveImports(size_t index) {
+        Module& module = modules[index];
+        for (const ImportStmtNode* import : module.imports) {
+            if (!import->isFrom()) {
+                for (const auto& imported : import->getNames()) {
+                    ++(depend(module, imported.name) ? internalImports : externalImports);
+                }
+                continue;
+            }
+            std::string base = import->getModule();
+            if (import->getLevel() > 0) {
+                std::string package = module.package ? module.name : parent(module.name);
+                for (int up = 1; up < import->getLevel(); ++up) {
+                    if (package.empty()) {
+                        module.messages.push_back("error: relative import beyond the top-level package");
+                        module.failed = true;
+                        break;
+                    }
+                    package = parent(package);
+                }
+                base = package.empty() ? base : base.empty() ? package : package + "." + base;
+            }
+            bool found = false;
+            for (const auto& imported : import->getNames()) {
+                if (imported.name == "*") {
+                    auto it = byName.find(base);
+                    if (it != byName.end() && it->second != index) {
+                        module.starImports.push_back(std::make_pair((const AstNode*)import, it->second));
+                    }
+                    found = depend(module, base) || found;
+                } else {
+                    found = depend(module, base.empty() ? imported.name : base + "." + imported.name) || found;
+                }
+            }
+            ++(found ? internalImports : externalImports);
+        }
+        std::sort(module.deps.begin(), module.deps.end());
+        module.deps.erase(std::unique(module.deps.begin(), module.deps.end()), module.deps.end());
+    }
+
+    // Kahn's algorithm, one wave per round; modules left without a wave are
+    // on a cycle or import one that is
+    std::vector<std::vector<size_t>> schedule() {
+        std::vector<size_t> waiting(modules.size());
+        std::vector<std::vector<size_t>> importers(modules.size());
+        std::vector<size_t> ready;
+        for (size_t i = 0; i < modules.size(); ++i) {
+            waiting[i] = modules[i].deps.size();
+            for (size_t dep : modules[i].deps) {
+                importers[dep].push_back(i);
+            }
+            if (waiting[i] == 0) {
+                ready.push_back(i);
+            }
+        }
+        std::vector<std::vector<size_t>> waves;
+        while (!ready.empty()) {
+            std::vector<size_t> next;
+            for (size_t i : ready) {
+                modules[i].wave = (int)waves.size();
+                for (size_t importer : importers[i]) {
+                    if (--waiting[importer] == 0) {
+                        next.push_back(importer);
+                    }
+                }
+            }
+            std::sort(next.begin(), next.end());
+            waves.push_back(ready);
+            ready.swap(next);
+        }
+        return waves;
+    }
+
+    void compile(Module& module, const char* emitDir) {
+        if (!module.root || module.failed) {
+            return;
+        }
+        std::unordered_map<const AstNode*, std::vector<std::string>> stars;
+        for (const auto& star : module.starImports) {
+            stars[star.first] = modules[star.second].exports;
+        }
+        ScopeAnalyzer analyzer;
+        analyzer.setStarImports(&stars);
+        SymbolTable symbols = analyzer.analyze(module.root);
+        for (const std::string& msg : symbols.diagnostics) {
+            module.messages.push_back("warning: " + msg);
+        }
+        module.exports = symbols.exports();
+        if (!emitDir) {
+            return;
+        }
+        TypeInference types(symbols);
+        types.run(module.root);
+        CBackend backend(symbols, types);
+        std::ostringstream code;
+        if (!backend.emit(module.root, code)) {
+            module.messages.insert(module.messages.end(), backend.getErrors().begin(), backend.getErrors().end());
+            module.failed = true;
+            return;
+        }
+        std::ofstream out(std::filesystem::path(emitDir) / (module.name + ".c"));
+        out << code.str();
+    }
+
+    // Follows the first unbuilt import of each unbuilt module until the walk
+    // comes back to itself (a cycle) or reaches a module walked before
+    size_t reportCycles(std::ostream& report) {
+        std::vector<int> walk(modules.size(), -1);      // walk that reached the module
+        std::vector<bool> onCycle(modules.size(), false);
+        size_t cycles = 0;
+        for (size_t start = 0; start < modules.size(); ++start) {
+            if (modules[start].wave >= 0 || walk[start] >= 0) {
+                continue;
+            }
+            std::vector<size_t> path;
+            size_t at = start;
+            while (walk[at] < 0) {
+                walk[at] = (int)start;
+                path.push_back(at);
+                for (size_t dep : modules[at].deps) {
+                    if (modules[dep].wave < 0) {
+                        at = dep;
+                        break;
+                    }
+                }
+            }
+            if (walk[at] != (int)start) {
+                continue;
+            }
+            std::string cycle;
+            for (size_t k = std::find(path.begin(), path.end(), at) - path.begin(); k < path.size(); ++k) {
+                cycle += modules[path[k]].name + " -> ";
+                onCycle[path[k]] = true;
+            }
+            report << "error: import cycle: " << cycle << modules[at].name << std::endl;
+            ++cycles;
+        }
+        for (size_t i = 0; i < modules.size(); ++i) {
+            if (modules[i].wave < 0) {
+                report << modules[i].path << ": not compiled, "
+                       << (onCycle[i] ? "it is on an import cycle" : "it imports a module on an import cycle") << std::endl;
+            }
+        }
+        return cycles;
+    }
+};
+
+#endif
@@ -0,0 +1,114 @@
+/*
+* @name pyclient.c
+* @description client for `compiler --serve SOCKET`: sends its command line
+*              as one compile request and prints the answer as `compiler`
+*              would have, exiting with its status
+* @author fadel-hasan
+*
+* usage: pyclient SOCKET [compiler arguments...]
+*        pyclient SOCKET --stop        (stops the server)
+*/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static int write_all(int fd, const void* data, size_t size)
+{
+    const char* p = (const char*)data;
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n <= 0)
+            return 0;
+        p += n;
+        size -= n;
+    }
+    return 1;
+}
+
+static int read_all(int fd, void* data, size_t size)
+{
+    char* p = (char*)data;
+    while (size > 0) {
+        ssize_t n = read(fd, p, size);
+        if (n <= 0)
+            return 0;
+        p += n;
+        size -= n;
+    }
+    return 1;
+}
+
+static int send_string(int fd, const char* s)
+{
+    uint32_t size = (uint32_t)strlen(s);
+    return write_all(fd, &size, sizeof(size)) && write_all(fd, s, size);
+}
+
+/* Copies one length-prefixed blob of the response to `out` */
+static int copy_blob(int fd, FILE* out)
+{
+    uint32_t size;
+    char buffer[1 << 16];
+    if (!read_all(fd, &size, sizeof(size)))
+        return 0;
+    while (size > 0) {
+        size_t chunk = size < sizeof(buffer) ? size : sizeof(buffer);
+        if (!read_all(fd, buffer, chunk))
+            return 0;
+        fwrite(buffer, 1, chunk, out);
+        size -= chunk;
+    }
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    struct sockaddr_un address;
+    char cwd[4096];
+    uint32_t count;
+    int32_t status;
+    int stop = argc == 3 && strcmp(argv[2], "--stop") == 0;
+    int fd, i;
+
+    if (argc < 2 || strlen(argv[1]) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "usage: %s SOCKET [compiler arguments...]\n", argv[0]);
+        return 2;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, argv[1]);
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        perror(argv[1]);
+        return 2;
+    }
+    if (getcwd(cwd, sizeof(cwd)) == NULL) {
+        perror("getcwd");
+        return 2;
+    }
+
+    /* the working directory, then `compiler` and our own arguments */
+    count = stop ? 0 : (uint32_t)argc;
+    if (!write_all(fd, &count, sizeof(count))
+        || (!stop && (!send_string(fd, cwd) || !send_string(fd, "compiler")))) {
+        perror("pyclient");
+        return 2;
+    }
+    for (i = 2; !stop && i < argc; i++) {
+        if (!send_string(fd, argv[i])) {
+            perror("pyclient");
+            return 2;
+        }
+    }
+
+    if (!read_all(fd, &status, sizeof(status)) || !copy_blob(fd, stdout) || !copy_blob(fd, stderr)) {
+        fprintf(stderr, "pyclient: the server closed the connection\n");
+        return 2;
+    }
+    close(fd);
+    return status;
+}
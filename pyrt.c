@@ -0,0 +1,161 @@
+/*
+* @name pyrt.c
+* @description runtime library for C emitted by `compiler --emit-c`
+* @author fadel-hasan
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pyrt.h"
+
+void pyrt_fatal(const char* kind, const char* msg)
+{
+    fprintf(stderr, "%s: %s\n", kind, msg);
+    exit(1);
+}
+
+static int is_number(pyrt_value v)
+{
+    return v.tag == PYRT_BOOL || v.tag == PYRT_INT || v.tag == PYRT_FLOAT;
+}
+
+static double as_double(pyrt_value v)
+{
+    return v.tag == PYRT_FLOAT ? v.as.f : (double)v.as.i;
+}
+
+static void check_operands(pyrt_value a, pyrt_value b, const char* op)
+{
+    if (!is_number(a) || !is_number(b)) {
+        char msg[64];
+        snprintf(msg, sizeof(msg), "unsupported operand type(s) for %s", op);
+        pyrt_fatal("TypeError", msg);
+    }
+}
+
+pyrt_value pyrt_add(pyrt_value a, pyrt_value b)
+{
+    check_operands(a, b, "+");
+    if (a.tag == PYRT_FLOAT || b.tag == PYRT_FLOAT)
+        return pyrt_float(as_double(a) + as_double(b));
+    return pyrt_int(pyrt_iadd(a.as.i, b.as.i));
+}
+
+pyrt_value pyrt_sub(pyrt_value a, pyrt_value b)
+{
+    check_operands(a, b, "-");
+    if (a.tag == PYRT_FLOAT || b.tag == PYRT_FLOAT)
+        return pyrt_float(as_double(a) - as_double(b));
+    return pyrt_int(pyrt_isub(a.as.i, b.as.i));
+}
+
+pyrt_value pyrt_mul(pyrt_value a, pyrt_value b)
+{
+    check_operands(a, b, "*");
+    if (a.tag == PYRT_FLOAT || b.tag == PYRT_FLOAT)
+        return pyrt_float(as_double(a) * as_double(b));
+    return pyrt_int(pyrt_imul(a.as.i, b.as.i));
+}
+
+/* `/` is true division: the result is always a float */
+pyrt_value pyrt_div(pyrt_value a, pyrt_value b)
+{
+    check_operands(a, b, "/");
+    if (as_double(b) == 0.0)
+        pyrt_fatal("ZeroDivisionError", "division by zero");
+    return pyrt_float(as_double(a) / as_double(b));
+}
+
+pyrt_value pyrt_neg(pyrt_value a)
+{
+    if (!is_number(a))
+        pyrt_fatal("TypeError", "bad operand type for unary -");
+    if (a.tag == PYRT_FLOAT)
+        return pyrt_float(-a.as.f);
+    return pyrt_int(pyrt_ineg(a.as.i));
+}
+
+pyrt_value pyrt_not(pyrt_value a)
+{
+    return pyrt_bool(!pyrt_truthy(a));
+}
+
+int pyrt_truthy(pyrt_value v)
+{
+    switch (v.tag) {
+    case PYRT_NONE:
+        return 0;
+    case PYRT_FLOAT:
+        return v.as.f != 0.0;
+    default:
+        return v.as.i != 0;
+    }
+}
+
+int pyrt_compare(pyrt_value a, pyrt_value b, int op)
+{
+    if (op == PYRT_EQ || op == PYRT_NEQ) {
+        int equal;
+        if (is_number(a) && is_number(b))
+            equal = (a.tag == PYRT_FLOAT || b.tag == PYRT_FLOAT) ? as_double(a) == as_double(b)
+                                                                 : a.as.i == b.as.i;
+        else
+            equal = a.tag == b.tag;
+        return op == PYRT_EQ ? equal : !equal;
+    }
+    check_operands(a, b, "comparison");
+    if (a.tag != PYRT_FLOAT && b.tag != PYRT_FLOAT) {
+        switch (op) {
+        case PYRT_LT:  return a.as.i < b.as.i;
+        case PYRT_GT:  return a.as.i > b.as.i;
+        case PYRT_LTE: return a.as.i <= b.as.i;
+        default:       return a.as.i >= b.as.i;
+        }
+    }
+    switch (op) {
+    case PYRT_LT:  return as_double(a) < as_double(b);
+    case PYRT_GT:  return as_double(a) > as_double(b);
+    case PYRT_LTE: return as_double(a) <= as_double(b);
+    default:       return as_double(a) >= as_double(b);
+    }
+}
+
+/* Shortest representation that reads back to the same double, like repr() */
+static void print_float(double f)
+{
+    char buf[32];
+    int precision;
+    for (precision = 1; precision <= 17; precision++) {
+        snprintf(buf, sizeof(buf), "%.*g", precision, f);
+        if (strtod(buf, NULL) == f)
+            break;
+    }
+    if (strspn(buf, "-0123456789") == strlen(buf))
+        strcat(buf, ".0");
+    fputs(buf, stdout);
+}
+
+pyrt_value pyrt_print(int argc, const pyrt_value* argv)
+{
+    int i;
+    for (i = 0; i < argc; i++) {
+        if (i > 0)
+            putchar(' ');
+        switch (argv[i].tag) {
+        case PYRT_NONE:
+            fputs("None", stdout);
+            break;
+        case PYRT_BOOL:
+            fputs(argv[i].as.i ? "True" : "False", stdout);
+            break;
+        case PYRT_INT:
+            printf("%lld", (long long)argv[i].as.i);
+            break;
+        case PYRT_FLOAT:
+            print_float(argv[i].as.f);
+            break;
+        }
+    }
+    putchar('\n');
+    return pyrt_none();
+}
@@ -0,0 +1,117 @@
+/*
+* @name pyrt.h
+* @description runtime library for C emitted by `compiler --emit-c`
+* @author fadel-hasan
+*/
+#ifndef PYRT_H
+#define PYRT_H
+
+#include <stdint.h>
+
+/* Boxed value for everything the type inference could not prove to be an
+   int. Passed by value, so no value ever lives on the heap. */
+typedef enum { PYRT_NONE = 0, PYRT_BOOL, PYRT_INT, PYRT_FLOAT } pyrt_tag;
+
+typedef struct {
+    pyrt_tag tag;
+    union {
+        int64_t i;
+        double f;
+    } as;
+} pyrt_value;
+
+enum { PYRT_LT, PYRT_GT, PYRT_LTE, PYRT_GTE, PYRT_EQ, PYRT_NEQ };
+
+static inline pyrt_value pyrt_none(void) {
+    pyrt_value v;
+    v.tag = PYRT_NONE;
+    v.as.i = 0;
+    return v;
+}
+
+static inline pyrt_value pyrt_bool(int b) {
+    pyrt_value v;
+    v.tag = PYRT_BOOL;
+    v.as.i = b != 0;
+    return v;
+}
+
+static inline pyrt_value pyrt_int(int64_t i) {
+    pyrt_value v;
+    v.tag = PYRT_INT;
+    v.as.i = i;
+    return v;
+}
+
+static inline pyrt_value pyrt_float(double f) {
+    pyrt_value v;
+    v.tag = PYRT_FLOAT;
+    v.as.f = f;
+    return v;
+}
+
+void pyrt_fatal(const char* kind, const char* msg);
+
+/* Unboxed int arithmetic. Python ints never overflow; ours are 64 bits, so a
+   result that does not fit stops the program instead of wrapping silently. */
+#define pyrt_overflow() pyrt_fatal("OverflowError", "integer result does not fit in 64 bits")
+
+static inline int64_t pyrt_iadd(int64_t a, int64_t b) {
+    int64_t r;
+#if defined(__GNUC__) || defined(__clang__)
+    if (__builtin_add_overflow(a, b, &r))
+        pyrt_overflow();
+#else
+    if ((b > 0 && a > INT64_MAX - b) || (b < 0 && a < INT64_MIN - b))
+        pyrt_overflow();
+    r = a + b;
+#endif
+    return r;
+}
+
+static inline int64_t pyrt_isub(int64_t a, int64_t b) {
+    int64_t r;
+#if defined(__GNUC__) || defined(__clang__)
+    if (__builtin_sub_overflow(a, b, &r))
+        pyrt_overflow();
+#else
+    if ((b < 0 && a > INT64_MAX + b) || (b > 0 && a < INT64_MIN + b))
+        pyrt_overflow();
+    r = a - b;
+#endif
+    return r;
+}
+
+static inline int64_t pyrt_imul(int64_t a, int64_t b) {
+    int64_t r;
+#if defined(__GNUC__) || defined(__clang__)
+    if (__builtin_mul_overflow(a, b, &r))
+        pyrt_overflow();
+#else
+    if (a > 0 ? (b > 0 ? a > INT64_MAX / b : b < INT64_MIN / a)
+              : (b > 0 ? a < INT64_MIN / b : (a != 0 && b < INT64_MAX / a)))
+        pyrt_overflow();
+    r = a * b;
+#endif
+    return r;
+}
+
+static inline int64_t pyrt_ineg(int64_t a) {
+    if (a == INT64_MIN)
+        pyrt_overflow();
+    return -a;
+}
+
+pyrt_value pyrt_add(pyrt_value a, pyrt_value b);
+pyrt_value pyrt_sub(pyrt_value a, pyrt_value b);
+pyrt_value pyrt_mul(pyrt_value a, pyrt_value b);
+pyrt_value pyrt_div(pyrt_value a, pyrt_value b);
+pyrt_value pyrt_neg(pyrt_value a);
+pyrt_value pyrt_not(pyrt_value a);
+
+int pyrt_truthy(pyrt_value v);
+int pyrt_compare(pyrt_value a, pyrt_value b, int op);
+
+pyrt_value pyrt_print(int argc, const pyrt_value* argv);
+
+#endif
@@ -1,20 +1,226 @@
 #ifndef AST_NODE_H
 #define AST_NODE_H
 
+#include <cstdint>
+#include <cstddef>
 #include <iostream>
+#include <string>
+#include <utility>
 #include <vector>
+#include "source_map.hpp"
 // #include <stdlib.h>
 
 
-// Abstract base class for AST nodes
+// Every concrete node class as X(kind, class), in declaration order. It
+// expands to NodeKind below and to the dispatch switch of AstVisitor
+// (ast_visitor.hpp); a new node class needs a line here.
+#define PYTHON_AST_NODES(X) \
+    X(Function, FunctionNode)                     \
+    X(Identifier, IdentifierNode)                 \
+    X(Arg, Arg)                                   \
+    X(Args, Args)                                 \
+    X(FunctionCall, FunctionCallNode)             \
+    X(While, WhileStatementNode)                  \
+    X(Comparison, ComparisonNode)                 \
+    X(PrimaryExpression, PrimaryExpressionNode)   \
+    X(NegatedExpression, NegatedExpressionNode)   \
+    X(Expression, ExpressionNode)                 \
+    X(CompOp, CompOpNode)                         \
+    X(For, ForStatementNode)                      \
+    X(ForHeader, ForHeaderNode)                   \
+    X(Changes, ChangesNode)                       \
+    X(Range, RangeNode)                           \
+    X(MyFunc, MyFuncNode)                         \
+    X(MyRange, MyRangeNode)                       \
+    X(Try, TryStatementNode)                      \
+    X(TryStmts, TryStmtsNode)                     \
+    X(ExceptBlock, ExceptBlockNode)               \
+    X(FinallyBlock, FinallyBlockNode)             \
+    X(Decorators, DecoratorsNode)                 \
+    X(ClassDef, ClassDefNode)                     \
+    X(ClassDefRaw, ClassDefRawNode)               \
+    X(NamedExpression, NamedExpressionNode)       \
+    X(With, WithStmtNode)                         \
+    X(WithItems, WithItemsNode)                   \
+    X(WithItemList, WithItemList)                 \
+    X(WithItem, WithItem)                         \
+    X(Arguments, ArgumentsNode)                   \
+    X(Argument, ArgumentNode)                     \
+    X(Global, GlobalStmtNode)                     \
+    X(Nonlocal, NonlocalStmtNode)                 \
+    X(Import, ImportStmtNode)                     \
+    X(Yield, YieldStmtNode)                       \
+    X(YieldExpr, YieldExprNode)                   \
+    X(If, IfStatementNode)                        \
+    X(IfHeader, IfHeaderNode)                     \
+    X(ElifElse, ElifElseNode)                     \
+    X(ElifStmts, ElifStmtsNode)                   \
+    X(Elif, ElifStmtNode)                         \
+    X(ElifHeader, ElifHeaderNode)                 \
+    X(Else, ElseStmtNode)                         \
+    X(Match, MatchStmtNode)                       \
+    X(MatchCases, MatchCasesNode)                 \
+    X(MatchCase, MatchCaseNode)                   \
+    X(PatternList, PatternListNode)               \
+    X(Pattern, PatternNode)                       \
+    X(ListPattern, ListPatternNode)               \
+    X(DictPattern, DictPatternNode)               \
+    X(DictPatternEntries, DictPatternEntriesNode) \
+    X(DictPatternEntry, DictPatternEntryNode)     \
+    X(Block, BlockNode)                           \
+    X(Statements, StatementsNode)                 \
+    X(Assignment, assignmentStatement)            \
+    X(Number, NumberNode)                         \
+    X(Literal, LiteralNode)                       \
+    X(BinaryExpression, BinaryExpressionNode)     \
+    X(Break, BreakStmtNode)                       \
+    X(Continue, ContinueStmtNode)                 \
+    X(Pass, PassStmtNode)                         \
+    X(Return, ReturnStatementNode)
+
+enum class NodeKind : uint8_t {
+#define X(kind, type) kind,
+    PYTHON_AST_NODES(X)
+#undef X
+};
+
+inline const char* nodeKindName(NodeKind kind) {
+    switch (kind) {
+#define X(kind, type) case NodeKind::kind: return #kind;
+        PYTHON_AST_NODES(X)
+#undef X
+    }
+    return "?";
+}
+
+const size_t nodeKindCount = 0
+#define X(kind, type) + 1
+    PYTHON_AST_NODES(X)
+#undef X
+    ;
+
+class AstArena;
+
+// Abstract base class for AST nodes. Passes traverse the tree through
+// AstVisitor, which dispatches on `kind`; printing it as a Graphviz graph
+// is one such pass (dot_printer.hpp).
+//
+// A node belongs to the AstArena that was current when it was made and is
+// destroyed with it, never on its own: parents hold plain pointers to their
+// children, so the grammar can drop a token's node or hand a child to two
+// parents without leaking it or freeing it twice.
 class AstNode {
 public:
+    const NodeKind kind;
+    // Reached from more than one parent: an expression --hash-cons found
+    // twice (hash_cons.hpp)
+    bool shared = false;
+    // Bytes of the source the node was parsed from: the span of the rule
+    // being reduced when it was made (parseSpan, set by the parser before
+    // each action), or of its token for the leaves the grammar places with
+    // at(). Nodes a rule extends after making them, like a block's
+    // statements, are widened over their children by tree_writer.hpp.
+    // Declared here, it fills the padding after the two fields above.
+    SourceSpan span;
     std::string name = "undefined";   // String member variable with default value
     std::string label = "undefined";
+    static inline SourceSpan parseSpan;
+    explicit AstNode(NodeKind kind);
     virtual void add(AstNode* node) = 0;
-    virtual void print() const = 0;
-    virtual ~AstNode() {}
-    
+
+    // Nodes of each kind made and not yet destroyed, all the nodes ever made
+    // and those made with no arena current to own them (mem_audit.hpp)
+    static size_t* live() {
+        static size_t counts[nodeKindCount];
+        return counts;
+    }
+    static inline size_t made = 0;
+    static inline size_t unowned = 0;
+
+protected:
+    friend class AstArena;
+    virtual ~AstNode() { --live()[(size_t)kind]; }
+};
+
+// Owner of one tree's nodes: every node made while an arena is current is
+// added to it, and all of them are deleted with it. A compile makes one
+// current for its parse, a --project build one per module.
+class AstArena {
+public:
+    AstArena() {}
+
+    ~AstArena() {
+        for (AstNode* node : nodes) {
+            delete node;
+        }
+    }
+
+    AstArena(const AstArena&) = delete;
+    AstArena& operator=(const AstArena&) = delete;
+
+    size_t size() const { return nodes.size(); }
+
+    // Deletes `node`, which must be the last one made in this arena: a
+    // node the grammar built and then found it already had (hash_cons.hpp)
+    void discard(AstNode* node) {
+        if (!nodes.empty() && nodes.back() == node) {
+            nodes.pop_back();
+            delete node;
+        }
+    }
+
+    // Deletes every node made after the first `count`: a module-level
+    // statement --select leaves out, as soon as it is parsed (selection.hpp)
+    void truncate(size_t count) {
+        while (nodes.size() > count) {
+            delete nodes.back();
+            nodes.pop_back();
+        }
+    }
+
+    static AstArena*& current() {
+        static AstArena* arena = nullptr;
+        return arena;
+    }
+
+    // Makes an arena current for as long as the Use lives
+    class Use {
+    public:
+        explicit Use(AstArena& arena) : previous(current()) { current() = &arena; }
+        ~Use() { current() = previous; }
+
+        Use(const Use&) = delete;
+        Use& operator=(const Use&) = delete;
+
+    private:
+        AstArena* previous;
+    };
+
+private:
+    friend class AstNode;
+    std::vector<AstNode*> nodes;
+};
+
+inline AstNode::AstNode(NodeKind kind) : kind(kind), span(parseSpan) {
+    ++live()[(size_t)kind];
+    ++made;
+    if (AstArena::current()) {
+        AstArena::current()->nodes.push_back(this);
+    } else {
+        ++unowned;
+    }
+}
+
+// How a name was classified by the scope pass (scope_analysis.hpp)
+enum class NameKind { Unresolved, Local, Global, Nonlocal, Free, Builtin };
+
+// Resolved binding of a name: slot indexes the frame (Local), the module
+// globals (Global) or the builtin table (Builtin), depth counts the enclosing
+// function scopes to walk up for Nonlocal/Free names
+struct NameBinding {
+    NameKind kind = NameKind::Unresolved;
+    int slot = -1;
+    int depth = 0;
 };
 
 
@@ -26,8 +232,10 @@ private:
     std::vector<AstNode*> next;
 
 public:
-    FunctionNode(const std::string& name) {
-        this->name = name;
+    NameBinding binding;   // binding of the function name in the enclosing scope
+
+    FunctionNode(std::string name) : AstNode(NodeKind::Function) {
+        this->name = std::move(name);
         this->label = "Declare Fun";
     }
 
@@ -35,27 +243,8 @@ public:
         next.push_back(node);
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label <<" : "<<name<<"\"]" << std::endl;
-        std::vector<AstNode*>::iterator it;
-        // for (it = next.begin(); it != next.end(); ++it) {
-        //     // example
-        //     // Func -> args
-        //     // Func -> body
-        //     std::cout << "\t" << name << " -> " << (*it)->name << ";" << std::endl;
-        //     (*it)->print();
-        // }
-        for (const auto& item : next) {
-            std::cout << "\t" << name << " -> " << item->name << ";" << std::endl;
-            item->print();
-        }
-    }
-
-    ~FunctionNode() {
-        for (const auto& arg : next) {
-            delete arg;
-        }
-    }
+    AstNode* getArgs() const { return next.size() > 0 ? next[0] : nullptr; }
+    AstNode* getBody() const { return next.size() > 1 ? next[1] : nullptr; }
 };
 
 // base node for representing identifier ,will create object  from lexer
@@ -63,19 +252,15 @@ class IdentifierNode : public AstNode {
 
 public:
     std::string value = "undefined";
-    IdentifierNode(std::string name, std::string label, std::string value) {
-        this->name = name;
-        this->label = label;
-        this->value = value; 
+    NameBinding binding;
+    IdentifierNode(std::string name, std::string label, std::string value) : AstNode(NodeKind::Identifier) {
+        this->name = std::move(name);
+        this->label = std::move(label);
+        this->value = std::move(value);
     }
     void add(AstNode* /*node*/) override {
         std::cerr << "Cannot add a child to a leaf node." << std::endl;
     }
-
-    void print() const override {
-        std::cout << "\t" << name << " [shape=box,label=\"" << label << ": " << value << "\"]" << std::endl;
-
-    }
 };
 
 
@@ -84,7 +269,7 @@ private:
     std::vector<AstNode*> next;
 
 public:
-    Arg(const std::string& name) {
+    Arg(const std::string& name) : AstNode(NodeKind::Arg) {
         this->name = name;
         this->label = "Argument";
     }
@@ -93,12 +278,7 @@ public:
         next.push_back(node);
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << "\"]" << std::endl;
-        for (const auto& arg : next) {
-            arg->print();
-        }
-    }
+    const std::vector<AstNode*>& getNames() const { return next; }
 };
 
 
@@ -108,7 +288,7 @@ private:
     std::vector<AstNode*> next;
 
 public:
-    Args(const std::string& name) {
+    Args(const std::string& name) : AstNode(NodeKind::Args) {
         this->name = name;
         this->label = "Arguments";
     }
@@ -117,14 +297,7 @@ public:
         next.push_back(node);
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << "\"]" << std::endl;
-
-        for (const auto& arg : next) {
-            std::cout << "\t" << name << " -> " << arg->name << ";" << std::endl;
-            arg->print();
-        }
-    }
+    const std::vector<AstNode*>& getArgs() const { return next; }
 };
 
 /*
@@ -149,12 +322,6 @@ public:
             arg->print();
         }
     }
-
-    ~FunctionCallNode() {
-        for (const auto& arg : arguments) {
-            delete arg;
-        }
-    }
 };
 */
 class WhileStatementNode : public AstNode {
@@ -163,8 +330,11 @@ private:
     AstNode* body;      // The body to be executed while the condition is true
 
 public:
+    int hoistFirst = 0;    // loop-invariant value slots cleared on entry
+    int hoistCount = 0;
+
     WhileStatementNode(AstNode* cond, AstNode* bod)
-        : condition(cond), body(bod) {
+        : AstNode(NodeKind::While), condition(cond), body(bod) {
         this->name = "While";
         this->label = "While Statement";
     }
@@ -175,22 +345,8 @@ public:
         // Implementation depends on the specific needs of your AST structure
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << " : " << name << "\"]" << std::endl;
-        if (condition) {
-            std::cout << "\t" << name << " -> " << condition->name << " [label=\"condition\"];" << std::endl;
-            condition->print();
-        }
-        if (body) {
-            std::cout << "\t" << name << " -> " << body->name << " [label=\"body\"];" << std::endl;
-            body->print();
-        }
-    }
-
-    ~WhileStatementNode() {
-        delete condition;
-        delete body;
-    }
+    AstNode* getCondition() const { return condition; }
+    AstNode* getBody() const { return body; }
 };
 
 
@@ -201,31 +357,24 @@ private:
     AstNode* rightExpression;
 
 public:
-    ComparisonNode(AstNode* left, const std::string& op, AstNode* right) {
+    int hoisted = -1;      // loop-invariant value slot, see loop_invariant.hpp
+
+    ComparisonNode(AstNode* left, std::string op, AstNode* right) : AstNode(NodeKind::Comparison) {
         this->leftExpression = left;
-        this->compOp = op;
+        this->compOp = std::move(op);
         this->rightExpression = right;
         this->name = "Comparison";
         this->label = "Comparison";
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << " : " << compOp << "\"]" << std::endl;
-        if (leftExpression) {
-            std::cout << "\t" << name << " -> " << leftExpression->name << " [label=\"left\"];" << std::endl;
-            leftExpression->print();
-        }
-        if (rightExpression) {
-            std::cout << "\t" << name << " -> " << rightExpression->name << " [label=\"right\"];" << std::endl;
-            rightExpression->print();
-        }
+    // ComparisonNode does not have additional children, so the add method can be a no-op
+    void add(AstNode* node) override {
+        // No operation, as comparison nodes do not have additional child nodes
     }
 
-
-    ~ComparisonNode() {
-        delete leftExpression;
-        delete rightExpression;
-    }
+    AstNode* getLeft() const { return leftExpression; }
+    const std::string& getOp() const { return compOp; }
+    AstNode* getRight() const { return rightExpression; }
 };
 
 class PrimaryExpressionNode : public AstNode {
@@ -233,8 +382,11 @@ private:
     std::string value;
 
 public:
-    PrimaryExpressionNode(const std::string& val) {
-        this->value = val;
+    NameBinding binding;   // only meaningful when value is a name
+    int constant = -1;     // constant pool index when value is a literal
+
+    PrimaryExpressionNode(std::string val) : AstNode(NodeKind::PrimaryExpression) {
+        this->value = std::move(val);
         this->name = "PrimaryExpression";
         this->label = "Primary Expression";
     }
@@ -244,9 +396,7 @@ public:
         // No operation, as primary expressions do not have child nodes
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << " : " << value << "\"]" << std::endl;
-    }
+    const std::string& getValue() const { return value; }
 };
 
 class NegatedExpressionNode : public AstNode {
@@ -254,7 +404,9 @@ private:
     AstNode* primaryExpression;
 
 public:
-    NegatedExpressionNode(AstNode* primary) {
+    int hoisted = -1;      // loop-invariant value slot, see loop_invariant.hpp
+
+    NegatedExpressionNode(AstNode* primary) : AstNode(NodeKind::NegatedExpression) {
         this->primaryExpression = primary;
         this->name = "NegatedExpression";
         this->label = "Negated Expression";
@@ -265,17 +417,7 @@ public:
         // No operation, as negated expressions do not have additional child nodes
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << "\"]" << std::endl;
-        if (primaryExpression) { // Check if primaryExpression is not null
-            std::cout << "\t" << name << " -> " << primaryExpression->name << ";" << std::endl;
-            primaryExpression->print();
-        }
-    }
-
-    ~NegatedExpressionNode() {
-        delete primaryExpression;
-    }
+    AstNode* getOperand() const { return primaryExpression; }
 };
 
 class ExpressionNode : public AstNode {
@@ -285,8 +427,10 @@ private:
     AstNode* rightExpression;
 
 public:
+    int hoisted = -1;      // loop-invariant value slot, see loop_invariant.hpp
+
     ExpressionNode(const std::string& op, AstNode* left, AstNode* right)
-        : op(op), leftExpression(left), rightExpression(right) {
+        : AstNode(NodeKind::Expression), op(op), leftExpression(left), rightExpression(right) {
         this->name = "Expression";
         this->label = "Expression";
     }
@@ -296,22 +440,9 @@ public:
         // No operation, as expression nodes do not have additional child nodes
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << " : " << op << "\"]" << std::endl;
-        if (leftExpression) { // Check if leftExpression is not null
-            std::cout << "\t" << name << " -> " << leftExpression->name << ";" << std::endl;
-            leftExpression->print();
-        }
-        if (rightExpression) { // Check if rightExpression is not null
-            std::cout << "\t" << name << " -> " << rightExpression->name << ";" << std::endl;
-            rightExpression->print();
-        }
-    }
-
-    ~ExpressionNode() {
-        delete leftExpression;
-        delete rightExpression;
-    }
+    const std::string& getOp() const { return op; }
+    AstNode* getLeft() const { return leftExpression; }
+    AstNode* getRight() const { return rightExpression; }
 };
 
 class CompOpNode : public AstNode {
@@ -319,7 +450,7 @@ private:
     std::string op;
 
 public:
-    CompOpNode(const std::string& op) : op(op) {
+    CompOpNode(const std::string& op) : AstNode(NodeKind::CompOp), op(op) {
         this->name = "CompOp";
         this->label = "Comp Op";
     }
@@ -329,9 +460,7 @@ public:
         // No operation, as CompOp nodes do not have child nodes
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << " : " << op << "\"]" << std::endl;
-    }
+    const std::string& getOp() const { return op; }
 };
 
 class ForStatementNode : public AstNode {
@@ -341,8 +470,11 @@ private:
     AstNode* block;
 
 public:
+    int hoistFirst = 0;    // loop-invariant value slots cleared on entry
+    int hoistCount = 0;
+
     ForStatementNode(AstNode* header, AstNode* changes, AstNode* block)
-        : forHeader(header), changes(changes), block(block) {
+        : AstNode(NodeKind::For), forHeader(header), changes(changes), block(block) {
         this->name = "ForStatement";
         this->label = "For Statement";
     }
@@ -352,27 +484,9 @@ public:
         // No operation, as for statements do not have additional child nodes
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << " : " << name << "\"]" << std::endl;
-        if (forHeader) {
-            std::cout << "\t" << name << " -> " << forHeader->name << ";" << std::endl;
-            forHeader->print();
-        }
-        if (changes) {
-            std::cout << "\t" << name << " -> " << changes->name << ";" << std::endl;
-            changes->print();
-        }
-        if (block) {
-            std::cout << "\t" << name << " -> " << block->name << ";" << std::endl;
-            block->print();
-        }
-    }
-
-    ~ForStatementNode() {
-        delete forHeader;
-        delete changes;
-        delete block;
-    }
+    AstNode* getHeader() const { return forHeader; }
+    AstNode* getChanges() const { return changes; }
+    AstNode* getBlock() const { return block; }
 };
 
 class ForHeaderNode : public AstNode {
@@ -380,8 +494,10 @@ private:
     std::string identifier;
 
 public:
-    ForHeaderNode(const std::string& id) {
-        this->identifier = id;
+    NameBinding binding;
+
+    ForHeaderNode(std::string id) : AstNode(NodeKind::ForHeader) {
+        this->identifier = std::move(id);
         this->name = "ForHeader";
         this->label = "For Header";
     }
@@ -391,9 +507,7 @@ public:
         // No operation, as ForHeader nodes do not have child nodes
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << " : " << identifier << "\"]" << std::endl;
-    }
+    const std::string& getIdentifier() const { return identifier; }
 };
 class ChangesNode : public AstNode {
 private:
@@ -401,7 +515,9 @@ private:
     AstNode* range;
 
 public:
-    ChangesNode(const std::string& id) : identifier(id), range(nullptr) {
+    NameBinding binding;
+
+    ChangesNode(std::string id) : AstNode(NodeKind::Changes), identifier(std::move(id)), range(nullptr) {
         this->name = "Changes";
         this->label = "Changes";
     }
@@ -413,17 +529,8 @@ public:
         }
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << " : " << identifier << "\"]" << std::endl;
-        if (range) {
-            std::cout << "\t" << name << " -> " << range->name << ";" << std::endl;
-            range->print();
-        }
-    }
-
-    ~ChangesNode() {
-        delete range;
-    }
+    const std::string& getIdentifier() const { return identifier; }
+    AstNode* getRange() const { return range; }
 };
 
 class RangeNode : public AstNode {
@@ -431,7 +538,7 @@ private:
     std::vector<int> values;
 
 public:
-    RangeNode(const std::vector<int>& vals) : values(vals) {
+    RangeNode(const std::vector<int>& vals) : AstNode(NodeKind::Range), values(vals) {
         this->name = "Range";
         this->label = "Range";
     }
@@ -441,16 +548,7 @@ public:
         // No operation, as Range nodes do not have child nodes
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << " : ";
-        for (size_t i = 0; i < values.size(); ++i) {
-            std::cout << values[i];
-            if (i < values.size() - 1) {
-                std::cout << ", ";
-            }
-        }
-        std::cout << "\"]" << std::endl;
-    }
+    const std::vector<int>& getValues() const { return values; }
 };
 
 class MyFuncNode : public AstNode {
@@ -461,7 +559,9 @@ private:
     // std::vector<AstNode*> children;
 
 public:
-    MyFuncNode(const std::string& id) : identifier(id) {
+    NameBinding binding;
+
+    MyFuncNode(std::string id) : AstNode(NodeKind::MyFunc), identifier(std::move(id)) {
         this->name = "MyFunc";
         this->label = "My Func";
     }
@@ -472,10 +572,7 @@ public:
         // Otherwise, if MyFuncNode does not have children, this method can be a no-op.
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << " : " << identifier << "\"]" << std::endl;
-        // If MyFuncNode has children, you should also print them here.
-    }
+    const std::string& getIdentifier() const { return identifier; }
 };
 
 class MyRangeNode : public AstNode {
@@ -483,7 +580,7 @@ private:
     std::vector<int> values;
 
 public:
-    MyRangeNode(const std::vector<int>& vals) : values(vals) {
+    MyRangeNode(std::vector<int> vals) : AstNode(NodeKind::MyRange), values(std::move(vals)) {
         this->name = "MyRange";
         this->label = "My Range";
     }
@@ -493,16 +590,7 @@ public:
         // No operation, as MyRange nodes do not have child nodes
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << " : ";
-        for (size_t i = 0; i < values.size(); ++i) {
-            std::cout << values[i];
-            if (i < values.size() - 1) {
-                std::cout << ", ";
-            }
-        }
-        std::cout << "\"]" << std::endl;
-    }
+    const std::vector<int>& getValues() const { return values; }
 };
 
 class TryStatementNode : public AstNode {
@@ -512,7 +600,7 @@ private:
 
 public:
     TryStatementNode(AstNode* block, AstNode* tryStmts)
-        : block(block), tryStmts(tryStmts) {
+        : AstNode(NodeKind::Try), block(block), tryStmts(tryStmts) {
         this->name = "TryStatement";
         this->label = "Try Statement";
     }
@@ -525,22 +613,8 @@ public:
         // std::vector<AstNode*> children;
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << " : " << name << "\"]" << std::endl;
-        if (block) { // Check if block is not null
-            std::cout << "\t" << name << " -> " << block->name << ";" << std::endl;
-            block->print();
-        }
-        if (tryStmts) { // Check if tryStmts is not null
-            std::cout << "\t" << name << " -> " << tryStmts->name << ";" << std::endl;
-            tryStmts->print();
-        }
-    }
-
-    ~TryStatementNode() {
-        delete block;
-        delete tryStmts;
-    }
+    AstNode* getBlock() const { return block; }
+    AstNode* getTryStmts() const { return tryStmts; }
 };
 
 class TryStmtsNode : public AstNode {
@@ -548,24 +622,14 @@ private:
     std::vector<AstNode*> tryStmts;
 
 public:
+    TryStmtsNode() : AstNode(NodeKind::TryStmts) {}
+
     // Override the add method to handle child nodes
     void add(AstNode* node) override {
         tryStmts.push_back(node);
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << " : " << name << "\"]" << std::endl;
-        for (const auto& stmt : tryStmts) {
-            std::cout << "\t" << name << " -> " << stmt->name << ";" << std::endl;
-            stmt->print();
-        }
-    }
-
-    ~TryStmtsNode() {
-        for (auto& stmt : tryStmts) {
-            delete stmt;
-        }
-    }
+    const std::vector<AstNode*>& getTryStmts() const { return tryStmts; }
 };
 
 class ExceptBlockNode : public AstNode {
@@ -574,8 +638,8 @@ private:
     AstNode* block;
 
 public:
-    ExceptBlockNode(const std::string& id, AstNode* block)
-        : identifier(id), block(block) {
+    ExceptBlockNode(std::string id, AstNode* block)
+        : AstNode(NodeKind::ExceptBlock), identifier(std::move(id)), block(block) {
         this->name = "ExceptBlock";
         this->label = "Except Block";
     }
@@ -587,17 +651,8 @@ public:
         // of modification to an exception block, you could implement this method accordingly.
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << " : " << identifier << "\"]" << std::endl;
-        if (block) { // Check if block is not null
-            std::cout << "\t" << name << " -> " << block->name << ";" << std::endl;
-            block->print();
-        }
-    }
-
-    ~ExceptBlockNode() {
-        delete block;
-    }
+    const std::string& getIdentifier() const { return identifier; }
+    AstNode* getBlock() const { return block; }
 };
 
 class FinallyBlockNode : public AstNode {
@@ -605,7 +660,7 @@ private:
     AstNode* block;
 
 public:
-    FinallyBlockNode(AstNode* block) : block(block) {
+    FinallyBlockNode(AstNode* block) : AstNode(NodeKind::FinallyBlock), block(block) {
         this->name = "FinallyBlock";
         this->label = "Finally Block";
     }
@@ -617,17 +672,7 @@ public:
         // of modification to a finally block, you could implement this method accordingly.
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << " : " << name << "\"]" << std::endl;
-        if (block) { // Check if block is not null
-            std::cout << "\t" << name << " -> " << block->name << ";" << std::endl;
-            block->print();
-        }
-    }
-
-    ~FinallyBlockNode() {
-        delete block;
-    }
+    AstNode* getBlock() const { return block; }
 };
 
 
@@ -637,7 +682,7 @@ private:
     AstNode* namedExpression;
 
 public:
-    DecoratorsNode(AstNode* namedExpr) : namedExpression(namedExpr) {
+    DecoratorsNode(AstNode* namedExpr) : AstNode(NodeKind::Decorators), namedExpression(namedExpr) {
         this->name = "Decorators";
         this->label = "Decorators";
     }
@@ -647,24 +692,8 @@ public:
         decorators.push_back(node);
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << " : " << name << "\"]" << std::endl;
-        if (namedExpression) { // Check if namedExpression is not null
-            std::cout << "\t" << name << " -> " << namedExpression->name << ";" << std::endl;
-            namedExpression->print();
-        }
-        for (const auto& decorator : decorators) {
-            std::cout << "\t" << name << " -> " << decorator->name << ";" << std::endl;
-            decorator->print();
-        }
-    }
-
-    ~DecoratorsNode() {
-        delete namedExpression;
-        for (auto& decorator : decorators) {
-            delete decorator;
-        }
-    }
+    AstNode* getNamedExpression() const { return namedExpression; }
+    const std::vector<AstNode*>& getDecorators() const { return decorators; }
 };
 
 class ClassDefNode : public AstNode {
@@ -674,7 +703,7 @@ private:
 
 public:
     ClassDefNode(AstNode* decorators, AstNode* classDefRaw)
-        : decorators(decorators), classDefRaw(classDefRaw) {
+        : AstNode(NodeKind::ClassDef), decorators(decorators), classDefRaw(classDefRaw) {
         this->name = "ClassDef";
         this->label = "Class Definition";
     }
@@ -686,22 +715,8 @@ public:
         // of modification to a class definition, you could implement this method accordingly.
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << " : " << name << "\"]" << std::endl;
-        if (decorators) { // Check if decorators is not null
-            std::cout << "\t" << name << " -> " << decorators->name << ";" << std::endl;
-            decorators->print();
-        }
-        if (classDefRaw) { // Check if classDefRaw is not null
-            std::cout << "\t" << name << " -> " << classDefRaw->name << ";" << std::endl;
-            classDefRaw->print();
-        }
-    }
-
-    ~ClassDefNode() {
-        delete decorators;
-        delete classDefRaw;
-    }
+    AstNode* getDecorators() const { return decorators; }
+    AstNode* getClassDefRaw() const { return classDefRaw; }
 };
 
 class ClassDefRawNode : public AstNode {
@@ -710,8 +725,10 @@ private:
     AstNode* block;
 
 public:
-    ClassDefRawNode(const std::string& id, AstNode* block)
-        : identifier(id), block(block) {
+    NameBinding binding;
+
+    ClassDefRawNode(std::string id, AstNode* block)
+        : AstNode(NodeKind::ClassDefRaw), identifier(std::move(id)), block(block) {
         this->name = "ClassDefRaw";
         this->label = "Class Definition Raw";
     }
@@ -723,17 +740,8 @@ public:
         // of modification to a class definition, you could implement this method accordingly.
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << " : " << identifier << "\"]" << std::endl;
-        if (block) { // Check if block is not null
-            std::cout << "\t" << name << " -> " << block->name << ";" << std::endl;
-            block->print();
-        }
-    }
-
-    ~ClassDefRawNode() {
-        delete block;
-    }
+    const std::string& getIdentifier() const { return identifier; }
+    AstNode* getBlock() const { return block; }
 };
 
 class NamedExpressionNode : public AstNode {
@@ -741,7 +749,7 @@ private:
     AstNode* expression;
 
 public:
-    NamedExpressionNode(AstNode* expr) : expression(expr) {
+    NamedExpressionNode(AstNode* expr) : AstNode(NodeKind::NamedExpression), expression(expr) {
         this->name = "NamedExpression";
         this->label = "Named Expression";
     }
@@ -753,15 +761,7 @@ public:
         // of modification to a named expression, you could implement this method accordingly.
     }
 
-    void print() const override {
-        if (expression) { // Check if expression is not null
-            expression->print();
-        }
-    }
-
-    ~NamedExpressionNode() {
-        delete expression;
-    }
+    AstNode* getExpression() const { return expression; }
 };
 
 class WithStmtNode : public AstNode {
@@ -770,8 +770,8 @@ private:
     AstNode* block;
 
 public:
-    WithStmtNode(const std::vector<AstNode*>& items, AstNode* block)
-        : withItems(items), block(block) {
+    WithStmtNode(std::vector<AstNode*> items, AstNode* block)
+        : AstNode(NodeKind::With), withItems(std::move(items)), block(block) {
         this->name = "WithStmt";
         this->label = "With Statement";
     }
@@ -781,23 +781,8 @@ public:
         withItems.push_back(node);
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << " : " << name << "\"]" << std::endl;
-        for (const auto& item : withItems) {
-            std::cout << "\t" << name << " -> " << item->name << ";" << std::endl;
-            item->print();
-        }
-        if (block) { // Check if block is not null
-            block->print();
-        }
-    }
-
-    ~WithStmtNode() {
-        for (auto& item : withItems) {
-            delete item;
-        }
-        delete block;
-    }
+    const std::vector<AstNode*>& getWithItems() const { return withItems; }
+    AstNode* getBlock() const { return block; }
 };
 
 class WithItemsNode : public AstNode {
@@ -805,22 +790,14 @@ private:
     std::vector<AstNode*> withItemLists;
 
 public:
+    WithItemsNode() : AstNode(NodeKind::WithItems) {}
+
     // Override the add method to handle child nodes
     void add(AstNode* node) override {
         withItemLists.push_back(node);
     }
 
-    void print() const override {
-        for (const auto& itemList : withItemLists) {
-            itemList->print();
-        }
-    }
-
-    ~WithItemsNode() {
-        for (auto& itemList : withItemLists) {
-            delete itemList;
-        }
-    }
+    const std::vector<AstNode*>& getWithItemLists() const { return withItemLists; }
 };
 
 class WithItemList : public AstNode {
@@ -828,22 +805,14 @@ private:
     std::vector<AstNode*> withItems;
 
 public:
+    WithItemList() : AstNode(NodeKind::WithItemList) {}
+
     // Override the add method to handle child nodes
     void add(AstNode* node) override {
         withItems.push_back(node);
     }
 
-    void print() const override {
-        for (const auto& item : withItems) {
-            item->print();
-        }
-    }
-
-    ~WithItemList() {
-        for (auto& item : withItems) {
-            delete item;
-        }
-    }
+    const std::vector<AstNode*>& getWithItems() const { return withItems; }
 };
 
 class WithItem : public AstNode {
@@ -853,8 +822,8 @@ private:
     std::string identifier2;
 
 public:
-    WithItem(const std::string& id1, const std::string& str, const std::string& id2)
-        : identifier1(id1), stringLiteral(str), identifier2(id2) {
+    WithItem(std::string id1, std::string str, std::string id2)
+        : AstNode(NodeKind::WithItem), identifier1(std::move(id1)), stringLiteral(std::move(str)), identifier2(std::move(id2)) {
         this->name = "WithItem";
         this->label = "With Item";
     }
@@ -864,16 +833,9 @@ public:
         // No operation, as WithItem nodes do not have child nodes
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << " : " << identifier1;
-        if (!stringLiteral.empty()) {
-            std::cout << " = " << stringLiteral;
-        }
-        if (!identifier2.empty()) {
-            std::cout << " as " << identifier2;
-        }
-        std::cout << "\"]" << std::endl;
-    }
+    const std::string& getIdentifier1() const { return identifier1; }
+    const std::string& getStringLiteral() const { return stringLiteral; }
+    const std::string& getIdentifier2() const { return identifier2; }
 };
 
 class FunctionCallNode : public AstNode {
@@ -882,25 +844,21 @@ private:
     std::vector<AstNode*> arguments;
 
 public:
-    FunctionCallNode(const std::string& id) : identifier(id) {}
+    NameBinding binding;
+    int site = -1;      // dense call-site index from the scope pass, keys the inline cache
+
+    FunctionCallNode(std::string id) : AstNode(NodeKind::FunctionCall), identifier(std::move(id)) {
+        this->name = "FunctionCall";
+        this->label = "Function Call";
+    }
 
 
     void add(AstNode* arg) override {
         arguments.push_back(arg);
     }
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label <<" : "<<identifier<<"\"]" << std::endl;
-        for (const auto& arg : arguments) {
-            std::cout << "\t" << name << " -> " << arg->name << ";" << std::endl;
-            arg->print();
-        }
-    }
 
-    ~FunctionCallNode() {
-        for (const auto& arg : arguments) {
-            delete arg;
-        }
-    }
+    const std::string& getIdentifier() const { return identifier; }
+    const std::vector<AstNode*>& getArguments() const { return arguments; }
 };
 
 class ArgumentsNode : public AstNode {
@@ -908,21 +866,13 @@ private:
     std::vector<AstNode*> arguments;
 
 public:
+    ArgumentsNode() : AstNode(NodeKind::Arguments) {}
+
      void add(AstNode* arg) override {
         arguments.push_back(arg);
     }
 
-    void print() const override {
-        for (const auto& arg : arguments) {
-            arg->print();
-        }
-    }
-
-    ~ArgumentsNode() {
-        for (const auto& arg : arguments) {
-            delete arg;
-        }
-    }
+    const std::vector<AstNode*>& getArguments() const { return arguments; }
 };
 
 class ArgumentNode : public AstNode {
@@ -930,7 +880,7 @@ private:
     AstNode* primaryExpression;
 
 public:
-    ArgumentNode(AstNode* expr) : primaryExpression(expr) {}
+    ArgumentNode(AstNode* expr) : AstNode(NodeKind::Argument), primaryExpression(expr) {}
 
 
     
@@ -939,13 +889,8 @@ public:
         // However, if your language allows for some kind of modification to a primary expression,
         // you could implement this method accordingly.
     }
-    void print() const override {
-        primaryExpression->print();
-    }
 
-    ~ArgumentNode() {
-        delete primaryExpression;
-    }
+    AstNode* getExpression() const { return primaryExpression; }
 };
 
 
@@ -956,8 +901,8 @@ private:
     std::vector<std::string> globalParams;
 
 public:
-    GlobalStmtNode(const std::string& id, const std::vector<std::string>& params)
-        : identifier(id), globalParams(params) {
+    GlobalStmtNode(std::string id, std::vector<std::string> params)
+        : AstNode(NodeKind::Global), identifier(std::move(id)), globalParams(std::move(params)) {
         this->name = "GlobalStmt";
         this->label = "Global Statement";
     }
@@ -967,12 +912,8 @@ public:
         // No operation, as GlobalStmt nodes do not have child nodes
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << " : " << identifier << "\"]" << std::endl;
-        for (const auto& param : globalParams) {
-            std::cout << "\t" << identifier << " -> " << param << ";" << std::endl;
-        }
-    }
+    const std::string& getIdentifier() const { return identifier; }
+    const std::vector<std::string>& getParams() const { return globalParams; }
 };
 
 class NonlocalStmtNode : public AstNode {
@@ -981,8 +922,8 @@ private:
     std::vector<std::string> nonlocalParams;
 
 public:
-    NonlocalStmtNode(const std::string& id, const std::vector<std::string>& params)
-        : identifier(id), nonlocalParams(params) {
+    NonlocalStmtNode(std::string id, std::vector<std::string> params)
+        : AstNode(NodeKind::Nonlocal), identifier(std::move(id)), nonlocalParams(std::move(params)) {
         this->name = "NonlocalStmt";
         this->label = "Nonlocal Statement";
     }
@@ -992,11 +933,59 @@ public:
         // No operation, as NonlocalStmt nodes do not have child nodes
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << " : " << identifier << "\"]" << std::endl;
-        for (const auto& param : nonlocalParams) {
-            std::cout << "\t" << identifier << " -> " << param << ";" << std::endl;
+    const std::string& getIdentifier() const { return identifier; }
+    const std::vector<std::string>& getParams() const { return nonlocalParams; }
+};
+
+// `import a.b as c, d` or `from ..a.b import x as y, z` (`from m import *`
+// has the single name "*"). For a plain import, the names are the dotted
+// module names; for a from-import, the module is getModule() and getLevel()
+// counts its leading dots.
+class ImportStmtNode : public AstNode {
+public:
+    struct Name {
+        std::string name;
+        std::string alias;      // empty without `as`
+    };
+
+private:
+    std::string module;
+    int level = 0;
+    std::vector<Name> names;
+
+public:
+    ImportStmtNode() : AstNode(NodeKind::Import) {
+        this->name = "ImportStmt";
+        this->label = "Import Statement";
+    }
+
+    // ImportStmtNode does not have children, so the add method can be a no-op
+    void add(AstNode* node) override {
+        // No operation, as Import nodes do not have child nodes
+    }
+
+    void addName(std::string imported, std::string alias) {
+        names.push_back(Name{std::move(imported), std::move(alias)});
+    }
+
+    void setFrom(std::string fromModule, int dots) {
+        module = std::move(fromModule);
+        level = dots;
+        label = "From Import Statement";
+    }
+
+    bool isFrom() const { return level > 0 || !module.empty(); }
+    const std::string& getModule() const { return module; }
+    int getLevel() const { return level; }
+    const std::vector<Name>& getNames() const { return names; }
+
+    // The name the statement binds for one of its names: the alias, the
+    // imported name, or for `import a.b` the top-level package `a`
+    std::string boundName(const Name& n) const {
+        if (!n.alias.empty()) {
+            return n.alias;
         }
+        return isFrom() ? n.name : n.name.substr(0, n.name.find('.'));
     }
 };
 
@@ -1006,7 +995,7 @@ private:
     AstNode* yieldExpr;
 
 public:
-    YieldStmtNode(AstNode* expr) : yieldExpr(expr) {
+    YieldStmtNode(AstNode* expr) : AstNode(NodeKind::Yield), yieldExpr(expr) {
         this->name = "YieldStmt";
         this->label = "Yield Statement";
     }
@@ -1018,15 +1007,7 @@ public:
         // of modification to a yield statement, you could implement this method accordingly.
     }
 
-    void print() const override {
-        if (yieldExpr) { // Check if yieldExpr is not null
-            yieldExpr->print();
-        }
-    }
-
-    ~YieldStmtNode() {
-        delete yieldExpr;
-    }
+    AstNode* getExpression() const { return yieldExpr; }
 };
 
 class YieldExprNode : public AstNode {
@@ -1034,7 +1015,7 @@ private:
     AstNode* expression;
 
 public:
-    YieldExprNode(AstNode* expr) : expression(expr) {
+    YieldExprNode(AstNode* expr) : AstNode(NodeKind::YieldExpr), expression(expr) {
         this->name = "YieldExpr";
         this->label = "Yield Expression";
     }
@@ -1046,15 +1027,7 @@ public:
         // of modification to a yield expression, you could implement this method accordingly.
     }
 
-    void print() const override {
-        if (expression) { // Check if expression is not null
-            expression->print();
-        }
-    }
-
-    ~YieldExprNode() {
-        delete expression;
-    }
+    AstNode* getExpression() const { return expression; }
 };
 
 class IfStatementNode : public AstNode {
@@ -1065,7 +1038,7 @@ private:
 
 public:
     IfStatementNode(AstNode* header, AstNode* block, AstNode* elifElse)
-        : ifHeader(header), block(block), elifElse(elifElse) {
+        : AstNode(NodeKind::If), ifHeader(header), block(block), elifElse(elifElse) {
         this->name = "IfStatement";
         this->label = "If Statement";
     }
@@ -1077,23 +1050,9 @@ public:
         // of modification to an if statement, you could implement this method accordingly.
     }
 
-    void print() const override {
-        if (ifHeader) { // Check if ifHeader is not null
-            ifHeader->print();
-        }
-        if (block) { // Check if block is not null
-            block->print();
-        }
-        if (elifElse) { // Check if elifElse is not null
-            elifElse->print();
-        }
-    }
-
-    ~IfStatementNode() {
-        delete ifHeader;
-        delete block;
-        delete elifElse;
-    }
+    AstNode* getHeader() const { return ifHeader; }
+    AstNode* getBlock() const { return block; }
+    AstNode* getElifElse() const { return elifElse; }
 };
 
 class IfHeaderNode : public AstNode {
@@ -1101,7 +1060,7 @@ private:
     AstNode* namedExpression;
 
 public:
-    IfHeaderNode(AstNode* expr) : namedExpression(expr) {
+    IfHeaderNode(AstNode* expr) : AstNode(NodeKind::IfHeader), namedExpression(expr) {
         this->name = "IfHeader";
         this->label = "If Header";
     }
@@ -1113,15 +1072,7 @@ public:
         // of modification to an if header, you could implement this method accordingly.
     }
 
-    void print() const override {
-        if (namedExpression) { // Check if namedExpression is not null
-            namedExpression->print();
-        }
-    }
-
-    ~IfHeaderNode() {
-        delete namedExpression;
-    }
+    AstNode* getExpression() const { return namedExpression; }
 };
 
 class ElifElseNode : public AstNode {
@@ -1130,8 +1081,8 @@ private:
     AstNode* elseStmt;
 
 public:
-    ElifElseNode(const std::vector<AstNode*>& elifStmts, AstNode* elseStmt)
-        : elifStmts(elifStmts), elseStmt(elseStmt) {
+    ElifElseNode(std::vector<AstNode*> elifStmts, AstNode* elseStmt)
+        : AstNode(NodeKind::ElifElse), elifStmts(std::move(elifStmts)), elseStmt(elseStmt) {
         this->name = "ElifElse";
         this->label = "Elif/Else";
     }
@@ -1141,21 +1092,8 @@ public:
         elifStmts.push_back(node);
     }
 
-    void print() const override {
-        for (const auto& stmt : elifStmts) {
-            stmt->print();
-        }
-        if (elseStmt) { // Check if elseStmt is not null
-            elseStmt->print();
-        }
-    }
-
-    ~ElifElseNode() {
-        for (auto& stmt : elifStmts) {
-            delete stmt;
-        }
-        delete elseStmt;
-    }
+    const std::vector<AstNode*>& getElifStmts() const { return elifStmts; }
+    AstNode* getElseStmt() const { return elseStmt; }
 };
 
 class ElifStmtsNode : public AstNode {
@@ -1163,22 +1101,14 @@ private:
     std::vector<AstNode*> elifStmts;
 
 public:
+    ElifStmtsNode() : AstNode(NodeKind::ElifStmts) {}
+
     // Override the add method to handle child nodes
     void add(AstNode* node) override {
         elifStmts.push_back(node);
     }
 
-    void print() const override {
-        for (const auto& stmt : elifStmts) {
-            stmt->print();
-        }
-    }
-
-    ~ElifStmtsNode() {
-        for (auto& stmt : elifStmts) {
-            delete stmt;
-        }
-    }
+    const std::vector<AstNode*>& getElifStmts() const { return elifStmts; }
 };
 
 
@@ -1188,7 +1118,7 @@ private:
     AstNode* block;
 
 public:
-    ElifStmtNode(AstNode* header, AstNode* block) : elifHeader(header), block(block) {
+    ElifStmtNode(AstNode* header, AstNode* block) : AstNode(NodeKind::Elif), elifHeader(header), block(block) {
         this->name = "ElifStmt";
         this->label = "Elif Statement";
     }
@@ -1200,19 +1130,8 @@ public:
         // of modification to an elif statement, you could implement this method accordingly.
     }
 
-    void print() const override {
-        if (elifHeader) { // Check if elifHeader is not null
-            elifHeader->print();
-        }
-        if (block) { // Check if block is not null
-            block->print();
-        }
-    }
-
-    ~ElifStmtNode() {
-        delete elifHeader;
-        delete block;
-    }
+    AstNode* getHeader() const { return elifHeader; }
+    AstNode* getBlock() const { return block; }
 };
 
 class ElifHeaderNode : public AstNode {
@@ -1220,7 +1139,7 @@ private:
     AstNode* namedExpression;
 
 public:
-    ElifHeaderNode(AstNode* expr) : namedExpression(expr) {
+    ElifHeaderNode(AstNode* expr) : AstNode(NodeKind::ElifHeader), namedExpression(expr) {
         this->name = "ElifHeader";
         this->label = "Elif Header";
     }
@@ -1232,15 +1151,7 @@ public:
         // of modification to an elif header, you could implement this method accordingly.
     }
 
-    void print() const override {
-        if (namedExpression) { // Check if namedExpression is not null
-            namedExpression->print();
-        }
-    }
-
-    ~ElifHeaderNode() {
-        delete namedExpression;
-    }
+    AstNode* getExpression() const { return namedExpression; }
 };
 
 class ElseStmtNode : public AstNode {
@@ -1248,7 +1159,7 @@ private:
     AstNode* block;
 
 public:
-    ElseStmtNode(AstNode* blk) : block(blk) {
+    ElseStmtNode(AstNode* blk) : AstNode(NodeKind::Else), block(blk) {
         this->name = "ElseStmt";
         this->label = "Else Statement";
     }
@@ -1260,15 +1171,7 @@ public:
         // of modification to an else statement, you could implement this method accordingly.
     }
 
-    void print() const override {
-        if (block) { // Check if block is not null
-            block->print();
-        }
-    }
-
-    ~ElseStmtNode() {
-        delete block;
-    }
+    AstNode* getBlock() const { return block; }
 };
 
 class MatchStmtNode : public AstNode {
@@ -1277,7 +1180,7 @@ private:
     AstNode* matchCases;
 
 public:
-    MatchStmtNode(AstNode* expr, AstNode* cases) : expression(expr), matchCases(cases) {
+    MatchStmtNode(AstNode* expr, AstNode* cases) : AstNode(NodeKind::Match), expression(expr), matchCases(cases) {
         this->name = "MatchStmt";
         this->label = "Match Statement";
     }
@@ -1289,19 +1192,8 @@ public:
         // of modification to a match statement, you could implement this method accordingly.
     }
 
-    void print() const override {
-        if (expression) { // Check if expression is not null
-            expression->print();
-        }
-        if (matchCases) { // Check if matchCases is not null
-            matchCases->print();
-        }
-    }
-
-    ~MatchStmtNode() {
-        delete expression;
-        delete matchCases;
-    }
+    AstNode* getExpression() const { return expression; }
+    AstNode* getMatchCases() const { return matchCases; }
 };
 
 class MatchCasesNode : public AstNode {
@@ -1309,22 +1201,14 @@ private:
     std::vector<AstNode*> matchCases;
 
 public:
+    MatchCasesNode() : AstNode(NodeKind::MatchCases) {}
+
     // Override the add method to handle child nodes
     void add(AstNode* node) override {
         matchCases.push_back(node);
     }
 
-    void print() const override {
-        for (const auto& matchCase : matchCases) {
-            matchCase->print();
-        }
-    }
-
-    ~MatchCasesNode() {
-        for (auto& matchCase : matchCases) {
-            delete matchCase;
-        }
-    }
+    const std::vector<AstNode*>& getMatchCases() const { return matchCases; }
 };
 
 class MatchCaseNode : public AstNode {
@@ -1333,7 +1217,7 @@ private:
     AstNode* simpleStmt;
 
 public:
-    MatchCaseNode(AstNode* patternList, AstNode* simpleStmt) : patternList(patternList), simpleStmt(simpleStmt) {
+    MatchCaseNode(AstNode* patternList, AstNode* simpleStmt) : AstNode(NodeKind::MatchCase), patternList(patternList), simpleStmt(simpleStmt) {
         this->name = "MatchCase";
         this->label = "Match Case";
     }
@@ -1345,19 +1229,8 @@ public:
         // of modification to a match case, you could implement this method accordingly.
     }
 
-    void print() const override {
-        if (patternList) { // Check if patternList is not null
-            patternList->print();
-        }
-        if (simpleStmt) { // Check if simpleStmt is not null
-            simpleStmt->print();
-        }
-    }
-
-    ~MatchCaseNode() {
-        delete patternList;
-        delete simpleStmt;
-    }
+    AstNode* getPatternList() const { return patternList; }
+    AstNode* getSimpleStmt() const { return simpleStmt; }
 };
 
 class PatternListNode : public AstNode {
@@ -1365,22 +1238,14 @@ private:
     std::vector<AstNode*> patterns;
 
 public:
+    PatternListNode() : AstNode(NodeKind::PatternList) {}
+
     // Override the add method to handle child nodes
     void add(AstNode* node) override {
         patterns.push_back(node);
     }
 
-    void print() const override {
-        for (const auto& pattern : patterns) {
-            pattern->print();
-        }
-    }
-
-    ~PatternListNode() {
-        for (auto& pattern : patterns) {
-            delete pattern;
-        }
-    }
+    const std::vector<AstNode*>& getPatterns() const { return patterns; }
 };
 
 class PatternNode : public AstNode {
@@ -1388,7 +1253,7 @@ private:
     AstNode* expression;  // Or other specific pattern nodes
 
 public:
-    PatternNode(AstNode* expr) : expression(expr) {
+    PatternNode(AstNode* expr) : AstNode(NodeKind::Pattern), expression(expr) {
         this->name = "Pattern";
         this->label = "Pattern";
     }
@@ -1400,15 +1265,7 @@ public:
         // of modification to a pattern, you could implement this method accordingly.
     }
 
-    void print() const override {
-        if (expression) { // Check if expression is not null
-            expression->print();
-        }
-    }
-
-    ~PatternNode() {
-        delete expression;
-    }
+    AstNode* getExpression() const { return expression; }
 };
 
 class ListPatternNode : public AstNode {
@@ -1416,7 +1273,7 @@ private:
     AstNode* patternList;
 
 public:
-    ListPatternNode(AstNode* list) : patternList(list) {
+    ListPatternNode(AstNode* list) : AstNode(NodeKind::ListPattern), patternList(list) {
         this->name = "ListPattern";
         this->label = "List Pattern";
     }
@@ -1428,15 +1285,7 @@ public:
         // of modification to a list pattern, you could implement this method accordingly.
     }
 
-    void print() const override {
-        if (patternList) { // Check if patternList is not null
-            patternList->print();
-        }
-    }
-
-    ~ListPatternNode() {
-        delete patternList;
-    }
+    AstNode* getPatternList() const { return patternList; }
 };
 
 class DictPatternNode : public AstNode {
@@ -1444,7 +1293,7 @@ private:
     AstNode* dictPatternEntries;
 
 public:
-    DictPatternNode(AstNode* entries) : dictPatternEntries(entries) {
+    DictPatternNode(AstNode* entries) : AstNode(NodeKind::DictPattern), dictPatternEntries(entries) {
         this->name = "DictPattern";
         this->label = "Dictionary Pattern";
     }
@@ -1456,15 +1305,7 @@ public:
         // of modification to a dictionary pattern, you could implement this method accordingly.
     }
 
-    void print() const override {
-        if (dictPatternEntries) { // Check if dictPatternEntries is not null
-            dictPatternEntries->print();
-        }
-    }
-
-    ~DictPatternNode() {
-        delete dictPatternEntries;
-    }
+    AstNode* getEntries() const { return dictPatternEntries; }
 };
 
 class DictPatternEntriesNode : public AstNode {
@@ -1472,22 +1313,14 @@ private:
     std::vector<AstNode*> dictPatternEntries;
 
 public:
+    DictPatternEntriesNode() : AstNode(NodeKind::DictPatternEntries) {}
+
     // Override the add method to handle child nodes
     void add(AstNode* node) override {
         dictPatternEntries.push_back(node);
     }
 
-    void print() const override {
-        for (const auto& entry : dictPatternEntries) {
-            entry->print();
-        }
-    }
-
-    ~DictPatternEntriesNode() {
-        for (auto& entry : dictPatternEntries) {
-            delete entry;
-        }
-    }
+    const std::vector<AstNode*>& getEntries() const { return dictPatternEntries; }
 };
 
 class DictPatternEntryNode : public AstNode {
@@ -1496,7 +1329,7 @@ private:
     AstNode* value;
 
 public:
-    DictPatternEntryNode(AstNode* key, AstNode* value) : key(key), value(value) {
+    DictPatternEntryNode(AstNode* key, AstNode* value) : AstNode(NodeKind::DictPatternEntry), key(key), value(value) {
         this->name = "DictPatternEntry";
         this->label = "Dictionary Pattern Entry";
     }
@@ -1508,49 +1341,22 @@ public:
         // of modification to a dictionary pattern entry, you could implement this method accordingly.
     }
 
-    void print() const override {
-        if (key) { // Check if key is not null
-            key->print();
-        }
-        if (value) { // Check if value is not null
-            value->print();
-        }
-    }
-
-    ~DictPatternEntryNode() {
-        delete key;
-        delete value;
-    }
+    AstNode* getKey() const { return key; }
+    AstNode* getValue() const { return value; }
 };
 
 class BlockNode : public AstNode {
 private:
     std::vector<AstNode*> next;
 public:
-    BlockNode(const std::string& name) {
+    BlockNode(const std::string& name) : AstNode(NodeKind::Block) {
         this->name = name;
         this->label = "Block";
     }
     void add(AstNode* node) override {
         next.push_back(node);
     }
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << "\"]" << std::endl;
-        // std::vector<AstNode*>::iterator it;
-        // for (it = next.begin(); it != next.end(); ++it) {
-        //     std::cout << "\t" << name << " -> " << (*it)->name << ";" << std::endl;
-        //     (*it)->print();
-        // }
-        for (const auto& stmt : next) {
-            std::cout << "\t" << name << " -> " << stmt->name << ";" << std::endl;
-            stmt->print();
-        }
-    }
-    ~BlockNode() {
-        for (const auto& stmt : next) {
-            delete stmt;
-        }
-    }
+    const std::vector<AstNode*>& getStatements() const { return next; }
 };
 
 
@@ -1561,7 +1367,7 @@ private:
     std::vector<AstNode*> next;
 
 public:
-    StatementsNode(const std::string& name) {
+    StatementsNode(const std::string& name) : AstNode(NodeKind::Statements) {
         this->name = name;
         this->label = "Block Statements";
     }
@@ -1570,19 +1376,7 @@ public:
         next.push_back(node);
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << "\"]" << std::endl;
-        for (const auto& stmt : next) {
-            std::cout << "\t" << name << " -> " << stmt->name << ";" << std::endl;
-            stmt->print();
-        }
-    }
-
-    ~StatementsNode() {
-        for (const auto& stmt : next) {
-            delete stmt;
-        }
-    }
+    const std::vector<AstNode*>& getStatements() const { return next; }
 };
 
 
@@ -1591,7 +1385,7 @@ private:
     std::vector<AstNode*> next;
 
 public:
-    assignmentStatement(const std::string& name) {
+    assignmentStatement(const std::string& name) : AstNode(NodeKind::Assignment) {
         this->name = name;
         this->label = "assignment";
     }
@@ -1600,22 +1394,8 @@ public:
         next.push_back(node);
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << label << "\"]" << std::endl;
-        for (const auto& stmt : next) {
-            std::cout << "\t" << name << " -> " << stmt->name << ";" << std::endl;
-            stmt->print();
-        }
-        // for (const auto& stmt : next) {
-        //     stmt->print();
-        // }
-    }
-
-    ~assignmentStatement() {
-        for (const auto& stmt : next) {
-            delete stmt;
-        }
-    }
+    AstNode* getTarget() const { return next.size() > 0 ? next[0] : nullptr; }
+    AstNode* getValue() const { return next.size() > 1 ? next[1] : nullptr; }
 };
 
 // Leaf node for representing numeric literals
@@ -1623,7 +1403,7 @@ class NumberNode : public AstNode {
 private:
     int value;
 public:
-    NumberNode(std::string name, std::string label, int value) {
+    NumberNode(std::string name, std::string label, int value) : AstNode(NodeKind::Number) {
         this->name = name;
         this->label = label;
         this->value = value; 
@@ -1633,17 +1413,14 @@ public:
         std::cerr << "Cannot add a child to a leaf node." << std::endl;
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [shape=box,label=\"" << label << ": " << value << "\"]" << std::endl;
-
-    }
+    int getValue() const { return value; }
 };
 
 class LiteralNode : public AstNode {
 private:
     int value;
 public:
-    LiteralNode(std::string name, std::string label, int value) {
+    LiteralNode(std::string name, std::string label, int value) : AstNode(NodeKind::Literal) {
         this->name = name;
         this->label = label;
         this->value = value; 
@@ -1653,10 +1430,7 @@ public:
         std::cerr << "Cannot add a child to a leaf node." << std::endl;
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [shape=box,label=\"" << label << ": " << value << "\"]" << std::endl;
-
-    }
+    int getValue() const { return value; }
 };
 
 
@@ -1671,7 +1445,7 @@ private:
 
 public:
     BinaryExpressionNode(char op, AstNode* l, AstNode* r)
-        : operation(op), left(l), right(r) {}
+        : AstNode(NodeKind::BinaryExpression), operation(op), left(l), right(r) {}
 
     void add(AstNode* node) override {
         if (!left)
@@ -1682,16 +1456,48 @@ public:
             std::cerr << "Binary expression already has two children." << std::endl;
     }
 
-    void print() const override {
-        std::cout << "\t" << "BinaryExpressionNode" << " [label=\"" << operation << "\"]" << std::endl;
-        left->print();
-        std::cout << "\t" << "BinaryExpressionNode" << " [label=\"" << operation << "\"]" << std::endl;
-        right->print();
+    char getOp() const { return operation; }
+    AstNode* getLeft() const { return left; }
+    AstNode* getRight() const { return right; }
+};
+
+
+class BreakStmtNode : public AstNode {
+public:
+    BreakStmtNode() : AstNode(NodeKind::Break) {
+        this->name = "BreakStmt";
+        this->label = "Break Statement";
     }
 
-    ~BinaryExpressionNode() {
-        delete left;
-        delete right;
+    // BreakStmtNode does not have children, so the add method can be a no-op
+    void add(AstNode* node) override {
+        // No operation, as break statements do not have child nodes
+    }
+};
+
+class ContinueStmtNode : public AstNode {
+public:
+    ContinueStmtNode() : AstNode(NodeKind::Continue) {
+        this->name = "ContinueStmt";
+        this->label = "Continue Statement";
+    }
+
+    // ContinueStmtNode does not have children, so the add method can be a no-op
+    void add(AstNode* node) override {
+        // No operation, as continue statements do not have child nodes
+    }
+};
+
+class PassStmtNode : public AstNode {
+public:
+    PassStmtNode() : AstNode(NodeKind::Pass) {
+        this->name = "PassStmt";
+        this->label = "Pass Statement";
+    }
+
+    // PassStmtNode does not have children, so the add method can be a no-op
+    void add(AstNode* node) override {
+        // No operation, as pass statements do not have child nodes
     }
 };
 
@@ -1702,7 +1508,7 @@ private:
 
 public:
     ReturnStatementNode(AstNode* value)
-        : returnValue(value) {
+        : AstNode(NodeKind::Return), returnValue(value) {
         this->name = "ReturnStatement";
     }
 
@@ -1710,32 +1516,17 @@ public:
         std::cerr << "Cannot add a child to a leaf node." << std::endl;
     }
 
-    void print() const override {
-        std::cout << "\t" << name << " [label=\"" << "ReturnStatement" << "\"]" << std::endl;
-        returnValue->print();
-    }
-
-    ~ReturnStatementNode() {
-        delete returnValue;
-    }
+    AstNode* getReturnValue() const { return returnValue; }
 };
 
-class AST {
-private:
-    AstNode* root = nullptr;
-public:
-    AST(AstNode* r) : root(r) {}
-
-    ~AST() {
-        if (root != nullptr) {
-            delete root;
-            root = nullptr;
-        }
+// Size of a node of `kind`, its strings' buffers aside
+inline size_t nodeSize(NodeKind kind) {
+    switch (kind) {
+#define X(kind, type) case NodeKind::kind: return sizeof(type);
+        PYTHON_AST_NODES(X)
+#undef X
     }
-    void Print() {
-        std::cout << "digraph G {" << std::endl;
-        root->print();
-        std::cout << "}" << std::endl;
-    }
-};
+    return 0;
+}
+
 #endif 
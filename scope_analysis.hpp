@@ -0,0 +1,602 @@
+#ifndef SCOPE_ANALYSIS_H
+#define SCOPE_ANALYSIS_H
+
+#include "python_ast_node.hpp"
+#include <cctype>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Names visible without a binding anywhere in the module. The index of a name
+// in this table is the slot stored in a Builtin NameBinding.
+static const char* const kBuiltinNames[] = {
+    "print", "range", "len", "int", "float", "str", "bool", "abs", "min", "max",
+    "sum", "list", "dict", "set", "tuple", "type", "isinstance", "iter", "next",
+    "enumerate", "zip", "map", "filter", "sorted", "reversed", "any", "all",
+    "round", "pow", "divmod", "chr", "ord", "repr", "hash", "id", "input",
+    "open", "object", "super", "Exception", "ValueError", "TypeError",
+    "KeyError", "IndexError", "StopIteration", "ZeroDivisionError",
+    "RuntimeError", "NameError", "AttributeError",
+};
+
+inline int builtinSlot(const std::string& name) {
+    const int count = sizeof(kBuiltinNames) / sizeof(kBuiltinNames[0]);
+    for (int i = 0; i < count; ++i) {
+        if (name == kBuiltinNames[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+inline const char* nameKindToString(NameKind kind) {
+    switch (kind) {
+        case NameKind::Local:    return "local";
+        case NameKind::Global:   return "global";
+        case NameKind::Nonlocal: return "nonlocal";
+        case NameKind::Free:     return "free";
+        case NameKind::Builtin:  return "builtin";
+        default:                 return "unresolved";
+    }
+}
+
+enum class ScopeKind { Module, Function, Class };
+
+struct Symbol {
+    std::string name;
+    NameKind kind = NameKind::Unresolved;
+    int slot = -1;          // frame slot (Local), module slot (Global), builtin index (Builtin)
+    int depth = 0;          // enclosing function scopes to walk for Nonlocal/Free
+    bool isParam = false;
+    bool captured = false;  // read or written by an inner function, needs a cell
+};
+
+class Scope {
+public:
+    ScopeKind kind;
+    std::string name;
+    Scope* parent;
+    const AstNode* node;             // FunctionNode, ClassDefRawNode or the module root
+    std::vector<Symbol> symbols;     // in order of first appearance
+    std::vector<Scope*> children;
+    int numSlots = 0;                // locals of a function/class, globals of the module
+
+    Scope(ScopeKind kind, const std::string& name, Scope* parent, const AstNode* node)
+        : kind(kind), name(name), parent(parent), node(node) {}
+
+    Symbol* lookup(const std::string& id) {
+        auto it = index.find(id);
+        return it == index.end() ? nullptr : &symbols[it->second];
+    }
+
+    const Symbol* lookup(const std::string& id) const {
+        auto it = index.find(id);
+        return it == index.end() ? nullptr : &symbols[it->second];
+    }
+
+    Symbol& insert(const std::string& id) {
+        auto it = index.find(id);
+        if (it != index.end()) {
+            return symbols[it->second];
+        }
+        index[id] = symbols.size();
+        symbols.push_back(Symbol());
+        symbols.back().name = id;
+        return symbols.back();
+    }
+
+    // Give the name a fresh dense slot in this scope
+    Symbol& bindSlot(const std::string& id, NameKind kind) {
+        Symbol& sym = insert(id);
+        if (sym.slot < 0) {
+            sym.kind = kind;
+            sym.slot = numSlots++;
+        }
+        return sym;
+    }
+
+    const char* kindName() const {
+        switch (kind) {
+            case ScopeKind::Module:   return "module";
+            case ScopeKind::Function: return "function";
+            default:                  return "class";
+        }
+    }
+
+private:
+    std::unordered_map<std::string, size_t> index;
+};
+
+class SymbolTable {
+public:
+    std::vector<std::unique_ptr<Scope>> scopes;     // scopes[0] is the module
+    std::unordered_map<const AstNode*, Scope*> byNode;
+    std::vector<std::string> diagnostics;
+    int numCallSites = 0;                           // FunctionCallNode::site is below this
+    std::vector<std::string> constants;             // literal spellings, PrimaryExpressionNode::constant
+    std::unordered_map<std::string, int> constantIndex;
+
+    int internConstant(const std::string& literal) {
+        auto it = constantIndex.find(literal);
+        if (it != constantIndex.end()) {
+            return it->second;
+        }
+        constants.push_back(literal);
+        return constantIndex[literal] = constants.size() - 1;
+    }
+
+    Scope* module() const { return scopes.empty() ? nullptr : scopes[0].get(); }
+
+    Scope* scopeOf(const AstNode* node) const {
+        auto it = byNode.find(node);
+        return it == byNode.end() ? nullptr : it->second;
+    }
+
+    Scope* newScope(ScopeKind kind, const std::string& name, Scope* parent, const AstNode* node) {
+        scopes.push_back(std::unique_ptr<Scope>(new Scope(kind, name, parent, node)));
+        Scope* scope = scopes.back().get();
+        byNode[node] = scope;
+        if (parent) {
+            parent->children.push_back(scope);
+        }
+        return scope;
+    }
+
+    void dump(std::ostream& out) const {
+        for (const auto& scope : scopes) {
+            out << "scope " << scope->kindName() << " " << scope->name
+                << " (" << scope->numSlots << " slots)" << std::endl;
+            for (const auto& sym : scope->symbols) {
+                out << "    " << sym.name << " " << nameKindToString(sym.kind);
+                if (sym.slot >= 0) {
+                    out << " slot " << sym.slot;
+                }
+                if (sym.kind == NameKind::Nonlocal || sym.kind == NameKind::Free) {
+                    out << " depth " << sym.depth;
+                }
+                if (sym.isParam) {
+                    out << " param";
+                }
+                if (sym.captured) {
+                    out << " captured";
+                }
+                out << std::endl;
+            }
+        }
+    }
+
+    // The names `from <this module> import *` binds: the module's globals,
+    // less those starting with an underscore
+    std::vector<std::string> exports() const {
+        std::vector<std::string> names;
+        for (const auto& sym : module()->symbols) {
+            if (sym.kind == NameKind::Global && !sym.name.empty() && sym.name[0] != '_') {
+                names.push_back(sym.name);
+            }
+        }
+        return names;
+    }
+
+    void reportDiagnostics(std::ostream& out) const {
+        for (const auto& msg : diagnostics) {
+            out << "warning: " << msg << std::endl;
+        }
+    }
+};
+
+// Resolves every name in the tree to a NameBinding. Each scope is processed in
+// two walks: the declare walk collects the names bound in the scope (assignments,
+// parameters, def/class names, loop targets, global/nonlocal declarations) and
+// hands out slots, then the resolve walk classifies every use and stamps the
+// binding on the node. Nested scopes are analyzed from the resolve walk, so the
+// bindings of every enclosing scope are complete by the time they are searched.
+class ScopeAnalyzer {
+public:
+    SymbolTable analyze(AstNode* root) {
+        Scope* module = table.newScope(ScopeKind::Module, "<module>", nullptr, root);
+        walk(root, module, Phase::Declare);
+        walk(root, module, Phase::Resolve);
+        return std::move(table);
+    }
+
+    // The names each `from m import *` binds, looked up by statement; the
+    // project build fills it from m's exports() (project_builder.hpp).
+    // Without an entry, a star import binds nothing.
+    void setStarImports(const std::unordered_map<const AstNode*, std::vector<std::string>>* names) {
+        starImports = names;
+    }
+
+private:
+    enum class Phase { Declare, Resolve };
+
+    SymbolTable table;
+    const std::unordered_map<const AstNode*, std::vector<std::string>>* starImports = nullptr;
+
+    static bool isName(const std::string& value) {
+        if (value.empty() || !(std::isalpha((unsigned char)value[0]) || value[0] == '_')) {
+            return false;
+        }
+        return value != "true" && value != "false" && value != "True"
+            && value != "False" && value != "None";
+    }
+
+    static std::string describe(const Scope* scope) {
+        if (scope->kind == ScopeKind::Module) {
+            return "module scope";
+        }
+        return std::string(scope->kindName()) + " '" + scope->name + "'";
+    }
+
+    // Record a binding of `id` in `scope` during the declare walk
+    void bind(Scope* scope, const std::string& id) {
+        if (id.empty()) {
+            return;
+        }
+        Symbol* sym = scope->lookup(id);
+        if (sym && (sym->kind == NameKind::Global || sym->kind == NameKind::Nonlocal)
+            && scope->kind != ScopeKind::Module) {
+            return;     // assignment goes through the declaration
+        }
+        scope->bindSlot(id, scope->kind == ScopeKind::Module ? NameKind::Global : NameKind::Local);
+    }
+
+    void declareGlobal(Scope* scope, const std::string& id) {
+        if (id.empty() || scope->kind == ScopeKind::Module) {
+            return;
+        }
+        Symbol* sym = scope->lookup(id);
+        if (sym && sym->kind == NameKind::Local) {
+            table.diagnostics.push_back("name '" + id + "' is assigned to before global declaration in " + describe(scope));
+            return;
+        }
+        Symbol& global = table.module()->bindSlot(id, NameKind::Global);
+        Symbol& local = scope->insert(id);
+        local.kind = NameKind::Global;
+        local.slot = global.slot;
+    }
+
+    void declareNonlocal(Scope* scope, const std::string& id) {
+        if (id.empty()) {
+            return;
+        }
+        if (scope->kind != ScopeKind::Function) {
+            table.diagnostics.push_back("nonlocal declaration of '" + id + "' not allowed in " + describe(scope));
+            return;
+        }
+        Symbol* sym = scope->lookup(id);
+        if (sym && sym->kind == NameKind::Local) {
+            table.diagnostics.push_back("name '" + id + "' is assigned to before nonlocal declaration in " + describe(scope));
+            return;
+        }
+        NameBinding outer = findEnclosing(scope, id);
+        if (outer.kind != NameKind::Free) {
+            table.diagnostics.push_back("no binding for nonlocal '" + id + "' found in " + describe(scope));
+            return;
+        }
+        Symbol& local = scope->insert(id);
+        local.kind = NameKind::Nonlocal;
+        local.slot = outer.slot;
+        local.depth = outer.depth;
+    }
+
+    // Search the enclosing function scopes for a local binding of `id`. Class
+    // bodies are skipped, as their names are not visible to nested functions.
+    NameBinding findEnclosing(Scope* scope, const std::string& id) {
+        NameBinding binding;
+        int depth = 0;
+        for (Scope* s = scope->parent; s && s->kind != ScopeKind::Module; s = s->parent) {
+            if (s->kind != ScopeKind::Function) {
+                continue;
+            }
+            ++depth;
+            Symbol* sym = s->lookup(id);
+            if (!sym || sym->kind == NameKind::Builtin || sym->kind == NameKind::Unresolved) {
+                continue;
+            }
+            if (sym->kind == NameKind::Global) {
+                break;
+            }
+            if (sym->kind == NameKind::Local) {
+                sym->captured = true;
+                binding.kind = NameKind::Free;
+                binding.slot = sym->slot;
+                binding.depth = depth;
+            } else {
+                // the enclosing scope itself reaches further out
+                binding.kind = NameKind::Free;
+                binding.slot = sym->slot;
+                binding.depth = depth + sym->depth;
+            }
+            return binding;
+        }
+        return binding;
+    }
+
+    // Classify a use (or store) of `id` made from `scope`
+    NameBinding resolve(Scope* scope, const std::string& id) {
+        NameBinding binding;
+        Symbol* sym = scope->lookup(id);
+        if (sym && sym->kind != NameKind::Unresolved) {
+            binding.kind = sym->kind;
+            binding.slot = sym->slot;
+            binding.depth = sym->depth;
+            return binding;
+        }
+
+        if (scope->kind != ScopeKind::Module) {
+            binding = findEnclosing(scope, id);
+            if (binding.kind == NameKind::Free) {
+                Symbol& free = scope->insert(id);
+                free.kind = NameKind::Free;
+                free.slot = binding.slot;
+                free.depth = binding.depth;
+                return binding;
+            }
+            Symbol* global = table.module()->lookup(id);
+            if (global) {
+                binding.kind = NameKind::Global;
+                binding.slot = global->slot;
+                Symbol& local = scope->insert(id);
+                local.kind = NameKind::Global;
+                local.slot = global->slot;
+                return binding;
+            }
+        }
+
+        int builtin = builtinSlot(id);
+        if (builtin >= 0) {
+            binding.kind = NameKind::Builtin;
+            binding.slot = builtin;
+            Symbol& local = scope->insert(id);
+            local.kind = NameKind::Builtin;
+            local.slot = builtin;
+            return binding;
+        }
+
+        if (!sym) {
+            scope->insert(id);
+            table.diagnostics.push_back("undefined name '" + id + "' in " + describe(scope));
+        }
+        return binding;
+    }
+
+    void analyzeFunction(FunctionNode* function, Scope* parent) {
+        Scope* scope = table.newScope(ScopeKind::Function, function->name, parent, function);
+        if (Args* args = dynamic_cast<Args*>(function->getArgs())) {
+            for (const auto& arg : args->getArgs()) {
+                if (IdentifierNode* param = dynamic_cast<IdentifierNode*>(arg)) {
+                    Symbol& sym = scope->bindSlot(param->value, NameKind::Local);
+                    sym.isParam = true;
+                }
+            }
+        }
+        walk(function->getBody(), scope, Phase::Declare);
+        if (Args* args = dynamic_cast<Args*>(function->getArgs())) {
+            for (const auto& arg : args->getArgs()) {
+                if (IdentifierNode* param = dynamic_cast<IdentifierNode*>(arg)) {
+                    param->binding = resolve(scope, param->value);
+                }
+            }
+        }
+        walk(function->getBody(), scope, Phase::Resolve);
+    }
+
+    void analyzeClass(ClassDefRawNode* classDef, Scope* parent) {
+        Scope* scope = table.newScope(ScopeKind::Class, classDef->getIdentifier(), parent, classDef);
+        walk(classDef->getBlock(), scope, Phase::Declare);
+        walk(classDef->getBlock(), scope, Phase::Resolve);
+    }
+
+    void walkAll(const std::vector<AstNode*>& nodes, Scope* scope, Phase phase) {
+        for (const auto& node : nodes) {
+            walk(node, scope, phase);
+        }
+    }
+
+    void walk(AstNode* node, Scope* scope, Phase phase) {
+        if (!node) {
+            return;
+        }
+        if (StatementsNode* n = dynamic_cast<StatementsNode*>(node)) {
+            walkAll(n->getStatements(), scope, phase);
+        } else if (BlockNode* n = dynamic_cast<BlockNode*>(node)) {
+            walkAll(n->getStatements(), scope, phase);
+        } else if (FunctionNode* n = dynamic_cast<FunctionNode*>(node)) {
+            if (phase == Phase::Declare) {
+                bind(scope, n->name);
+            } else {
+                n->binding = resolve(scope, n->name);
+                analyzeFunction(n, scope);
+            }
+        } else if (ClassDefNode* n = dynamic_cast<ClassDefNode*>(node)) {
+            walk(n->getDecorators(), scope, phase);
+            walk(n->getClassDefRaw(), scope, phase);
+        } else if (ClassDefRawNode* n = dynamic_cast<ClassDefRawNode*>(node)) {
+            if (phase == Phase::Declare) {
+                bind(scope, n->getIdentifier());
+            } else {
+                n->binding = resolve(scope, n->getIdentifier());
+                analyzeClass(n, scope);
+            }
+        } else if (GlobalStmtNode* n = dynamic_cast<GlobalStmtNode*>(node)) {
+            if (phase == Phase::Declare) {
+                declareGlobal(scope, n->getIdentifier());
+                for (const auto& id : n->getParams()) {
+                    declareGlobal(scope, id);
+                }
+            }
+        } else if (NonlocalStmtNode* n = dynamic_cast<NonlocalStmtNode*>(node)) {
+            if (phase == Phase::Declare) {
+                declareNonlocal(scope, n->getIdentifier());
+                for (const auto& id : n->getParams()) {
+                    declareNonlocal(scope, id);
+                }
+            }
+        } else if (ImportStmtNode* n = dynamic_cast<ImportStmtNode*>(node)) {
+            if (phase == Phase::Declare) {
+                for (const auto& imported : n->getNames()) {
+                    if (imported.name != "*") {
+                        bind(scope, n->boundName(imported));
+                    } else if (starImports && starImports->count(n)) {
+                        for (const auto& id : starImports->at(n)) {
+                            bind(scope, id);
+                        }
+                    }
+                }
+            }
+        } else if (assignmentStatement* n = dynamic_cast<assignmentStatement*>(node)) {
+            IdentifierNode* target = dynamic_cast<IdentifierNode*>(n->getTarget());
+            if (phase == Phase::Declare) {
+                if (target) {
+                    bind(scope, target->value);
+                }
+            } else {
+                walk(n->getValue(), scope, phase);
+                if (target) {
+                    target->binding = resolve(scope, target->value);
+                }
+            }
+        } else if (IdentifierNode* n = dynamic_cast<IdentifierNode*>(node)) {
+            if (phase == Phase::Resolve) {
+                n->binding = resolve(scope, n->value);
+            }
+        } else if (PrimaryExpressionNode* n = dynamic_cast<PrimaryExpressionNode*>(node)) {
+            if (phase == Phase::Resolve && isName(n->getValue())) {
+                n->binding = resolve(scope, n->getValue());
+            } else if (phase == Phase::Resolve) {
+                n->constant = table.internConstant(n->getValue());
+            }
+        } else if (NegatedExpressionNode* n = dynamic_cast<NegatedExpressionNode*>(node)) {
+            walk(n->getOperand(), scope, phase);
+        } else if (ExpressionNode* n = dynamic_cast<ExpressionNode*>(node)) {
+            walk(n->getLeft(), scope, phase);
+            walk(n->getRight(), scope, phase);
+        } else if (ComparisonNode* n = dynamic_cast<ComparisonNode*>(node)) {
+            walk(n->getLeft(), scope, phase);
+            walk(n->getRight(), scope, phase);
+        } else if (NamedExpressionNode* n = dynamic_cast<NamedExpressionNode*>(node)) {
+            walk(n->getExpression(), scope, phase);
+        } else if (FunctionCallNode* n = dynamic_cast<FunctionCallNode*>(node)) {
+            if (phase == Phase::Resolve) {
+                n->binding = resolve(scope, n->getIdentifier());
+                if (n->site < 0) {
+                    n->site = table.numCallSites++;
+                }
+            }
+            walkAll(n->getArguments(), scope, phase);
+        } else if (ArgumentsNode* n = dynamic_cast<ArgumentsNode*>(node)) {
+            walkAll(n->getArguments(), scope, phase);
+        } else if (ArgumentNode* n = dynamic_cast<ArgumentNode*>(node)) {
+            walk(n->getExpression(), scope, phase);
+        } else if (ReturnStatementNode* n = dynamic_cast<ReturnStatementNode*>(node)) {
+            walk(n->getReturnValue(), scope, phase);
+        } else if (YieldStmtNode* n = dynamic_cast<YieldStmtNode*>(node)) {
+            walk(n->getExpression(), scope, phase);
+        } else if (YieldExprNode* n = dynamic_cast<YieldExprNode*>(node)) {
+            walk(n->getExpression(), scope, phase);
+        } else if (WhileStatementNode* n = dynamic_cast<WhileStatementNode*>(node)) {
+            walk(n->getCondition(), scope, phase);
+            walk(n->getBody(), scope, phase);
+        } else if (ForStatementNode* n = dynamic_cast<ForStatementNode*>(node)) {
+            walk(n->getChanges(), scope, phase);
+            walk(n->getHeader(), scope, phase);
+            walk(n->getBlock(), scope, phase);
+        } else if (ForHeaderNode* n = dynamic_cast<ForHeaderNode*>(node)) {
+            if (phase == Phase::Declare) {
+                bind(scope, n->getIdentifier());
+            } else {
+                n->binding = resolve(scope, n->getIdentifier());
+            }
+        } else if (ChangesNode* n = dynamic_cast<ChangesNode*>(node)) {
+            if (phase == Phase::Resolve && !n->getIdentifier().empty()) {
+                n->binding = resolve(scope, n->getIdentifier());
+            }
+            walk(n->getRange(), scope, phase);
+        } else if (MyFuncNode* n = dynamic_cast<MyFuncNode*>(node)) {
+            if (phase == Phase::Resolve) {
+                n->binding = resolve(scope, n->getIdentifier());
+            }
+        } else if (IfStatementNode* n = dynamic_cast<IfStatementNode*>(node)) {
+            walk(n->getHeader(), scope, phase);
+            walk(n->getBlock(), scope, phase);
+            walk(n->getElifElse(), scope, phase);
+        } else if (IfHeaderNode* n = dynamic_cast<IfHeaderNode*>(node)) {
+            walk(n->getExpression(), scope, phase);
+        } else if (ElifElseNode* n = dynamic_cast<ElifElseNode*>(node)) {
+            walkAll(n->getElifStmts(), scope, phase);
+            walk(n->getElseStmt(), scope, phase);
+        } else if (ElifStmtsNode* n = dynamic_cast<ElifStmtsNode*>(node)) {
+            walkAll(n->getElifStmts(), scope, phase);
+        } else if (ElifStmtNode* n = dynamic_cast<ElifStmtNode*>(node)) {
+            walk(n->getHeader(), scope, phase);
+            walk(n->getBlock(), scope, phase);
+        } else if (ElifHeaderNode* n = dynamic_cast<ElifHeaderNode*>(node)) {
+            walk(n->getExpression(), scope, phase);
+        } else if (ElseStmtNode* n = dynamic_cast<ElseStmtNode*>(node)) {
+            walk(n->getBlock(), scope, phase);
+        } else if (TryStatementNode* n = dynamic_cast<TryStatementNode*>(node)) {
+            walk(n->getBlock(), scope, phase);
+            walk(n->getTryStmts(), scope, phase);
+        } else if (TryStmtsNode* n = dynamic_cast<TryStmtsNode*>(node)) {
+            walkAll(n->getTryStmts(), scope, phase);
+        } else if (ExceptBlockNode* n = dynamic_cast<ExceptBlockNode*>(node)) {
+            if (phase == Phase::Resolve) {
+                resolve(scope, n->getIdentifier());
+            }
+            walk(n->getBlock(), scope, phase);
+        } else if (FinallyBlockNode* n = dynamic_cast<FinallyBlockNode*>(node)) {
+            walk(n->getBlock(), scope, phase);
+        } else if (WithStmtNode* n = dynamic_cast<WithStmtNode*>(node)) {
+            walkAll(n->getWithItems(), scope, phase);
+            walk(n->getBlock(), scope, phase);
+        } else if (WithItemsNode* n = dynamic_cast<WithItemsNode*>(node)) {
+            walkAll(n->getWithItemLists(), scope, phase);
+        } else if (WithItemList* n = dynamic_cast<WithItemList*>(node)) {
+            walkAll(n->getWithItems(), scope, phase);
+        } else if (WithItem* n = dynamic_cast<WithItem*>(node)) {
+            if (phase == Phase::Declare) {
+                bind(scope, n->getIdentifier2());
+            } else {
+                resolve(scope, n->getIdentifier1());
+            }
+        } else if (DecoratorsNode* n = dynamic_cast<DecoratorsNode*>(node)) {
+            walk(n->getNamedExpression(), scope, phase);
+            walkAll(n->getDecorators(), scope, phase);
+        } else if (MatchStmtNode* n = dynamic_cast<MatchStmtNode*>(node)) {
+            walk(n->getExpression(), scope, phase);
+            walk(n->getMatchCases(), scope, phase);
+        } else if (MatchCasesNode* n = dynamic_cast<MatchCasesNode*>(node)) {
+            walkAll(n->getMatchCases(), scope, phase);
+        } else if (MatchCaseNode* n = dynamic_cast<MatchCaseNode*>(node)) {
+            walk(n->getPatternList(), scope, phase);
+            walk(n->getSimpleStmt(), scope, phase);
+        } else if (PatternListNode* n = dynamic_cast<PatternListNode*>(node)) {
+            walkAll(n->getPatterns(), scope, phase);
+        } else if (PatternNode* n = dynamic_cast<PatternNode*>(node)) {
+            // a bare name in a pattern is a capture, it binds the subject
+            PrimaryExpressionNode* capture = dynamic_cast<PrimaryExpressionNode*>(n->getExpression());
+            if (capture && isName(capture->getValue())) {
+                if (phase == Phase::Declare) {
+                    bind(scope, capture->getValue());
+                } else {
+                    capture->binding = resolve(scope, capture->getValue());
+                }
+            } else {
+                walk(n->getExpression(), scope, phase);
+            }
+        } else if (ListPatternNode* n = dynamic_cast<ListPatternNode*>(node)) {
+            walk(n->getPatternList(), scope, phase);
+        } else if (DictPatternNode* n = dynamic_cast<DictPatternNode*>(node)) {
+            walk(n->getEntries(), scope, phase);
+        } else if (DictPatternEntriesNode* n = dynamic_cast<DictPatternEntriesNode*>(node)) {
+            walkAll(n->getEntries(), scope, phase);
+        } else if (DictPatternEntryNode* n = dynamic_cast<DictPatternEntryNode*>(node)) {
+            walk(n->getKey(), scope, phase);
+            walk(n->getValue(), scope, phase);
+        }
+    }
+};
+
+#endif
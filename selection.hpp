@@ -0,0 +1,164 @@
+#ifndef SELECTION_H
+#define SELECTION_H
+
+#include "ast_visitor.hpp"
+#include "hash_cons.hpp"
+#include "python_ast_node.hpp"
+#include "source_map.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// `--select NAME,...` and `--select-lines FIRST-LAST`: the tree of part of
+// a file. A def or class is selected when its name is one of the names, at
+// any depth, methods and nested defs included, or when its lines overlap
+// the range; inside a selected one nothing more is looked for.
+//
+// The parser hands each module-level statement to offer() as soon as it is
+// reduced. Its nodes are the last ones the arena made, so a statement with
+// nothing selected in it is deleted there and then. The tree never holds
+// more than the statement being parsed and the statements with selected
+// parts, and root() gives the printers only the selected defs and classes
+// to walk.
+class Selection {
+public:
+    // NAME[,NAME...]; may be given more than once
+    void addNames(const char* list) {
+        for (const char* p = list; *p;) {
+            const char* comma = strchr(p, ',');
+            size_t length = comma ? (size_t)(comma - p) : strlen(p);
+            if (length) {
+                names.emplace(p, length);
+            }
+            p += length + (comma ? 1 : 0);
+        }
+        enabled = true;
+    }
+
+    // FIRST-LAST or a single line. False if it is neither.
+    bool setLines(const char* range) {
+        char* end;
+        unsigned long long from = strtoull(range, &end, 10);
+        unsigned long long to = from;
+        if (*end == '-') {
+            to = strtoull(end + 1, &end, 10);
+        }
+        if (end == range || *end || from == 0 || to < from) {
+            return false;
+        }
+        firstLine = from;
+        lastLine = to;
+        enabled = true;
+        return true;
+    }
+
+    bool empty() const { return !enabled; }
+
+    // Starts on `source`, parsed into `arena`, which has made no node of it
+    // yet
+    void start(const SourceFile& file, AstArena& arena) {
+        source = &file;
+        mark = arena.size();
+    }
+
+    // A module-level statement the parser just reduced
+    void offer(AstNode* statement) {
+        ++statements;
+        size_t before = picked.size();
+        collect(statement);
+        AstArena* arena = AstArena::current();
+        if (picked.size() > before) {
+            ++kept;
+        } else if (arena) {
+            freed += arena->size() - mark;
+            if (HashCons::current()) {
+                HashCons::current()->forget();
+            }
+            arena->truncate(mark);
+        }
+        mark = arena ? arena->size() : 0;
+    }
+
+    // The selected defs and classes under one Statements node, or null if
+    // there are none. Made in the current arena.
+    AstNode* root() const {
+        if (picked.empty()) {
+            return nullptr;
+        }
+        StatementsNode* selection = new StatementsNode("Statements");
+        for (const AstNode* node : picked) {
+            selection->add(const_cast<AstNode*>(node));     // the parser's own node
+        }
+        return selection;
+    }
+
+    void report(std::ostream& out) const {
+        out << "select: " << picked.size() << " defs and classes from " << kept << " of " << statements
+            << " module-level statements, " << freed << " nodes freed while parsing" << std::endl;
+    }
+
+    static Selection*& current() {
+        static Selection* selection = nullptr;
+        return selection;
+    }
+
+    // Makes a selection current for as long as the Use lives; null selects
+    // everything
+    class Use {
+    public:
+        explicit Use(Selection* selection) : previous(current()) { current() = selection; }
+        ~Use() { current() = previous; }
+
+        Use(const Use&) = delete;
+        Use& operator=(const Use&) = delete;
+
+    private:
+        Selection* previous;
+    };
+
+private:
+    bool enabled = false;
+    std::unordered_set<std::string> names;
+    uint64_t firstLine = 0;     // 0: no range
+    uint64_t lastLine = 0;
+    const SourceFile* source = nullptr;
+    size_t mark = 0;            // arena size before the statement being parsed
+    std::vector<const AstNode*> picked;
+    size_t statements = 0;
+    size_t kept = 0;
+    size_t freed = 0;
+
+    void collect(const AstNode* node) {
+        if (selects(node)) {
+            picked.push_back(node);
+            return;
+        }
+        forEachChild(node, [this](const AstNode* child) { collect(child); });
+    }
+
+    bool selects(const AstNode* node) const {
+        const std::string* name;
+        if (node->kind == NodeKind::Function) {
+            name = &node->name;
+        } else if (node->kind == NodeKind::ClassDefRaw) {
+            name = &static_cast<const ClassDefRawNode*>(node)->getIdentifier();
+        } else {
+            return false;
+        }
+        if (names.count(*name)) {
+            return true;
+        }
+        if (firstLine == 0 || !source) {
+            return false;
+        }
+        uint64_t first = source->line(node->span.start);
+        uint64_t last = node->span.length ? source->line(node->span.end() - 1) : first;
+        return first <= lastLine && last >= firstLine;
+    }
+};
+
+#endif
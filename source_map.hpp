@@ -0,0 +1,213 @@
+#ifndef SOURCE_MAP_H
+#define SOURCE_MAP_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/stat.h>
+
+// Where a token or node sits in its file, as a byte offset and a length.
+// Lines and columns are not kept: SourceFile works them out from the
+// offset when a diagnostic or the tree writer asks. The offset is 64-bit,
+// for streamed files past 4 GiB; the length is 32-bit and saturates, which
+// only a node of such a file can reach (tree_writer.hpp widens a node over
+// its children). Packed to 4-byte alignment the span is 12 bytes, and sits
+// in AstNode beside the kind tag, so a node is no larger than with 32-bit
+// offsets.
+#pragma pack(push, 4)
+struct SourceSpan {
+    uint64_t start = 0;
+    uint32_t length = 0;
+
+    uint64_t end() const { return start + length; }
+
+    // [start, end), the length saturating at 4 GiB
+    static SourceSpan between(uint64_t start, uint64_t end) {
+        return SourceSpan{start, (uint32_t)std::min<uint64_t>(end - start, UINT32_MAX)};
+    }
+};
+#pragma pack(pop)
+
+// 1-based, the column counted in bytes
+struct LineColumn {
+    uint64_t line;
+    uint64_t column;
+};
+
+// One input file and the offsets its lines start at. The scanner only
+// tracks byte offsets; the line table is built by one memchr pass the first
+// time a line is asked for, so a compile that reports nothing never builds
+// it.
+//
+// A file is normally read whole before it is scanned. A large one (from
+// kLargeInput on, or any file under --large-input) is streamed instead: it
+// stays on disk, the scanner reads it through flex's own buffer, which only
+// grows to the longest token, and the lines a diagnostic needs are read
+// back from the file. Streamed files have no text().
+class SourceFile {
+public:
+    // yy_scan_bytes() takes an int length
+    static const uint64_t kLargeInput = (uint64_t)1 << 31;
+
+    SourceFile() {}
+    SourceFile(std::string path, std::string text) : filePath(std::move(path)), contents(std::move(text)) {}
+
+    // `path`, or standard input as "<stdin>" if path is null, read whole
+    // unless it is large or `large` is set. Standard input is always read
+    // whole: it cannot be read again for a diagnostic. False, with errno
+    // set, if it cannot be read.
+    static bool load(const char* path, SourceFile& file, bool large = false) {
+        struct stat st;
+        if (path && stat(path, &st) == 0 && S_ISREG(st.st_mode) && (large || (uint64_t)st.st_size >= kLargeInput)) {
+            file = SourceFile(path, std::string());
+            file.streamedSize = (uint64_t)st.st_size;
+            file.isStreamed = true;
+            return true;
+        }
+        FILE* in = path ? fopen(path, "rb") : stdin;
+        if (!in) {
+            return false;
+        }
+        std::string text;
+        char buffer[1 << 16];
+        for (size_t n; (n = fread(buffer, 1, sizeof(buffer), in)) > 0;) {
+            text.append(buffer, n);
+        }
+        bool ok = !ferror(in);
+        if (path) {
+            fclose(in);
+        }
+        file = SourceFile(path ? path : "<stdin>", std::move(text));
+        return ok;
+    }
+
+    const std::string& path() const { return filePath; }
+    const std::string& text() const { return contents; }
+    bool streamed() const { return isStreamed; }
+    uint64_t size() const { return isStreamed ? streamedSize : contents.size(); }
+
+    // Offsets of the first byte of each line, built on first use
+    const std::vector<uint64_t>& lineStarts() const {
+        if (starts.empty()) {
+            starts.push_back(0);
+            eachBlock([this](const char* data, size_t size, uint64_t offset) {
+                const char* end = data + size;
+                for (const char* p = data; (p = (const char*)memchr(p, '\n', end - p)) != nullptr;) {
+                    starts.push_back(offset + (uint64_t)(++p - data));
+                }
+                return true;
+            });
+        }
+        return starts;
+    }
+
+    LineColumn locate(uint64_t offset) const {
+        const std::vector<uint64_t>& lines = lineStarts();
+        size_t line = std::upper_bound(lines.begin(), lines.end(), offset) - lines.begin();
+        return LineColumn{line, offset - lines[line - 1] + 1};
+    }
+
+    uint64_t line(uint64_t offset) const { return locate(offset).line; }
+
+    // `path:line:column: message`, then the span's first line with the span
+    // underlined, as compilers print them:
+    //     x = (1 +
+    //             ^~
+    void report(std::ostream& out, SourceSpan span, const char* message) const {
+        uint64_t start = std::min(span.start, size());
+        uint64_t first = 0;
+        LineColumn at = where(start, first);
+        out << filePath << ":" << at.line << ":" << at.column << ": " << message << "\n";
+        std::string text = lineText(first);
+        if (text.empty()) {
+            return;             // at the end of the file or on an empty line
+        }
+        out << "    " << text << "\n    ";
+        size_t column = (size_t)std::min<uint64_t>(start - first, text.size());
+        for (size_t i = 0; i < column; ++i) {
+            out << (text[i] == '\t' ? '\t' : ' ');
+        }
+        size_t marked = std::max<size_t>(1, (size_t)std::min<uint64_t>(span.end() - first, text.size()) - column);
+        out << '^' << std::string(marked - 1, '~') << std::endl;
+    }
+
+private:
+    // Longest line a diagnostic shows of a streamed file
+    static const size_t kShownLine = 4096;
+
+    std::string filePath;
+    std::string contents;
+    bool isStreamed = false;
+    uint64_t streamedSize = 0;
+    mutable std::vector<uint64_t> starts;
+
+    // Calls f(data, size, offset) on the text in order, in blocks when it
+    // is streamed, until f returns false
+    template <class F>
+    void eachBlock(F&& f) const {
+        if (!isStreamed) {
+            f(contents.data(), contents.size(), 0);
+            return;
+        }
+        std::unique_ptr<FILE, int (*)(FILE*)> in(fopen(filePath.c_str(), "rb"), fclose);
+        if (!in) {
+            return;
+        }
+        std::vector<char> block(1 << 20);
+        uint64_t offset = 0;
+        for (size_t n; (n = fread(block.data(), 1, block.size(), in.get())) > 0; offset += n) {
+            if (!f(block.data(), n, offset)) {
+                break;
+            }
+        }
+    }
+
+    // The line and column of `offset` and the offset its line starts at.
+    // A streamed file without a line table is counted up to `offset`
+    // rather than given one for a single diagnostic.
+    LineColumn where(uint64_t offset, uint64_t& lineStart) const {
+        if (!isStreamed || !starts.empty()) {
+            LineColumn at = locate(offset);
+            lineStart = starts[at.line - 1];
+            return at;
+        }
+        uint64_t lines = 1;
+        lineStart = 0;
+        eachBlock([&](const char* data, size_t size, uint64_t blockOffset) {
+            size_t upTo = (size_t)std::min<uint64_t>(size, offset - blockOffset);
+            const char* end = data + upTo;
+            for (const char* p = data; (p = (const char*)memchr(p, '\n', end - p)) != nullptr;) {
+                ++lines;
+                lineStart = blockOffset + (uint64_t)(++p - data);
+            }
+            return blockOffset + size < offset;
+        });
+        return LineColumn{lines, offset - lineStart + 1};
+    }
+
+    // The line starting at `first`, without its line break
+    std::string lineText(uint64_t first) const {
+        std::string text;
+        if (!isStreamed) {
+            size_t last = contents.find_first_of("\r\n", first);
+            text = contents.substr(first, (last == std::string::npos ? contents.size() : last) - first);
+            return text;
+        }
+        std::unique_ptr<FILE, int (*)(FILE*)> in(fopen(filePath.c_str(), "rb"), fclose);
+        if (!in || fseeko(in.get(), (off_t)first, SEEK_SET) != 0) {
+            return text;
+        }
+        text.resize(kShownLine);
+        text.resize(fread(&text[0], 1, kShownLine, in.get()));
+        text.resize(std::min(text.size(), text.find_first_of("\r\n")));
+        return text;
+    }
+};
+
+#endif
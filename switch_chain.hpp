@@ -0,0 +1,226 @@
+#ifndef SWITCH_CHAIN_H
+#define SWITCH_CHAIN_H
+
+#include "python_ast_node.hpp"
+#include "type_inference.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// `if x == 1: ... elif x == 7: ... else: ...` where every test compares the
+// same name against a distinct int literal, lowered to one lookup of x. The
+// arm is found through a dense table indexed by x - low when the literals
+// are packed closely enough, through a perfect hash otherwise, so dispatch
+// costs the same for the last arm as for the first. Chains shorter than
+// kMinArms keep their compare-and-branch form, which is as fast there.
+struct SwitchChain {
+    static const size_t kMinArms = 4;
+
+    const PrimaryExpressionNode* subject = nullptr;          // the name in the first test
+    std::vector<std::pair<int64_t, const AstNode*>> arms;    // literal and block, in source order
+    const AstNode* otherwise = nullptr;                      // else block, if any
+    int64_t low = 0;
+    int64_t high = 0;
+
+    // Whether a table of high - low + 1 entries stays within twice the arm count
+    bool dense() const { return (uint64_t)(high - low) < 2 * arms.size(); }
+};
+
+// Index of the arm for a subject value, or -1 for the else branch: a dense
+// table, or a hash-and-displace perfect hash (every literal gets its own
+// slot, found with two multiplicative hashes and one compare)
+class SwitchDispatch {
+public:
+    explicit SwitchDispatch(const SwitchChain& chain) : low(chain.low), isDense(chain.dense()) {
+        if (isDense) {
+            table.assign((size_t)(chain.high - chain.low) + 1, -1);
+            for (size_t i = 0; i < chain.arms.size(); ++i) {
+                table[(size_t)(chain.arms[i].first - low)] = (int)i;
+            }
+            return;
+        }
+        std::vector<int64_t> literals;
+        for (const auto& arm : chain.arms) {
+            literals.push_back(arm.first);
+        }
+        size_t size = 1;
+        while (size < literals.size()) {
+            size <<= 1;
+        }
+        while (!buildHash(literals, size)) {
+            size <<= 1;
+        }
+    }
+
+    int lookup(int64_t value) const {
+        if (isDense) {
+            uint64_t index = (uint64_t)value - (uint64_t)low;
+            return index < table.size() ? table[index] : -1;
+        }
+        uint32_t displacement = displacements[bucketOf(value)];
+        size_t slot = mix((uint64_t)value ^ (displacement * 0x9E3779B97F4A7C15ULL)) & (table.size() - 1);
+        return table[slot] >= 0 && keys[slot] == value ? table[slot] : -1;
+    }
+
+    bool isDenseTable() const { return isDense; }
+    size_t tableSize() const { return table.size(); }
+
+private:
+    int64_t low;
+    bool isDense;
+    std::vector<int> table;                 // arm index by slot, -1 when empty
+    std::vector<int64_t> keys;              // perfect hash: the literal in each slot
+    std::vector<uint32_t> displacements;    // perfect hash: per first-level bucket
+
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xFF51AFD7ED558CCDULL;
+        x ^= x >> 33;
+        x *= 0xC4CEB9FE1A85EC53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    size_t bucketOf(int64_t value) const { return bucketOf(value, displacements.size()); }
+
+    static size_t bucketOf(int64_t value, size_t buckets) { return (mix((uint64_t)value) >> 40) % buckets; }
+
+    // Places the largest buckets first, each with the first displacement
+    // that sends all its literals to free slots. False if some bucket finds
+    // none, and the caller retries with a bigger table.
+    bool buildHash(const std::vector<int64_t>& literals, size_t size) {
+        const uint32_t kMaxDisplacement = 1 << 16;
+        std::vector<std::vector<size_t>> buckets(std::max<size_t>(1, literals.size() / 2));
+        for (size_t i = 0; i < literals.size(); ++i) {
+            buckets[bucketOf(literals[i], buckets.size())].push_back(i);
+        }
+        std::vector<size_t> order(buckets.size());
+        for (size_t b = 0; b < order.size(); ++b) {
+            order[b] = b;
+        }
+        std::stable_sort(order.begin(), order.end(),
+                         [&](size_t a, size_t b) { return buckets[a].size() > buckets[b].size(); });
+
+        table.assign(size, -1);
+        keys.assign(size, 0);
+        displacements.assign(buckets.size(), 0);
+        std::vector<size_t> slots;
+        for (size_t b : order) {
+            bool placed = false;
+            for (uint32_t d = 0; d < kMaxDisplacement && !placed; ++d) {
+                slots.clear();
+                placed = true;
+                for (size_t i : buckets[b]) {
+                    size_t slot = mix((uint64_t)literals[i] ^ (d * 0x9E3779B97F4A7C15ULL)) & (size - 1);
+                    if (table[slot] >= 0 || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+                        placed = false;
+                        break;
+                    }
+                    slots.push_back(slot);
+                }
+                if (placed) {
+                    displacements[b] = d;
+                    for (size_t k = 0; k < slots.size(); ++k) {
+                        table[slots[k]] = (int)buckets[b][k];
+                        keys[slots[k]] = literals[buckets[b][k]];
+                    }
+                }
+            }
+            if (!placed) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// `x == 5`, `5 == x`, `x == -5`: the name and the literal, or false
+inline bool switchTest(const AstNode* test, const PrimaryExpressionNode*& name, int64_t& literal) {
+    const ComparisonNode* cmp = dynamic_cast<const ComparisonNode*>(test);
+    if (!cmp || cmp->getOp() != "==") {
+        return false;
+    }
+    const AstNode* sides[2] = {cmp->getLeft(), cmp->getRight()};
+    for (int i = 0; i < 2; ++i) {
+        const PrimaryExpressionNode* candidate = dynamic_cast<const PrimaryExpressionNode*>(sides[i]);
+        const AstNode* other = sides[1 - i];
+        if (!candidate || isIntLiteral(candidate->getValue()) || candidate->getValue() == "true"
+            || candidate->getValue() == "false" || candidate->getValue() == "None") {
+            continue;
+        }
+        bool negative = false;
+        const ExpressionNode* negated = dynamic_cast<const ExpressionNode*>(other);
+        if (negated && !negated->getLeft() && negated->getOp() == "-") {
+            negative = true;
+            other = negated->getRight();
+        }
+        const PrimaryExpressionNode* constant = dynamic_cast<const PrimaryExpressionNode*>(other);
+        // at most 15 digits, well inside the 53 bits where an int and a float compare exactly
+        if (!constant || !isIntLiteral(constant->getValue()) || constant->getValue().size() > 15) {
+            return false;
+        }
+        name = candidate;
+        literal = std::stoll(constant->getValue());
+        literal = negative ? -literal : literal;
+        return true;
+    }
+    return false;
+}
+
+inline bool collectSwitchArms(const AstNode* node, SwitchChain& out) {
+    if (const ElifStmtsNode* n = dynamic_cast<const ElifStmtsNode*>(node)) {
+        for (const auto& stmt : n->getElifStmts()) {
+            if (!collectSwitchArms(stmt, out)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    const ElifStmtNode* n = dynamic_cast<const ElifStmtNode*>(node);
+    const ElifHeaderNode* header = n ? dynamic_cast<const ElifHeaderNode*>(n->getHeader()) : nullptr;
+    const PrimaryExpressionNode* name = nullptr;
+    int64_t literal = 0;
+    if (!header || !switchTest(header->getExpression(), name, literal)
+        || name->getValue() != out.subject->getValue()) {
+        return false;
+    }
+    out.arms.push_back(std::make_pair(literal, n->getBlock()));
+    return true;
+}
+
+// Lowers an if statement that qualifies. Returns false for any other, which
+// keeps testing its conditions in order.
+inline bool lowerSwitchChain(const IfStatementNode* node, SwitchChain& out) {
+    const IfHeaderNode* header = dynamic_cast<const IfHeaderNode*>(node->getHeader());
+    const ElifElseNode* tail = dynamic_cast<const ElifElseNode*>(node->getElifElse());
+    int64_t literal = 0;
+    if (!header || !tail || !switchTest(header->getExpression(), out.subject, literal)) {
+        return false;
+    }
+    out.arms.assign(1, std::make_pair(literal, node->getBlock()));
+    for (const auto& elif : tail->getElifStmts()) {
+        if (!collectSwitchArms(elif, out)) {
+            return false;
+        }
+    }
+    if (out.arms.size() < SwitchChain::kMinArms) {
+        return false;
+    }
+    std::vector<int64_t> literals;
+    for (const auto& arm : out.arms) {
+        literals.push_back(arm.first);
+    }
+    std::sort(literals.begin(), literals.end());
+    if (std::adjacent_find(literals.begin(), literals.end()) != literals.end()) {
+        return false;
+    }
+    out.low = literals.front();
+    out.high = literals.back();
+    const ElseStmtNode* otherwise = dynamic_cast<const ElseStmtNode*>(tail->getElseStmt());
+    out.otherwise = otherwise ? otherwise->getBlock() : nullptr;
+    return true;
+}
+
+#endif
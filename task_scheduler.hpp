@@ -0,0 +1,160 @@
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool for the passes that handle one function at a time
+// (--jobs N). parallelFor(count, task) deals the indexes out to the
+// workers' deques in contiguous runs; a worker pops from the back of its
+// own deque and, once that is empty, steals from the front of another's,
+// so a worker that drew a few large functions is relieved by the others.
+// The calling thread works too and returns once every task has finished.
+// Tasks only write to their own result slot, and the caller merges the
+// slots in index order, so the outcome does not depend on the schedule.
+class TaskScheduler {
+public:
+    explicit TaskScheduler(unsigned jobs = std::thread::hardware_concurrency()) {
+        jobs = std::max(1u, jobs);
+        for (unsigned i = 0; i < jobs; ++i) {
+            queues.emplace_back(new Queue());
+        }
+        for (unsigned i = 1; i < jobs; ++i) {
+            threads.emplace_back(&TaskScheduler::work, this, i);
+        }
+    }
+
+    ~TaskScheduler() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    unsigned jobs() const { return (unsigned)queues.size(); }
+
+    void parallelFor(size_t count, const std::function<void(size_t)>& task) {
+        if (count == 0) {
+            return;
+        }
+        if (jobs() == 1 || count == 1) {
+            for (size_t i = 0; i < count; ++i) {
+                task(i);
+            }
+            return;
+        }
+        {
+            // a helper that woke too late for the last call may still be
+            // leaving drain(); it must not see these tasks before `current`
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [&] { return busy == 0; });
+            current = &task;
+            remaining = count;
+            size_t per = (count + jobs() - 1) / jobs();
+            for (size_t q = 0; q < jobs(); ++q) {
+                std::lock_guard<std::mutex> queueLock(queues[q]->mutex);
+                for (size_t i = q * per; i < std::min(count, (q + 1) * per); ++i) {
+                    queues[q]->tasks.push_back(i);
+                }
+            }
+            ++generation;
+        }
+        wake.notify_all();
+        drain(0);
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return remaining == 0 && busy == 0; });
+        current = nullptr;
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(size_t)>* current = nullptr;
+    size_t remaining = 0;
+    unsigned busy = 0;              // helper threads inside drain()
+    unsigned long generation = 0;
+    bool stopping = false;
+
+    bool pop(unsigned self, size_t& index) {
+        Queue& own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.tasks.empty()) {
+            return false;
+        }
+        index = own.tasks.back();
+        own.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(unsigned self, size_t& index) {
+        for (unsigned k = 1; k < jobs(); ++k) {
+            Queue& victim = *queues[(self + k) % jobs()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                index = victim.tasks.front();
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Runs tasks until no deque has any left
+    void drain(unsigned self) {
+        size_t index;
+        size_t finished = 0;
+        while (pop(self, index) || steal(self, index)) {
+            (*current)(index);
+            ++finished;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        remaining -= finished;
+        if (remaining == 0) {
+            done.notify_all();
+        }
+    }
+
+    void work(unsigned self) {
+        unsigned long seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            ++busy;
+            lock.unlock();
+            drain(self);
+            lock.lock();
+            --busy;
+            if (busy == 0) {
+                done.notify_all();
+            }
+        }
+    }
+};
+
+#endif
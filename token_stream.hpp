@@ -0,0 +1,160 @@
+#ifndef TOKEN_STREAM_H
+#define TOKEN_STREAM_H
+
+#include "parser.hpp"
+#include "source_map.hpp"
+#include "utf8.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// pycompile.l
+int scanToken();
+SourceSpan tokenSpan(int kind);
+std::string_view tokenText(int kind);
+void restartScanner(const SourceFile& file);
+extern bool scanTrace;
+
+// One token in 12 bytes: its place in the file, the parser's symbol kind
+// for it and, for the tokens with a value, the id of that value: a symbol
+// for IDENTIFIER, a constant (by its text) for NUMBER and STRING.
+struct PackedToken {
+    static const uint32_t kNoId = ~0u;
+
+    uint32_t offset;            // files over 4 GiB are not tokenized
+    uint32_t length : 24;       // longer tokens are cut to 16 MiB
+    uint32_t kind : 8;          // yy::parser::symbol_kind_type
+    uint32_t id;
+};
+
+static_assert(sizeof(PackedToken) == 12, "PackedToken is three words");
+static_assert(yy::parser::YYNTOKENS <= 256, "token kinds no longer fit PackedToken::kind");
+
+// Dense ids for strings. A string seen before costs one hash lookup and no
+// allocation; only a new one is copied.
+class Interner {
+public:
+    uint32_t intern(std::string_view text) {
+        auto found = ids.find(text);
+        if (found != ids.end()) {
+            return found->second;
+        }
+        uint32_t id = (uint32_t)strings.size();
+        strings.emplace_back(text);
+        ids.emplace(strings.back(), id);
+        return id;
+    }
+
+    const std::string& operator[](uint32_t id) const { return strings[id]; }
+    size_t size() const { return strings.size(); }
+
+private:
+    std::deque<std::string> strings;    // never moved, so the keys below stay valid
+    std::unordered_map<std::string_view, uint32_t> ids;
+};
+
+// `compiler --tokens` and the entry point for tools that only need tokens:
+// runs the compiler's own scanner over a file, INDENT, DEDENT and NEWLINE
+// included, without parsing, and returns the tokens packed. A Tokenizer is
+// meant to be kept: each call reuses the token array, and symbols and
+// constants keep their ids from one file to the next, so once the array
+// has grown to the largest file a call allocates only for names it has not
+// seen. The scanner's trace on stdout is off while it runs.
+class Tokenizer {
+public:
+    const std::vector<PackedToken>& tokenize(const SourceFile& file) {
+        typedef yy::parser::token token;
+        Quiet quiet;
+        packed.clear();
+        restartScanner(file);
+        for (int kind; (kind = scanToken()) != 0;) {
+            SourceSpan span = tokenSpan(kind);
+            PackedToken t;
+            t.offset = (uint32_t)span.start;
+            t.length = (uint32_t)std::min<uint64_t>(span.length, (1u << 24) - 1);
+            t.kind = yy::parser::by_kind((yy::parser::token_kind_type)kind).kind();
+            t.id = PackedToken::kNoId;
+            if (kind == token::IDENTIFIER) {
+                t.id = symbolIds.intern(tokenText(kind));
+            } else if (kind == token::NUMBER || kind == token::STRING) {
+                t.id = constantIds.intern(tokenText(kind));
+            }
+            packed.push_back(t);
+        }
+        return packed;
+    }
+
+    const std::vector<PackedToken>& tokens() const { return packed; }
+    const Interner& symbols() const { return symbolIds; }
+    const Interner& constants() const { return constantIds; }
+
+    // As the grammar spells it: IDENTIFIER, INDENT, '(', ...
+    static const char* kindName(const PackedToken& t) {
+        return yy::parser::symbol_name((yy::parser::symbol_kind_type)t.kind);
+    }
+
+    bool isSymbol(const PackedToken& t) const { return t.kind == yy::parser::symbol_kind::S_IDENTIFIER; }
+
+    // The last file's tokens, one per line: line:column, kind and value
+    void print(const SourceFile& file, std::ostream& out) const {
+        for (const PackedToken& t : packed) {
+            LineColumn at = file.locate(t.offset);
+            out << at.line << ":" << at.column << "\t" << kindName(t);
+            if (t.id != PackedToken::kNoId) {
+                out << "\t" << (isSymbol(t) ? symbolIds[t.id] : constantIds[t.id]);
+            }
+            out << "\n";
+        }
+        out.flush();
+    }
+
+    // `--token-bench N`: the best of N tokenizations of `file`, reusing the
+    // tokenizer as a tool would, and of N runs of the UTF-8 check that
+    // restartScanner() makes before each of them (a streamed file is
+    // checked as it is read, inside the tokenization)
+    void bench(const SourceFile& file, int rounds, std::ostream& report) {
+        double fastest = 1e30;
+        for (int i = 0; i < rounds; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            tokenize(file);
+            fastest = std::min(fastest, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        double check = 1e30;
+        for (int i = 0; i < rounds && !file.streamed(); ++i) {
+            auto start = std::chrono::steady_clock::now();
+            volatile size_t bad = utf8Invalid(file.text().data(), file.text().size());
+            (void)bad;
+            check = std::min(check, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        size_t count = packed.size();
+        report << "tokens: " << count << " tokens from " << file.size() << " bytes, best of "
+               << rounds << ": " << fastest * 1e3 << " ms, " << (fastest > 0 ? count / fastest / 1e6 : 0)
+               << " M tokens/s, " << (fastest > 0 ? file.size() / fastest / 1e6 : 0) << " MB/s" << std::endl;
+        report << "tokens: " << symbolIds.size() << " symbols, " << constantIds.size() << " constants, "
+               << sizeof(PackedToken) << " bytes a token" << std::endl;
+        if (!file.streamed()) {
+            report << "tokens: UTF-8 check " << check * 1e3 << " ms, "
+                   << (fastest > 0 ? check / fastest * 100 : 0) << "% of a tokenization" << std::endl;
+        }
+    }
+
+private:
+    // Turns the scanner's trace off, and back on however the scan ends
+    struct Quiet {
+        bool was = scanTrace;
+        Quiet() { scanTrace = false; }
+        ~Quiet() { scanTrace = was; }
+    };
+
+    std::vector<PackedToken> packed;
+    Interner symbolIds;
+    Interner constantIds;
+};
+
+#endif
@@ -0,0 +1,298 @@
+#ifndef TREE_WRITER_H
+#define TREE_WRITER_H
+
+#include "ast_visitor.hpp"
+#include "source_map.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Kinds the writer passes as a node's value when it has none
+struct NoValue {};
+
+// Streams the tree as records for programs that read it back
+// (`--ast-format json|binary`). Nodes are written in post-order, numbered
+// 0, 1, ... in the order written, so a node's children are always written
+// and numbered before it and the root comes last; a reader can build the
+// tree bottom-up without looking ahead. Each record holds the node's kind,
+// its byte span (its own span widened over its children's) and the lines
+// that span covers, looked up in the file's line table, its children's
+// numbers in source order and, for the kinds that carry one, its value: a
+// name, operator, number or range.
+// Nothing is kept beyond the children of the nodes on the current path.
+template <class Format>
+class TreeWriter : public AstVisitor<TreeWriter<Format>> {
+public:
+    TreeWriter(std::ostream& out, const SourceFile& source) : format(out), source(source) {}
+
+    void write(const AstNode* root) {
+        format.begin();
+        if (root) {
+            this->dispatch(root);
+        }
+        format.end();
+    }
+
+    void visitFunction(const FunctionNode* n) { record(n, n->name); }
+    void visitIdentifier(const IdentifierNode* n) { record(n, n->value); }
+    void visitFunctionCall(const FunctionCallNode* n) { record(n, n->getIdentifier()); }
+    void visitComparison(const ComparisonNode* n) { record(n, n->getOp()); }
+    void visitPrimaryExpression(const PrimaryExpressionNode* n) { record(n, n->getValue()); }
+    void visitExpression(const ExpressionNode* n) { record(n, n->getOp()); }
+    void visitCompOp(const CompOpNode* n) { record(n, n->getOp()); }
+    void visitForHeader(const ForHeaderNode* n) { record(n, n->getIdentifier()); }
+    void visitChanges(const ChangesNode* n) { record(n, n->getIdentifier()); }
+    void visitRange(const RangeNode* n) { record(n, n->getValues()); }
+    void visitMyFunc(const MyFuncNode* n) { record(n, n->getIdentifier()); }
+    void visitMyRange(const MyRangeNode* n) { record(n, n->getValues()); }
+    void visitExceptBlock(const ExceptBlockNode* n) { record(n, n->getIdentifier()); }
+    void visitClassDefRaw(const ClassDefRawNode* n) { record(n, n->getIdentifier()); }
+    void visitWithItem(const WithItem* n) { record(n, n->getIdentifier1()); }
+    void visitNumber(const NumberNode* n) { record(n, n->getValue()); }
+    void visitLiteral(const LiteralNode* n) { record(n, n->getValue()); }
+    void visitBinaryExpression(const BinaryExpressionNode* n) { record(n, std::string(1, n->getOp())); }
+    void visitGlobal(const GlobalStmtNode* n) { record(n, names(n->getIdentifier(), n->getParams())); }
+    void visitNonlocal(const NonlocalStmtNode* n) { record(n, names(n->getIdentifier(), n->getParams())); }
+
+    // `from` module (with its leading dots) and names, as in the source
+    void visitImport(const ImportStmtNode* n) {
+        std::string text = n->isFrom() ? std::string(n->getLevel(), '.') + n->getModule() + " import " : "";
+        for (size_t i = 0; i < n->getNames().size(); ++i) {
+            const ImportStmtNode::Name& imported = n->getNames()[i];
+            text += (i ? ", " : "") + imported.name + (imported.alias.empty() ? "" : " as " + imported.alias);
+        }
+        record(n, text);
+    }
+
+    void visitNode(const AstNode* n) { record(n, NoValue()); }
+
+private:
+    struct Written {
+        size_t id;
+        uint64_t start;
+        uint64_t end;
+    };
+
+    Format format;
+    const SourceFile& source;
+    std::vector<Written> pending;       // written nodes whose parent is not yet
+    std::vector<size_t> children;
+    size_t next = 0;
+
+    static std::string names(const std::string& first, const std::vector<std::string>& rest) {
+        std::string text = first;
+        for (const std::string& name : rest) {
+            text += ", " + name;
+        }
+        return text;
+    }
+
+    template <class T>
+    void record(const AstNode* n, const T& value) {
+        size_t mark = pending.size();
+        forEachChild(n, [this](const AstNode* child) { this->dispatch(child); });
+        // an empty span (a node made by an empty rule) says nothing about
+        // where the node's children are
+        uint64_t start = n->span.start;
+        uint64_t end = n->span.end();
+        bool placed = n->span.length != 0;
+        children.clear();
+        for (size_t k = mark; k < pending.size(); ++k) {
+            start = placed ? std::min(start, pending[k].start) : pending[k].start;
+            end = placed ? std::max(end, pending[k].end) : pending[k].end;
+            placed = true;
+            children.push_back(pending[k].id);
+        }
+        pending.resize(mark);
+        size_t id = next++;
+        uint64_t first = source.line(start);
+        uint64_t last = end > start ? source.line(end - 1) : first;
+        format.record(n, id, start, end, first, last, children, value);
+        pending.push_back(Written{id, start, end});
+    }
+};
+
+// Newline-delimited JSON, one object per node:
+//   {"id":4,"kind":"Expression","span":[52,57],"lines":[3,3],"value":"+","children":[2,3]}
+// "span" is the byte offsets of the node's first byte and of the byte after
+// its last. "value" is left out when the node has none, and is a string, a number or,
+// for ranges, an array of numbers.
+class JsonFormat {
+public:
+    explicit JsonFormat(std::ostream& out) : out(out) {}
+
+    void begin() {}
+    void end() { out.flush(); }
+
+    // Each record is built in `line` and written in one call; << on the
+    // stream per field and per number cost more than the formatting itself
+    template <class T>
+    void record(const AstNode* n, size_t id, uint64_t start, uint64_t end, uint64_t first, uint64_t last,
+                const std::vector<size_t>& children, const T& value) {
+        line.assign("{\"id\":");
+        number(id);
+        line += ",\"kind\":\"";
+        line += nodeKindName(n->kind);
+        line += "\",\"span\":[";
+        number(start);
+        line += ',';
+        number(end);
+        line += "],\"lines\":[";
+        number(first);
+        line += ',';
+        number(last);
+        line += ']';
+        write(value);
+        line += ",\"children\":[";
+        for (size_t i = 0; i < children.size(); ++i) {
+            if (i) {
+                line += ',';
+            }
+            number(children[i]);
+        }
+        line += "]}\n";
+        out.write(line.data(), line.size());
+    }
+
+private:
+    std::ostream& out;
+    std::string line;
+
+    template <class N>
+    void number(N value) {
+        char digits[24];
+        line.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+    }
+
+    void write(NoValue) {}
+
+    void write(int value) {
+        line += ",\"value\":";
+        number(value);
+    }
+
+    void write(const std::vector<int>& values) {
+        line += ",\"value\":[";
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (i) {
+                line += ',';
+            }
+            number(values[i]);
+        }
+        line += ']';
+    }
+
+    void write(const std::string& value) {
+        static const char hex[] = "0123456789abcdef";
+        line += ",\"value\":\"";
+        for (unsigned char c : value) {
+            if (c == '"' || c == '\\') {
+                line += '\\';
+                line += (char)c;
+            } else if (c < 0x20) {
+                line += "\\u00";
+                line += hex[c >> 4];
+                line += hex[c & 15];
+            } else {
+                line += (char)c;
+            }
+        }
+        line += '"';
+    }
+};
+
+// Length-prefixed binary records. Every integer is an unsigned LEB128
+// varint; signed ones are zigzag-encoded first. The stream starts with
+// "PYAST", a version byte (2) and the kind table: a count, then each kind's
+// name as a length and bytes, so that kind codes need not match between
+// builds. Each node is then
+//   length      bytes in the rest of the record
+//   kind        one byte, an index into the kind table
+//   start, end - start
+//               the byte span, as in the JSON records
+//   first line, last line - first line
+//   count       children, then each child as (this id - child id)
+//   value       tag byte: 0 none; 1 string: length, bytes; 2 int: zigzag;
+//               3 ints: count, zigzag each
+// A node's id is its position in the stream, from 0.
+class BinaryFormat {
+public:
+    explicit BinaryFormat(std::ostream& out) : out(out) {}
+
+    void begin() {
+        out.write("PYAST\2", 6);
+        std::string table;
+        varint(table, nodeKindCount);
+        for (size_t k = 0; k < nodeKindCount; ++k) {
+            bytes(table, nodeKindName((NodeKind)k));
+        }
+        out.write(table.data(), table.size());
+    }
+
+    void end() { out.flush(); }
+
+    template <class T>
+    void record(const AstNode* n, size_t id, uint64_t start, uint64_t end, uint64_t first, uint64_t last,
+                const std::vector<size_t>& children, const T& value) {
+        body.clear();
+        body.push_back((char)n->kind);
+        varint(body, start);
+        varint(body, end - start);
+        varint(body, first);
+        varint(body, last - first);
+        varint(body, children.size());
+        for (size_t child : children) {
+            varint(body, id - child);
+        }
+        write(value);
+        head.clear();
+        varint(head, body.size());
+        out.write(head.data(), head.size());
+        out.write(body.data(), body.size());
+    }
+
+private:
+    std::ostream& out;
+    std::string head;
+    std::string body;           // the record being built, reused
+
+    static uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+
+    static void varint(std::string& to, uint64_t v) {
+        while (v >= 0x80) {
+            to.push_back((char)(v | 0x80));
+            v >>= 7;
+        }
+        to.push_back((char)v);
+    }
+
+    static void bytes(std::string& to, const std::string& s) {
+        varint(to, s.size());
+        to += s;
+    }
+
+    void write(NoValue) { body.push_back(0); }
+
+    void write(const std::string& value) {
+        body.push_back(1);
+        bytes(body, value);
+    }
+
+    void write(int value) {
+        body.push_back(2);
+        varint(body, zigzag(value));
+    }
+
+    void write(const std::vector<int>& values) {
+        body.push_back(3);
+        varint(body, values.size());
+        for (int v : values) {
+            varint(body, zigzag(v));
+        }
+    }
+};
+
+#endif
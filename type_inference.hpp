@@ -0,0 +1,456 @@
+#ifndef TYPE_INFERENCE_H
+#define TYPE_INFERENCE_H
+
+#include "scope_analysis.hpp"
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Static type of a value. Types only move up: Unknown (nothing stored yet)
+// -> Int (every store is an integer) -> Dynamic (anything else).
+enum class ValueType { Unknown, Int, Dynamic };
+
+inline ValueType joinTypes(ValueType a, ValueType b) {
+    return a > b ? a : b;
+}
+
+// A plain decimal integer that fits in 64 bits, the only integers the
+// backends lower; hex, octal, binary and underscored ones are not
+inline bool isIntLiteral(const std::string& value) {
+    if (value.empty()) {
+        return false;
+    }
+    for (char c : value) {
+        if (!std::isdigit((unsigned char)c)) {
+            return false;
+        }
+    }
+    int64_t parsed;
+    return std::from_chars(value.data(), value.data() + value.size(), parsed).ec == std::errc();
+}
+
+// 3.14, 10., .001, 1e100, 3.14_15: a number with a fraction or an exponent
+inline bool isFloatLiteral(const std::string& value) {
+    if (value.empty() || !(std::isdigit((unsigned char)value[0]) || value[0] == '.')) {
+        return false;
+    }
+    if (value.size() > 1 && value[0] == '0' && std::strchr("xXoObB", value[1])) {
+        return false;
+    }
+    return value.find_first_of(".eE") != std::string::npos;
+}
+
+// A number's spelling without the underscores Python allows between digits
+inline std::string literalDigits(const std::string& value) {
+    std::string digits;
+    for (char c : value) {
+        if (c != '_') {
+            digits += c;
+        }
+    }
+    return digits;
+}
+
+// Proves which slots, parameters and function results only ever hold
+// integers. Runs after ScopeAnalyzer: stores are joined into the slot the
+// target's NameBinding points at, arguments of calls to module-level functions
+// are joined into the callee's parameter slots, and the walk is repeated until
+// nothing changes. Whatever is still Unknown at the end becomes Dynamic.
+class TypeInference {
+public:
+    TypeInference(const SymbolTable& symbols) : symbols(symbols) {}
+
+    void run(AstNode* root) {
+        finished = false;
+        collectFunctions(root);
+        do {
+            changed = false;
+            walk(root, symbols.module(), nullptr);
+        } while (changed);
+        for (auto& entry : slots) {
+            for (auto& type : entry.second) {
+                if (type == ValueType::Unknown) {
+                    type = ValueType::Dynamic;
+                }
+            }
+        }
+        for (auto& entry : returns) {
+            if (entry.second == ValueType::Unknown) {
+                entry.second = ValueType::Dynamic;
+            }
+        }
+        finished = true;
+    }
+
+    ValueType slotType(const Scope* scope, int slot) const {
+        auto it = slots.find(scope);
+        if (!scope || slot < 0) {
+            return ValueType::Dynamic;
+        }
+        if (it == slots.end() || slot >= (int)it->second.size()) {
+            return finished ? ValueType::Dynamic : ValueType::Unknown;
+        }
+        return it->second[slot];
+    }
+
+    ValueType bindingType(const NameBinding& binding, const Scope* scope) const {
+        if (binding.kind == NameKind::Local) {
+            return slotType(scope, binding.slot);
+        }
+        if (binding.kind == NameKind::Global) {
+            if (moduleFunctions.count(binding.slot)) {
+                return ValueType::Dynamic;
+            }
+            return slotType(symbols.module(), binding.slot);
+        }
+        return ValueType::Dynamic;
+    }
+
+    ValueType returnType(const FunctionNode* function) const {
+        auto it = returns.find(function);
+        if (it == returns.end()) {
+            return finished ? ValueType::Dynamic : ValueType::Unknown;
+        }
+        return it->second;
+    }
+
+    // The module-level def a call resolves to, when its name is never rebound
+    const FunctionNode* calledFunction(const FunctionCallNode* call) const {
+        if (call->binding.kind != NameKind::Global) {
+            return nullptr;
+        }
+        auto it = moduleFunctions.find(call->binding.slot);
+        return it == moduleFunctions.end() ? nullptr : it->second;
+    }
+
+    // True for a module-level def whose name is bound to nothing else
+    bool isDirectFunction(const FunctionNode* function) const {
+        auto it = moduleFunctions.find(function->binding.slot);
+        return function->binding.kind == NameKind::Global
+            && it != moduleFunctions.end() && it->second == function;
+    }
+
+    ValueType typeOf(const AstNode* expr, const Scope* scope) const {
+        if (const PrimaryExpressionNode* n = dynamic_cast<const PrimaryExpressionNode*>(expr)) {
+            if (isIntLiteral(n->getValue())) {
+                return ValueType::Int;
+            }
+            return bindingType(n->binding, scope);
+        }
+        if (const FunctionCallNode* n = dynamic_cast<const FunctionCallNode*>(expr)) {
+            const FunctionNode* callee = calledFunction(n);
+            return callee ? returnType(callee) : ValueType::Dynamic;
+        }
+        if (const ExpressionNode* n = dynamic_cast<const ExpressionNode*>(expr)) {
+            const std::string& op = n->getOp();
+            if (!n->getLeft()) {
+                return op == "-" ? typeOf(n->getRight(), scope) : ValueType::Dynamic;
+            }
+            if (op == "+" || op == "-" || op == "*") {
+                return joinTypes(typeOf(n->getLeft(), scope), typeOf(n->getRight(), scope));
+            }
+            return ValueType::Dynamic;
+        }
+        return ValueType::Dynamic;
+    }
+
+private:
+    const SymbolTable& symbols;
+    std::unordered_map<const Scope*, std::vector<ValueType>> slots;
+    std::unordered_map<const FunctionNode*, ValueType> returns;
+    std::unordered_map<int, const FunctionNode*> moduleFunctions;   // module slot -> def
+    std::unordered_set<int> reboundSlots;
+    bool changed = false;
+    bool finished = true;   // no more joins: anything without evidence is Dynamic
+
+    void join(const Scope* scope, int slot, ValueType type) {
+        if (!scope || slot < 0) {
+            return;
+        }
+        std::vector<ValueType>& types = slots[scope];
+        if ((int)types.size() < scope->numSlots) {
+            types.resize(scope->numSlots, ValueType::Unknown);
+        }
+        ValueType joined = joinTypes(types[slot], type);
+        if (joined != types[slot]) {
+            types[slot] = joined;
+            changed = true;
+        }
+    }
+
+    void joinReturn(const FunctionNode* function, ValueType type) {
+        if (!function) {
+            return;
+        }
+        ValueType& current = returns[function];
+        ValueType joined = joinTypes(current, type);
+        if (joined != current) {
+            current = joined;
+            changed = true;
+        }
+    }
+
+    void store(const NameBinding& binding, const Scope* scope, ValueType type) {
+        if (binding.kind == NameKind::Local) {
+            join(scope, binding.slot, type);
+        } else if (binding.kind == NameKind::Global) {
+            if (moduleFunctions.count(binding.slot)) {
+                reboundSlots.insert(binding.slot);
+            }
+            join(symbols.module(), binding.slot, type);
+        } else if (binding.kind == NameKind::Nonlocal || binding.kind == NameKind::Free) {
+            join(enclosingFunction(scope, binding.depth), binding.slot, type);
+        }
+    }
+
+    static const Scope* enclosingFunction(const Scope* scope, int depth) {
+        while (scope && depth > 0) {
+            scope = scope->parent;
+            if (scope && scope->kind == ScopeKind::Function) {
+                --depth;
+            }
+        }
+        return scope;
+    }
+
+    // Parameters of functions reached other than by a direct call can hold anything
+    void widenParams(const FunctionNode* function) {
+        const Scope* scope = symbols.scopeOf(function);
+        if (!scope) {
+            return;
+        }
+        for (const auto& sym : scope->symbols) {
+            if (sym.isParam) {
+                join(scope, sym.slot, ValueType::Dynamic);
+            }
+        }
+    }
+
+    static bool endsWithReturn(const AstNode* body) {
+        const StatementsNode* stmts = dynamic_cast<const StatementsNode*>(body);
+        return stmts && !stmts->getStatements().empty()
+            && dynamic_cast<const ReturnStatementNode*>(stmts->getStatements().back());
+    }
+
+    void collectFunctions(AstNode* root) {
+        StatementsNode* module = dynamic_cast<StatementsNode*>(root);
+        if (module) {
+            for (const auto& stmt : module->getStatements()) {
+                if (FunctionNode* function = dynamic_cast<FunctionNode*>(stmt)) {
+                    int slot = function->binding.slot;
+                    if (function->binding.kind != NameKind::Global || moduleFunctions.count(slot)) {
+                        reboundSlots.insert(slot);
+                    }
+                    moduleFunctions[slot] = function;
+                } else if (assignmentStatement* assign = dynamic_cast<assignmentStatement*>(stmt)) {
+                    if (IdentifierNode* target = dynamic_cast<IdentifierNode*>(assign->getTarget())) {
+                        reboundSlots.insert(target->binding.slot);
+                    }
+                }
+            }
+        }
+        // any other store to a def's slot (e.g. through `global`) is found by the walk
+        walkFunctionsForRebinding(root);
+        for (int slot : reboundSlots) {
+            auto it = moduleFunctions.find(slot);
+            if (it != moduleFunctions.end()) {
+                widenParams(it->second);
+                moduleFunctions.erase(it);
+            }
+        }
+    }
+
+    void walkFunctionsForRebinding(AstNode* root) {
+        do {
+            changed = false;
+            walk(root, symbols.module(), nullptr);
+        } while (changed);
+        slots.clear();
+        returns.clear();
+    }
+
+    void walkArguments(const FunctionCallNode* call, const Scope* scope, const FunctionNode* current) {
+        std::vector<AstNode*> args;
+        for (const auto& arg : call->getArguments()) {
+            if (ArgumentsNode* list = dynamic_cast<ArgumentsNode*>(arg)) {
+                args.insert(args.end(), list->getArguments().begin(), list->getArguments().end());
+            } else {
+                args.push_back(arg);
+            }
+        }
+        for (const auto& arg : args) {
+            walk(arg, scope, current);
+        }
+
+        const FunctionNode* callee = calledFunction(call);
+        if (!callee) {
+            return;
+        }
+        const Scope* calleeScope = symbols.scopeOf(callee);
+        std::vector<int> params;
+        if (Args* formal = dynamic_cast<Args*>(callee->getArgs())) {
+            for (const auto& param : formal->getArgs()) {
+                IdentifierNode* id = dynamic_cast<IdentifierNode*>(param);
+                params.push_back(id ? id->binding.slot : -1);
+            }
+        }
+        if (params.size() != args.size()) {
+            widenParams(callee);
+            return;
+        }
+        for (size_t i = 0; i < args.size(); ++i) {
+            join(calleeScope, params[i], typeOf(args[i], scope));
+        }
+    }
+
+    void walk(AstNode* node, const Scope* scope, const FunctionNode* current) {
+        if (!node) {
+            return;
+        }
+        if (StatementsNode* n = dynamic_cast<StatementsNode*>(node)) {
+            for (const auto& stmt : n->getStatements()) {
+                walk(stmt, scope, current);
+            }
+        } else if (BlockNode* n = dynamic_cast<BlockNode*>(node)) {
+            for (const auto& stmt : n->getStatements()) {
+                walk(stmt, scope, current);
+            }
+        } else if (FunctionNode* n = dynamic_cast<FunctionNode*>(node)) {
+            if (scope != symbols.module() || !moduleFunctions.count(n->binding.slot)
+                || moduleFunctions.at(n->binding.slot) != n) {
+                widenParams(n);
+            }
+            if (!endsWithReturn(n->getBody())) {
+                joinReturn(n, ValueType::Dynamic);     // falls off the end with None
+            }
+            walk(n->getBody(), symbols.scopeOf(n), n);
+        } else if (ClassDefNode* n = dynamic_cast<ClassDefNode*>(node)) {
+            walk(n->getClassDefRaw(), scope, current);
+        } else if (ClassDefRawNode* n = dynamic_cast<ClassDefRawNode*>(node)) {
+            walk(n->getBlock(), symbols.scopeOf(n), nullptr);
+        } else if (assignmentStatement* n = dynamic_cast<assignmentStatement*>(node)) {
+            walk(n->getValue(), scope, current);
+            if (IdentifierNode* target = dynamic_cast<IdentifierNode*>(n->getTarget())) {
+                store(target->binding, scope, typeOf(n->getValue(), scope));
+            }
+        } else if (ReturnStatementNode* n = dynamic_cast<ReturnStatementNode*>(node)) {
+            walk(n->getReturnValue(), scope, current);
+            joinReturn(current, n->getReturnValue() ? typeOf(n->getReturnValue(), scope) : ValueType::Dynamic);
+        } else if (YieldStmtNode* n = dynamic_cast<YieldStmtNode*>(node)) {
+            walk(n->getExpression(), scope, current);
+            joinReturn(current, ValueType::Dynamic);
+        } else if (FunctionCallNode* n = dynamic_cast<FunctionCallNode*>(node)) {
+            walkArguments(n, scope, current);
+        } else if (PrimaryExpressionNode* n = dynamic_cast<PrimaryExpressionNode*>(node)) {
+            // a def used as a value escapes: its parameters are no longer known
+            if (n->binding.kind == NameKind::Global && moduleFunctions.count(n->binding.slot)) {
+                reboundSlots.insert(n->binding.slot);
+            }
+        } else if (ExpressionNode* n = dynamic_cast<ExpressionNode*>(node)) {
+            walk(n->getLeft(), scope, current);
+            walk(n->getRight(), scope, current);
+        } else if (NegatedExpressionNode* n = dynamic_cast<NegatedExpressionNode*>(node)) {
+            walk(n->getOperand(), scope, current);
+        } else if (ComparisonNode* n = dynamic_cast<ComparisonNode*>(node)) {
+            walk(n->getLeft(), scope, current);
+            walk(n->getRight(), scope, current);
+        } else if (WhileStatementNode* n = dynamic_cast<WhileStatementNode*>(node)) {
+            walk(n->getCondition(), scope, current);
+            walk(n->getBody(), scope, current);
+        } else if (ForStatementNode* n = dynamic_cast<ForStatementNode*>(node)) {
+            ChangesNode* changes = dynamic_cast<ChangesNode*>(n->getChanges());
+            bool overRange = changes && dynamic_cast<MyRangeNode*>(changes->getRange());
+            if (ForHeaderNode* header = dynamic_cast<ForHeaderNode*>(n->getHeader())) {
+                store(header->binding, scope, overRange ? ValueType::Int : ValueType::Dynamic);
+            }
+            walk(n->getBlock(), scope, current);
+        } else if (IfStatementNode* n = dynamic_cast<IfStatementNode*>(node)) {
+            walk(n->getHeader(), scope, current);
+            walk(n->getBlock(), scope, current);
+            walk(n->getElifElse(), scope, current);
+        } else if (IfHeaderNode* n = dynamic_cast<IfHeaderNode*>(node)) {
+            walk(n->getExpression(), scope, current);
+        } else if (ElifElseNode* n = dynamic_cast<ElifElseNode*>(node)) {
+            for (const auto& stmt : n->getElifStmts()) {
+                walk(stmt, scope, current);
+            }
+            walk(n->getElseStmt(), scope, current);
+        } else if (ElifStmtsNode* n = dynamic_cast<ElifStmtsNode*>(node)) {
+            for (const auto& stmt : n->getElifStmts()) {
+                walk(stmt, scope, current);
+            }
+        } else if (ElifStmtNode* n = dynamic_cast<ElifStmtNode*>(node)) {
+            walk(n->getHeader(), scope, current);
+            walk(n->getBlock(), scope, current);
+        } else if (ElifHeaderNode* n = dynamic_cast<ElifHeaderNode*>(node)) {
+            walk(n->getExpression(), scope, current);
+        } else if (ElseStmtNode* n = dynamic_cast<ElseStmtNode*>(node)) {
+            walk(n->getBlock(), scope, current);
+        } else if (TryStatementNode* n = dynamic_cast<TryStatementNode*>(node)) {
+            walk(n->getBlock(), scope, current);
+            walk(n->getTryStmts(), scope, current);
+        } else if (TryStmtsNode* n = dynamic_cast<TryStmtsNode*>(node)) {
+            for (const auto& stmt : n->getTryStmts()) {
+                walk(stmt, scope, current);
+            }
+        } else if (ExceptBlockNode* n = dynamic_cast<ExceptBlockNode*>(node)) {
+            walk(n->getBlock(), scope, current);
+        } else if (FinallyBlockNode* n = dynamic_cast<FinallyBlockNode*>(node)) {
+            walk(n->getBlock(), scope, current);
+        } else if (WithStmtNode* n = dynamic_cast<WithStmtNode*>(node)) {
+            for (const auto& item : n->getWithItems()) {
+                walk(item, scope, current);
+            }
+            walk(n->getBlock(), scope, current);
+        } else if (WithItemsNode* n = dynamic_cast<WithItemsNode*>(node)) {
+            for (const auto& list : n->getWithItemLists()) {
+                walk(list, scope, current);
+            }
+        } else if (WithItemList* n = dynamic_cast<WithItemList*>(node)) {
+            for (const auto& item : n->getWithItems()) {
+                walk(item, scope, current);
+            }
+        } else if (WithItem* n = dynamic_cast<WithItem*>(node)) {
+            const Symbol* target = scope ? scope->lookup(n->getIdentifier2()) : nullptr;
+            if (target && target->kind == NameKind::Local) {
+                join(scope, target->slot, ValueType::Dynamic);
+            }
+        } else if (MatchStmtNode* n = dynamic_cast<MatchStmtNode*>(node)) {
+            walk(n->getExpression(), scope, current);
+            walk(n->getMatchCases(), scope, current);
+        } else if (MatchCasesNode* n = dynamic_cast<MatchCasesNode*>(node)) {
+            for (const auto& matchCase : n->getMatchCases()) {
+                walk(matchCase, scope, current);
+            }
+        } else if (MatchCaseNode* n = dynamic_cast<MatchCaseNode*>(node)) {
+            walk(n->getPatternList(), scope, current);
+            walk(n->getSimpleStmt(), scope, current);
+        } else if (PatternListNode* n = dynamic_cast<PatternListNode*>(node)) {
+            for (const auto& pattern : n->getPatterns()) {
+                walk(pattern, scope, current);
+            }
+        } else if (PatternNode* n = dynamic_cast<PatternNode*>(node)) {
+            // a capture pattern stores the (untyped) match subject
+            if (PrimaryExpressionNode* capture = dynamic_cast<PrimaryExpressionNode*>(n->getExpression())) {
+                store(capture->binding, scope, ValueType::Dynamic);
+            }
+        } else if (ListPatternNode* n = dynamic_cast<ListPatternNode*>(node)) {
+            walk(n->getPatternList(), scope, current);
+        } else if (DictPatternNode* n = dynamic_cast<DictPatternNode*>(node)) {
+            walk(n->getEntries(), scope, current);
+        } else if (DictPatternEntriesNode* n = dynamic_cast<DictPatternEntriesNode*>(node)) {
+            for (const auto& entry : n->getEntries()) {
+                walk(entry, scope, current);
+            }
+        } else if (DictPatternEntryNode* n = dynamic_cast<DictPatternEntryNode*>(node)) {
+            walk(n->getValue(), scope, current);
+        }
+    }
+};
+
+#endif
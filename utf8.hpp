@@ -0,0 +1,212 @@
+#ifndef UTF8_H
+#define UTF8_H
+
+#include "unicode_xid.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Source text is UTF-8 (PEP 3120). The whole input is validated once
+// before it is scanned, or block by block as it is read when it is
+// streamed, so the scanner's rules can take any byte >= 0x80
+// as part of a well-formed character; only identifiers need to know which
+// character it is.
+
+// For a lead byte c >= 0x80: the length of the character it starts and the
+// range its second byte must be in (RFC 3629: no overlong forms, no
+// surrogates, nothing past U+10FFFF). False if c cannot start one.
+inline bool utf8Lead(unsigned char c, size_t& n, unsigned char& low, unsigned char& high) {
+    low = 0x80;
+    high = 0xBF;
+    if (c >= 0xC2 && c <= 0xDF) {
+        n = 2;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        n = 3;
+        low = c == 0xE0 ? 0xA0 : 0x80;
+        high = c == 0xED ? 0x9F : 0xBF;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        n = 4;
+        low = c == 0xF0 ? 0x90 : 0x80;
+        high = c == 0xF4 ? 0x8F : 0xBF;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Whether p[0, left) is well-formed as far as it goes: the start of a
+// character that would be complete with more bytes. p[0] is >= 0x80.
+inline bool utf8Prefix(const unsigned char* p, size_t left) {
+    size_t n;
+    unsigned char low, high;
+    if (!utf8Lead(p[0], n, low, high) || left >= n) {
+        return false;
+    }
+    for (size_t k = 1; k < left; ++k) {
+        if (p[k] < (k == 1 ? low : 0x80) || p[k] > (k == 1 ? high : 0xBF)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Length of the well-formed UTF-8 character at p, or 0 if it is not one.
+// p[0] is >= 0x80.
+inline size_t utf8Sequence(const unsigned char* p, size_t left) {
+    size_t n;
+    unsigned char low, high;
+    if (!utf8Lead(p[0], n, low, high) || left < n || p[1] < low || p[1] > high) {
+        return 0;
+    }
+    for (size_t k = 2; k < n; ++k) {
+        if (p[k] < 0x80 || p[k] > 0xBF) {
+            return 0;
+        }
+    }
+    return n;
+}
+
+// Offset of the first byte of data[0, size) that is not part of well-formed
+// UTF-8, or size if all of it is. Sources are nearly all ASCII, so the loop
+// skips 64 bytes at a time while no byte has its high bit set, with SSE2
+// where there is SSE2 and a word at a time elsewhere, and checks the
+// characters around a non-ASCII byte one by one.
+inline size_t utf8Invalid(const char* data, size_t size) {
+    const unsigned char* p = (const unsigned char*)data;
+    size_t i = 0;
+    while (i < size) {
+        while (i + 64 <= size) {
+#if defined(__SSE2__)
+            __m128i a = _mm_loadu_si128((const __m128i*)(p + i));
+            __m128i b = _mm_loadu_si128((const __m128i*)(p + i + 16));
+            __m128i c = _mm_loadu_si128((const __m128i*)(p + i + 32));
+            __m128i d = _mm_loadu_si128((const __m128i*)(p + i + 48));
+            if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d))) != 0) {
+                break;
+            }
+#else
+            uint64_t words[8];
+            memcpy(words, p + i, sizeof(words));
+            uint64_t any = 0;
+            for (uint64_t w : words) {
+                any |= w;
+            }
+            if (any & 0x8080808080808080ull) {
+                break;
+            }
+#endif
+            i += 64;
+        }
+        // the rest of the block, or the tail of the input
+        size_t stop = std::min(size, i + 64);
+        while (i < stop) {
+            if (p[i] < 0x80) {
+                ++i;
+                continue;
+            }
+            size_t n = utf8Sequence(p + i, size - i);
+            if (n == 0) {
+                return i;
+            }
+            i += n;
+        }
+    }
+    return size;
+}
+
+// utf8Invalid() over input that arrives in blocks, as a streamed file is
+// read: a character cut by the end of one block is finished by the start
+// of the next.
+class Utf8Stream {
+public:
+    // Checks data[0, size), the input's bytes from `offset` on. False, with
+    // the offset of the character that is not well-formed in `bad`, if
+    // there is one.
+    bool check(const char* data, size_t size, uint64_t offset, uint64_t& bad) {
+        const unsigned char* p = (const unsigned char*)data;
+        size_t i = 0;
+        while (held > 0 && i < size) {
+            tail[held++] = p[i++];
+            if (utf8Sequence(tail, held) != 0) {
+                held = 0;
+            } else if (!utf8Prefix(tail, held)) {
+                bad = tailOffset;
+                return false;
+            }
+        }
+        size_t at = i + utf8Invalid(data + i, size - i);
+        if (at == size) {
+            return true;
+        }
+        if (utf8Prefix(p + at, size - at)) {
+            held = size - at;
+            memcpy(tail, p + at, held);
+            tailOffset = offset + at;
+            return true;
+        }
+        bad = offset + at;
+        return false;
+    }
+
+    // At the end of the input: false if it ends inside a character
+    bool finish(uint64_t& bad) const {
+        bad = tailOffset;
+        return held == 0;
+    }
+
+private:
+    unsigned char tail[4];
+    size_t held = 0;
+    uint64_t tailOffset = 0;
+};
+
+// The code point of the well-formed character at p, and its length in n
+inline uint32_t utf8Decode(const unsigned char* p, size_t& n) {
+    if (p[0] < 0x80) {
+        n = 1;
+        return p[0];
+    }
+    if (p[0] < 0xE0) {
+        n = 2;
+        return (uint32_t)(p[0] & 0x1F) << 6 | (p[1] & 0x3F);
+    }
+    if (p[0] < 0xF0) {
+        n = 3;
+        return (uint32_t)(p[0] & 0x0F) << 12 | (uint32_t)(p[1] & 0x3F) << 6 | (p[2] & 0x3F);
+    }
+    n = 4;
+    return (uint32_t)(p[0] & 0x07) << 18 | (uint32_t)(p[1] & 0x3F) << 12 | (uint32_t)(p[2] & 0x3F) << 6 | (p[3] & 0x3F);
+}
+
+template <size_t N>
+inline bool inRanges(const uint32_t (&ranges)[N][2], uint32_t cp) {
+    const uint32_t (*found)[2] = std::upper_bound(ranges, ranges + N, cp,
+        [](uint32_t c, const uint32_t (&range)[2]) { return c < range[0]; });
+    return found != ranges && cp <= found[-1][1];
+}
+
+// Offset of the first character of the well-formed text[0, size) that
+// keeps it from being a PEP 3131 identifier, or size if it is one. ASCII
+// is checked inline; other characters against the XID tables.
+inline size_t identifierInvalid(const char* text, size_t size) {
+    const unsigned char* p = (const unsigned char*)text;
+    for (size_t i = 0, n; i < size; i += n) {
+        uint32_t cp = utf8Decode(p + i, n);
+        bool ok;
+        if (cp < 0x80) {
+            ok = cp == '_' || (cp | 0x20) - 'a' < 26 || (i > 0 && cp - '0' < 10);
+        } else {
+            ok = i == 0 ? inRanges(xidStart, cp) : inRanges(xidContinue, cp);
+        }
+        if (!ok) {
+            return i;
+        }
+    }
+    return size;
+}
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef VALUE_H
+#define VALUE_H
+
+#include "python_ast_node.hpp"
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+// Header of every heap cell. Cells are plain memory managed by Heap (gc.hpp):
+// they are moved out of the nursery with memcpy and never run destructors.
+struct HeapObject {
+    enum class Kind : uint8_t { Int, Generator };
+
+    Kind kind;
+    bool old = false;               // promoted out of the nursery
+    bool marked = false;            // reached by the current major collection
+    uint32_t size = 0;              // bytes, header included
+    HeapObject* forward = nullptr;  // new address once a minor collection copied it
+
+    explicit HeapObject(Kind kind) : kind(kind) {}
+};
+
+// An int outside the 48-bit range a Value holds inline
+struct IntObject : HeapObject {
+    int64_t value;
+
+    explicit IntObject(int64_t value) : HeapObject(Kind::Int), value(value) {}
+};
+
+// 64-bit NaN-boxed runtime value. A double is stored as its own bits (NaNs
+// are canonicalized to one quiet NaN); everything else hides in the negative
+// quiet-NaN space, with the top 16 bits as tag and the low 48 as payload:
+//
+//     0xFFF9  int, two's complement in 48 bits
+//     0xFFFA  None / False / True / unbound
+//     0xFFFB  def (const FunctionNode*)
+//     0xFFFC  heap object (HeapObject*)
+//
+// Ints, floats, bools and None therefore never live on the heap; only ints
+// that need more than 48 bits are boxed in an IntObject. Generators are the
+// other heap objects.
+class Value {
+public:
+    Value() : bits(kUnbound) {}
+
+    static Value none() { return Value(kNone); }
+    static Value boolean(bool b) { return Value(b ? kTrue : kFalse); }
+    static Value def(const FunctionNode* function) { return Value(kFunctionTag | (uint64_t)(uintptr_t)function); }
+    static Value object(HeapObject* object) { return Value(kObjectTag | (uint64_t)(uintptr_t)object); }
+
+    static Value real(double d) {
+        uint64_t raw = kCanonicalNaN;
+        if (d == d) {
+            std::memcpy(&raw, &d, sizeof(raw));
+        }
+        return Value(raw);
+    }
+
+    static bool fitsInline(int64_t i) { return i >= -(INT64_C(1) << 47) && i < (INT64_C(1) << 47); }
+    static Value smallInt(int64_t i) { return Value(kIntTag | ((uint64_t)i & kPayloadMask)); }
+
+    bool isDouble() const { return bits < kIntTag; }
+    bool isSmallInt() const { return (bits & kTagMask) == kIntTag; }
+    bool isBool() const { return bits == kTrue || bits == kFalse; }
+    bool isNone() const { return bits == kNone; }
+    bool isUnbound() const { return bits == kUnbound; }
+    bool isFunction() const { return (bits & kTagMask) == kFunctionTag; }
+    bool isObject() const { return (bits & kTagMask) == kObjectTag; }
+    bool isInt() const { return isSmallInt() || (isObject() && asObject()->kind == HeapObject::Kind::Int); }
+    bool isNumber() const { return isDouble() || isInt() || isBool(); }
+
+    double asDouble() const {
+        double d;
+        std::memcpy(&d, &bits, sizeof(d));
+        return d;
+    }
+
+    // The int value of an int or bool
+    int64_t asInt() const {
+        if (isSmallInt()) {
+            return (int64_t)(bits << 16) >> 16;
+        }
+        if (isBool()) {
+            return bits == kTrue;
+        }
+        return static_cast<IntObject*>(asObject())->value;
+    }
+
+    double toDouble() const { return isDouble() ? asDouble() : (double)asInt(); }
+
+    const FunctionNode* asFunction() const { return (const FunctionNode*)(uintptr_t)(bits & kPayloadMask); }
+    HeapObject* asObject() const { return (HeapObject*)(uintptr_t)(bits & kPayloadMask); }
+
+    uint64_t raw() const { return bits; }
+
+private:
+    static const uint64_t kTagMask = 0xFFFF000000000000ULL;
+    static const uint64_t kPayloadMask = 0x0000FFFFFFFFFFFFULL;
+    static const uint64_t kIntTag = 0xFFF9000000000000ULL;
+    static const uint64_t kSingletonTag = 0xFFFA000000000000ULL;
+    static const uint64_t kFunctionTag = 0xFFFB000000000000ULL;
+    static const uint64_t kObjectTag = 0xFFFC000000000000ULL;
+    static const uint64_t kNone = kSingletonTag | 0;
+    static const uint64_t kFalse = kSingletonTag | 1;
+    static const uint64_t kTrue = kSingletonTag | 2;
+    static const uint64_t kUnbound = kSingletonTag | 3;
+    static const uint64_t kCanonicalNaN = 0x7FF8000000000000ULL;
+
+    uint64_t bits;
+
+    explicit Value(uint64_t bits) : bits(bits) {}
+};
+
+static_assert(sizeof(Value) == 8, "Value must stay one machine word");
+
+struct GeneratorCode;   // generator_compiler.hpp
+
+// A generator: its position in the def's state machine and, inline after
+// the header, its whole frame (GeneratorCode::frameSize() Values), so
+// neither creating the frame nor resuming it allocates anything else.
+// Allocated straight into the old generation, since the interpreter keeps
+// the address of a running generator.
+struct GeneratorObject : HeapObject {
+    const GeneratorCode* code;
+    int32_t pc = 0;                 // next op to run, -1 once the generator is exhausted
+    bool running = false;
+    bool remembered = false;        // on the interpreter's list of old objects holding nursery values
+    uint32_t count;                 // Values in the frame
+
+    GeneratorObject(const GeneratorCode* code, uint32_t count)
+        : HeapObject(Kind::Generator), code(code), count(count) {
+        for (uint32_t i = 0; i < count; ++i) {
+            new (&slots()[i]) Value();
+        }
+    }
+
+    Value* slots() { return reinterpret_cast<Value*>(this + 1); }
+};
+
+#endif
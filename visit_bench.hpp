@@ -0,0 +1,108 @@
+#ifndef VISIT_BENCH_H
+#define VISIT_BENCH_H
+
+#include "dot_printer.hpp"
+#include "tree_writer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <streambuf>
+
+// Times full-tree walks of a parsed program for `--visit-bench N`: a node
+// count through AstVisitor against the same count through a dynamic_cast
+// chain, which is how the passes written before it find a node's class, and
+// the DOT printer and the JSON and binary writers (--ast-format) into a
+// discarding stream, with the bytes each writes. Each figure is the best of
+// N walks, per walk.
+class VisitBench {
+public:
+    void run(const AstNode* root, const SourceFile& source, int rounds, std::ostream& report) {
+        size_t nodes = 0;
+        double castTime = best(rounds, [&] { nodes = castCount(root); });
+        size_t visited = 0;
+        double visitorTime = best(rounds, [&] { visited = Counter().count(root); });
+        Discard discard;
+        std::ostream sink(&discard);
+        double printTime = best(rounds, [&] { DotPrinter(sink).dispatch(root); });
+        size_t printBytes = written(discard, [&] { DotPrinter(sink).dispatch(root); });
+        double jsonTime = best(rounds, [&] { TreeWriter<JsonFormat>(sink, source).write(root); });
+        size_t jsonBytes = written(discard, [&] { TreeWriter<JsonFormat>(sink, source).write(root); });
+        double binaryTime = best(rounds, [&] { TreeWriter<BinaryFormat>(sink, source).write(root); });
+        size_t binaryBytes = written(discard, [&] { TreeWriter<BinaryFormat>(sink, source).write(root); });
+
+        report << "visit: " << nodes << " nodes, best of " << rounds << std::endl;
+        line(report, "dynamic_cast", castTime, nodes);
+        line(report, "AstVisitor", visitorTime, visited);
+        line(report, "DotPrinter", printTime, visited, printBytes);
+        line(report, "json", jsonTime, visited, jsonBytes);
+        line(report, "binary", binaryTime, visited, binaryBytes);
+    }
+
+private:
+    struct Counter : AstVisitor<Counter> {
+        size_t nodes = 0;
+
+        size_t count(const AstNode* root) {
+            dispatch(root);
+            return nodes;
+        }
+
+        void visitNode(const AstNode* node) {
+            ++nodes;
+            AstVisitor<Counter>::visitNode(node);
+        }
+    };
+
+    struct Discard : std::streambuf {
+        size_t bytes = 0;
+        int overflow(int c) override {
+            ++bytes;
+            return c;
+        }
+        std::streamsize xsputn(const char*, std::streamsize n) override {
+            bytes += n;
+            return n;
+        }
+    };
+
+    template <class F>
+    static size_t written(Discard& discard, F&& walk) {
+        discard.bytes = 0;
+        walk();
+        return discard.bytes;
+    }
+
+    static size_t castCount(const AstNode* node) {
+        size_t nodes = 1;
+#define X(kind, type)                                                          \
+        if (dynamic_cast<const type*>(node)) {                                 \
+            forEachChild(node, [&](const AstNode* child) { nodes += castCount(child); }); \
+            return nodes;                                                      \
+        }
+        PYTHON_AST_NODES(X)
+#undef X
+        return nodes;
+    }
+
+    template <class F>
+    static double best(int rounds, F&& walk) {
+        double fastest = 1e30;
+        for (int i = 0; i < rounds; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            walk();
+            fastest = std::min(fastest, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return fastest;
+    }
+
+    static void line(std::ostream& report, const char* name, double seconds, size_t nodes, size_t bytes = 0) {
+        report << "visit: " << name << " " << seconds * 1e6 << " us/walk, "
+               << (nodes ? seconds * 1e9 / nodes : 0) << " ns/node";
+        if (bytes) {
+            report << ", " << bytes << " bytes";
+        }
+        report << std::endl;
+    }
+};
+
+#endif